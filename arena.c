@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "arena.h"
+
+#define ARENA_CHUNK_SIZE 4096
+// Enough for the pointers and doubles stored in AST nodes
+#define ARENA_ALIGNMENT 8
+
+// Function to round a size up to the arena alignment
+static size_t align_size(size_t size) {
+  return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+// Function to add a chunk with room for at least size bytes in front of the arena
+static struct arena_chunk *add_chunk(struct arena *arena, size_t size) {
+  size_t chunk_size = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+  struct arena_chunk *chunk = malloc(sizeof(struct arena_chunk) + chunk_size);
+
+  if(!chunk) {
+    return NULL;
+  }
+
+  chunk->next = arena->head;
+  chunk->used = 0;
+  chunk->size = chunk_size;
+  arena->head = chunk;
+
+  return chunk;
+}
+
+// Function to create an empty arena
+struct arena *arena_create() {
+  struct arena *arena = malloc(sizeof(struct arena));
+
+  if(!arena) {
+    return NULL;
+  }
+
+  arena->head = NULL;
+  return arena;
+}
+
+// Function to allocate size bytes from an arena, NULL if out of space
+void *arena_alloc(struct arena *arena, size_t size) {
+  struct arena_chunk *chunk = arena->head;
+  void *memory = NULL;
+
+  size = align_size(size);
+
+  if(!chunk || chunk->size - chunk->used < size) {
+    chunk = add_chunk(arena, size);
+
+    if(!chunk) {
+      return NULL;
+    }
+  }
+
+  memory = chunk->data + chunk->used;
+  chunk->used += size;
+
+  return memory;
+}
+
+// Function to make room for size bytes in an arena before they are allocated, returns 0 if out of space
+int arena_reserve(struct arena *arena, size_t size) {
+  return add_chunk(arena, align_size(size)) != NULL;
+}
+
+// Function to release every allocation of an arena but keep it for reuse
+void arena_reset(struct arena *arena) {
+  struct arena_chunk *chunk = arena->head;
+  struct arena_chunk *next = NULL;
+
+  if(!chunk) {
+    return;
+  }
+
+  // Keep the newest chunk so the next parse unit does not hit malloc
+  next = chunk->next;
+  chunk->next = NULL;
+  chunk->used = 0;
+
+  while(next) {
+    chunk = next;
+    next = chunk->next;
+    free(chunk);
+  }
+}
+
+// Function to free an arena and every allocation in it
+void arena_free(struct arena *arena) {
+  struct arena_chunk *chunk = NULL;
+
+  if(!arena) {
+    return;
+  }
+
+  while(arena->head) {
+    chunk = arena->head;
+    arena->head = chunk->next;
+    free(chunk);
+  }
+
+  free(arena);
+}
@@ -0,0 +1,34 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Structure for a block of arena memory, allocations are bumped from data
+struct arena_chunk {
+  struct arena_chunk *next;
+  size_t used;
+  size_t size;
+  char data[];
+};
+
+// Structure for a bump pointer arena, everything in it is freed at once
+struct arena {
+  struct arena_chunk *head;
+};
+
+// Function to create an empty arena
+struct arena *arena_create();
+
+// Function to allocate size bytes from an arena, NULL if out of space
+void *arena_alloc(struct arena *arena, size_t size);
+
+// Function to make room for size bytes in an arena before they are allocated, returns 0 if out of space
+int arena_reserve(struct arena *arena, size_t size);
+
+// Function to release every allocation of an arena but keep it for reuse
+void arena_reset(struct arena *arena);
+
+// Function to free an arena and every allocation in it
+void arena_free(struct arena *arena);
+
+#endif
@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "backend.h"
+
+struct gpio_backend *gpio_backend = &sim_backend;
+
+// Backends that can be picked by name, the record backend wraps one of them
+static struct gpio_backend *backends[] = {
+#ifdef LEARNPI_PIGPIO
+  &pigpio_backend,
+#endif
+  &sim_backend,
+};
+
+// Backend the record backend passes the calls on to
+struct gpio_backend *recorded_backend = &sim_backend;
+
+// Function to find a backend that drives the gpios itself by name, NULL if there is none
+static struct gpio_backend *find_backend(const char *name) {
+  for(size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+    if(!strcmp(backends[i]->name, name)) {
+      return backends[i];
+    }
+  }
+
+  return NULL;
+}
+
+// Function to pick the backend by name, record or record:<backend> records the calls to another backend.
+// Returns 0 if OK, -1 if there is no backend of that name.
+int select_backend(const char *name) {
+  struct gpio_backend *backend = NULL;
+
+  if(!strcmp(name, "record")) {
+    name = "record:sim";
+  }
+
+  if(!strncmp(name, "record:", 7)) {
+    backend = find_backend(name + 7);
+
+    if(!backend) {
+      return -1;
+    }
+
+    // Scripts see the clock and the inputs of the recorded backend
+    recorded_backend = backend;
+    record_backend.simulated = backend->simulated;
+    gpio_backend = &record_backend;
+    return 0;
+  }
+
+  backend = find_backend(name);
+
+  if(!backend) {
+    return -1;
+  }
+
+  gpio_backend = backend;
+  return 0;
+}
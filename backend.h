@@ -0,0 +1,72 @@
+#ifndef BACKEND_H
+#define BACKEND_H
+
+#include <stdint.h>
+
+// Modes, pulls and errors of the backends, the values pigpio uses so the interpreter builds without it
+#define PI_INPUT 0
+#define PI_OUTPUT 1
+#define PI_PUD_UP 2
+#define PI_BAD_USER_GPIO -2
+#define PI_BAD_GPIO -3
+#define PI_BAD_LEVEL -5
+#define PI_BAD_PULSEWIDTH -7
+
+struct pattern_playback;
+
+// Function called on every level change of a watched gpio, with the tick of the change in microseconds
+typedef void (*gpio_alert_function)(int gpio, int level, uint32_t tick);
+
+// Structure for the operations every way of driving the gpios provides, pigpio on the Pi, the simulation anywhere else.
+// Operations that can fail return 0 if OK or a pigpio error code.
+struct gpio_backend {
+  const char *name;
+  int simulated;                   // inputs are made up and every script runs on a virtual clock
+  int (*init)();
+  void (*terminate)();
+  int (*set_mode)(unsigned gpio, unsigned mode);
+  int (*set_pull)(unsigned gpio, unsigned pull);
+  int (*write)(unsigned gpio, unsigned level);
+  int (*write_banks)(const uint32_t *set, const uint32_t *clear);   // bank 1 is gpio 0-31 and bank 2 is gpio 32-53
+  int (*read)(unsigned gpio);
+  int (*servo)(unsigned gpio, unsigned width_us);                     // 0 stops the pulses
+  int (*watch)(unsigned gpio, gpio_alert_function alert);
+  uint64_t (*now_us)();                                               // time since the current script started
+  void (*sleep_until)(uint64_t deadline_us);                          // on the clock of now_us
+  void (*delay)(unsigned us);                                         // short wait of a device, off the script clock
+  uint32_t (*tick)();
+  int (*wave_send)(struct pattern_playback *pattern);                 // returns the wave id or a pigpio error
+  int (*wave_busy)();
+  void (*wave_stop)();
+  void (*wave_delete)(int wave_id);
+};
+
+#ifdef LEARNPI_PIGPIO
+extern struct gpio_backend pigpio_backend;
+#endif
+extern struct gpio_backend sim_backend;
+extern struct gpio_backend record_backend;
+
+// Backend every device goes through, the simulation until --backend picks another one
+extern struct gpio_backend *gpio_backend;
+
+// Backend the record backend passes the calls on to
+extern struct gpio_backend *recorded_backend;
+
+// Function to pick the backend by name, record or record:<backend> records the calls to another backend.
+// Returns 0 if OK, -1 if there is no backend of that name.
+int select_backend(const char *name);
+
+// Function to find the first simulated edge to level after a virtual time
+uint64_t next_simulated_edge(int level, uint64_t after_us);
+
+// Function to find the first simulated button press after a virtual time, keypads of the simulation are pressed then too
+uint64_t next_simulated_press(uint64_t after_us);
+
+// Function to tell if a button is pressed at a virtual time of the simulation
+int simulated_level(uint64_t now_us);
+
+// File the record backend writes the calls to, set with --record-file
+extern const char *record_path;
+
+#endif
@@ -0,0 +1,472 @@
+#ifdef LEARNPI_BENCH
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/resource.h>
+
+#include "learnpi.h"
+#include "functions.h"
+#include "heap.h"
+#include "cache.h"
+#include "gpio_batch.h"
+#include "backend.h"
+
+// Nanoseconds every benchmark runs for at least, its iterations double until it does
+#define BENCH_MIN_NS (100L * 1000 * 1000)
+
+// Most results a run reports, one per benchmark and example script
+#define MAX_RESULTS 128
+
+// Names looked up by the lookup benchmarks, and by each interpreter of the miss benchmark
+#define LOOKUP_NAMES 4096
+
+// Gpio the backend benchmarks write and read, it is not set to an output so nothing attached to it moves
+#define BENCH_GPIO 21
+
+// Structure for the measurements of one benchmark
+struct benchmark_result {
+  char name[64];
+  long iterations;
+  double ns_per_op;
+  double allocations_per_op;
+  long peak_rss_kib;
+};
+
+// Function to run a benchmark for a number of iterations, returns the nanoseconds they took
+typedef long (*benchmark_body)(long iterations, void *argument);
+
+static struct benchmark_result results[MAX_RESULTS];
+static int result_count = 0;
+
+// Heap allocations of the interpreters the benchmarks freed already
+static size_t retired_allocations = 0;
+
+static char lookup_names[LOOKUP_NAMES][16];
+
+// Function to read a monotonic clock in nanoseconds
+static long now_ns() {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+// Function to read the peak resident set size of the process in KiB
+static long peak_rss_kib() {
+  struct rusage usage;
+
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// Function to count the heap allocations of every interpreter the benchmarks used so far
+static size_t heap_allocations() {
+  return retired_allocations + current_context->heap.allocations;
+}
+
+// Function to switch to a new interpreter, returns the one to switch back to
+static struct interpreter_context *enter_interpreter() {
+  struct interpreter_context *outer = current_context;
+
+  current_context = create_interpreter_context();
+  return outer;
+}
+
+// Function to free the current interpreter and switch back to the outer one
+static void leave_interpreter(struct interpreter_context *outer) {
+  retired_allocations += current_context->heap.allocations;
+  free_interpreter_context(current_context);
+  current_context = outer;
+}
+
+// Function to time a benchmark with enough iterations and record its result
+static void run_benchmark(const char *name, benchmark_body body, void *argument) {
+  struct benchmark_result *result = NULL;
+  size_t allocations = 0;
+  long iterations = 1;
+  long elapsed = 0;
+
+  if(result_count == MAX_RESULTS) {
+    fprintf(stderr, "Too many benchmarks, %s is not run.\n", name);
+    return;
+  }
+
+  for(;;) {
+    allocations = heap_allocations();
+    elapsed = body(iterations, argument);
+    allocations = heap_allocations() - allocations;
+
+    // Values the benchmark left behind are not charged to the next one
+    heap_collect();
+
+    if(elapsed >= BENCH_MIN_NS || iterations >= (1L << 40)) {
+      break;
+    }
+
+    iterations *= 2;
+  }
+
+  result = &results[result_count++];
+  snprintf(result->name, sizeof(result->name), "%s", name);
+  result->iterations = iterations;
+  result->ns_per_op = (double)elapsed / iterations;
+  result->allocations_per_op = (double)allocations / iterations;
+  result->peak_rss_kib = peak_rss_kib();
+
+  fprintf(stderr, "%-40s %12ld %12.1f ns/op %10.3f allocs/op %8ld KiB\n",
+    result->name, result->iterations, result->ns_per_op, result->allocations_per_op, result->peak_rss_kib);
+}
+
+// Function to look up names that are in the symbol table
+static long bench_lookup_hit(long iterations, void *argument) {
+  long start = now_ns();
+
+  for(long i = 0; i < iterations; i++) {
+    lookup(lookup_names[i % LOOKUP_NAMES]);
+  }
+
+  return now_ns() - start;
+}
+
+// Function to look up names that are not in the symbol table yet, on a new interpreter for every batch
+static long bench_lookup_miss(long iterations, void *argument) {
+  struct interpreter_context *outer = NULL;
+  long elapsed = 0;
+  long start = 0;
+  long done = 0;
+  long batch = 0;
+
+  while(done < iterations) {
+    batch = iterations - done < LOOKUP_NAMES ? iterations - done : LOOKUP_NAMES;
+    outer = enter_interpreter();
+
+    start = now_ns();
+    for(long i = 0; i < batch; i++) {
+      lookup(lookup_names[i]);
+    }
+    elapsed += now_ns() - start;
+
+    leave_interpreter(outer);
+    done += batch;
+  }
+
+  return elapsed;
+}
+
+// Function to evaluate a syntax tree, which resolves, compiles and runs it
+static long bench_eval(long iterations, void *argument) {
+  struct ast *tree = argument;
+  long start = now_ns();
+
+  for(long i = 0; i < iterations; i++) {
+    eval(tree);
+  }
+
+  return now_ns() - start;
+}
+
+// Structure for the operands of a value operation benchmark
+struct operation_benchmark {
+  struct val (*operation)(struct val first, struct val second);
+  struct val first;
+  struct val second;
+};
+
+// Function to apply sum() or calculate_equals() to the same two values
+static long bench_operation(long iterations, void *argument) {
+  struct operation_benchmark *benchmark = argument;
+  long start = now_ns();
+
+  for(long i = 0; i < iterations; i++) {
+    benchmark->operation(benchmark->first, benchmark->second);
+
+    // Concatenations allocate, collect the way a running loop does
+    if((i & 4095) == 4095) {
+      heap_safe_point();
+    }
+  }
+
+  return now_ns() - start;
+}
+
+// Function to build a string by appending one character at a time
+static long bench_concatenation(long iterations, void *argument) {
+  struct val piece = create_string_value("x");
+  struct val text = create_string_value("");
+  long start = now_ns();
+
+  for(long i = 0; i < iterations; i++) {
+    text = sum(text, piece);
+  }
+
+  return now_ns() - start;
+}
+
+// Function to parse and run a script from memory in a new interpreter, returns the nanoseconds it took
+static long run_source(const char *source) {
+  struct interpreter_context *outer = enter_interpreter();
+  FILE *f = fmemopen((void *)source, strlen(source), "r");
+  long start = now_ns();
+
+  if(!f || yylex_init(&current_context->scanner)) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  current_context->is_file = 1;
+  yyset_in(f, current_context->scanner);
+  yyparse(current_context->scanner);
+  closefile();
+  run_units();
+
+  start = now_ns() - start;
+  leave_interpreter(outer);
+  return start;
+}
+
+// Function to time the calls of a user function, the loop around them is timed on its own and left out
+static long bench_user_call(long iterations, void *argument) {
+  char source[256];
+  long with_calls = 0;
+  long without_calls = 0;
+
+  snprintf(source, sizeof(source),
+    "fun add(a, b) = {\n  a + b\n}\ni = 0\nwhile(i < %ld) {\n  s = add(i, 1)\n  i = i + 1\n}\n", iterations);
+  with_calls = run_source(source);
+
+  snprintf(source, sizeof(source),
+    "fun add(a, b) = {\n  a + b\n}\ni = 0\nwhile(i < %ld) {\n  s = i + 1\n  i = i + 1\n}\n", iterations);
+  without_calls = run_source(source);
+
+  return with_calls > without_calls ? with_calls - without_calls : 0;
+}
+
+// Function to parse and run a script file the way the interpreter does, with its output discarded
+static long bench_script(long iterations, void *argument) {
+  char *path = argument;
+  struct interpreter_context *outer = NULL;
+  int null_output = open("/dev/null", O_WRONLY);
+  int saved_stdout = dup(STDOUT_FILENO);
+  int saved_stderr = dup(STDERR_FILENO);
+  long elapsed = 0;
+  long start = 0;
+
+  fflush(stdout);
+  fflush(stderr);
+  dup2(null_output, STDOUT_FILENO);
+  dup2(null_output, STDERR_FILENO);
+
+  for(long i = 0; i < iterations; i++) {
+    outer = enter_interpreter();
+    start = now_ns();
+
+    if(newfile(path) > 0) {
+      yyparse(current_context->scanner);
+      closefile();
+      run_units();
+      flush_gpio_writes();
+    }
+
+    elapsed += now_ns() - start;
+    leave_interpreter(outer);
+  }
+
+  fflush(stdout);
+  fflush(stderr);
+  dup2(saved_stdout, STDOUT_FILENO);
+  dup2(saved_stderr, STDERR_FILENO);
+  close(saved_stdout);
+  close(saved_stderr);
+  close(null_output);
+
+  return elapsed;
+}
+
+// Function to keep only the scripts of a directory
+static int is_script(const struct dirent *entry) {
+  return checkSuffix(entry->d_name, ".learnpi");
+}
+
+// Function to benchmark every script of a directory
+static void bench_scripts(const char *directory) {
+  struct dirent **entries = NULL;
+  char path[512];
+  char name[64];
+  int count = scandir(directory, &entries, is_script, alphasort);
+
+  if(count < 0) {
+    perror(directory);
+    return;
+  }
+
+  for(int i = 0; i < count; i++) {
+    snprintf(path, sizeof(path), "%s/%s", directory, entries[i]->d_name);
+    snprintf(name, sizeof(name), "script/%.48s", entries[i]->d_name);
+    run_benchmark(name, bench_script, path);
+    free(entries[i]);
+  }
+
+  free(entries);
+}
+
+// Function to write a gpio through the backend, the cost of one call of a device
+static long bench_backend_write(long iterations, void *argument) {
+  struct gpio_backend *backend = argument;
+  long start = now_ns();
+
+  for(long i = 0; i < iterations; i++) {
+    backend->write(BENCH_GPIO, i & 1);
+  }
+
+  return now_ns() - start;
+}
+
+// Function to read a gpio through the backend
+static long bench_backend_read(long iterations, void *argument) {
+  struct gpio_backend *backend = argument;
+  long start = now_ns();
+
+  for(long i = 0; i < iterations; i++) {
+    backend->read(BENCH_GPIO);
+  }
+
+  return now_ns() - start;
+}
+
+// Function to benchmark the calls of every backend that is built and starts, pigpio only starts on a Pi with root
+static void bench_backends() {
+  const char *names[] = { "sim", "record", "pigpio" };
+  char name[64];
+
+  record_path = "learnpi-bench.record";
+
+  for(size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+    if(select_backend(names[i]) != 0 || gpio_backend->init() != 0) {
+      fprintf(stderr, "Backend %s is not built or does not start, it is not benchmarked.\n", names[i]);
+      continue;
+    }
+
+    snprintf(name, sizeof(name), "backend/%s/write", names[i]);
+    run_benchmark(name, bench_backend_write, gpio_backend);
+    snprintf(name, sizeof(name), "backend/%s/read", names[i]);
+    run_benchmark(name, bench_backend_read, gpio_backend);
+
+    gpio_backend->terminate();
+  }
+
+  // The scripts run on the simulation, like the interpreter without --backend
+  remove(record_path);
+  select_backend("sim");
+}
+
+// Function to build the tree of (a + b) * (c - d) / e
+static struct ast *arithmetic_tree() {
+  return new_ast_with_children('/',
+    new_ast_with_children('*',
+      new_ast_with_children('+', new_reference("a"), new_reference("b")),
+      new_ast_with_children('-', new_reference("c"), new_reference("d"))),
+    new_reference("e"));
+}
+
+// Function to set the variables the arithmetic tree reads
+static void set_arithmetic_variables(struct val first, struct val second) {
+  lookup("a")->value = first;
+  lookup("b")->value = second;
+  lookup("c")->value = first;
+  lookup("d")->value = second;
+  lookup("e")->value = first;
+}
+
+// Function to print the results as JSON, one object per benchmark
+static void print_json(FILE *output) {
+  fprintf(output, "{\n  \"benchmarks\": [\n");
+
+  for(int i = 0; i < result_count; i++) {
+    fprintf(output, "    {\"name\": \"%s\", \"iterations\": %ld, \"ns_per_op\": %.2f, \"allocations_per_op\": %.4f, \"peak_rss_kib\": %ld}%s\n",
+      results[i].name, results[i].iterations, results[i].ns_per_op, results[i].allocations_per_op, results[i].peak_rss_kib,
+      i + 1 < result_count ? "," : "");
+  }
+
+  fprintf(output, "  ]\n}\n");
+}
+
+int main(int argc, char **argv) {
+  const char *directory = argc > 1 ? argv[1] : "examples";
+  struct val integer = create_empty_value();
+  struct val decimal = create_empty_value();
+  struct val text = create_empty_value();
+  struct val other_text = create_empty_value();
+  struct ast *integer_tree = NULL;
+  struct ast *decimal_tree = NULL;
+
+  // Every run parses its script, so the numbers do not depend on an earlier run
+  cache_disabled = 1;
+  current_context = create_interpreter_context();
+
+  for(int i = 0; i < LOOKUP_NAMES; i++) {
+    snprintf(lookup_names[i], sizeof(lookup_names[i]), "name%d", i);
+  }
+
+  integer = create_integer_value(7);
+  decimal = create_decimal_value(2.5);
+  text = create_string_value("learnpi");
+  other_text = create_string_value("learnpi!");
+
+  fprintf(stderr, "%-40s %12s %18s %20s %12s\n", "benchmark", "iterations", "time", "allocations", "peak RSS");
+
+  run_benchmark("lookup/miss", bench_lookup_miss, NULL);
+  for(int i = 0; i < LOOKUP_NAMES; i++) {
+    lookup(lookup_names[i]);
+  }
+  run_benchmark("lookup/hit", bench_lookup_hit, NULL);
+
+  integer_tree = arithmetic_tree();
+  decimal_tree = arithmetic_tree();
+  set_arithmetic_variables(integer, create_integer_value(3));
+  run_benchmark("eval/arithmetic_integer", bench_eval, integer_tree);
+  set_arithmetic_variables(decimal, create_decimal_value(0.5));
+  run_benchmark("eval/arithmetic_decimal", bench_eval, decimal_tree);
+
+  struct operation_benchmark operations[] = {
+    { sum, integer, integer },
+    { sum, integer, decimal },
+    { sum, decimal, integer },
+    { sum, decimal, decimal },
+    { sum, text, other_text },
+    { calculate_equals, integer, integer },
+    { calculate_equals, integer, decimal },
+    { calculate_equals, decimal, integer },
+    { calculate_equals, decimal, decimal },
+    { calculate_equals, text, other_text },
+  };
+  const char *operation_names[] = {
+    "sum/integer_integer", "sum/integer_decimal", "sum/decimal_integer", "sum/decimal_decimal", "sum/string_string",
+    "equals/integer_integer", "equals/integer_decimal", "equals/decimal_integer", "equals/decimal_decimal", "equals/string_string",
+  };
+
+  for(size_t i = 0; i < sizeof(operations) / sizeof(operations[0]); i++) {
+    run_benchmark(operation_names[i], bench_operation, &operations[i]);
+  }
+
+  run_benchmark("string/append_character", bench_concatenation, NULL);
+  run_benchmark("call/user_function", bench_user_call, NULL);
+  bench_backends();
+  bench_scripts(directory);
+
+  print_json(stdout);
+
+  free_interpreter_context(current_context);
+  current_context = NULL;
+  return 0;
+}
+
+#endif
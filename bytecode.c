@@ -0,0 +1,957 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "learnpi.h"
+#include "functions.h"
+#include "bytecode.h"
+#include "trace.h"
+#include "gpio_batch.h"
+#include "profile.h"
+
+// Use computed goto for the dispatch loop where the compiler supports it
+#if defined(__GNUC__) && !defined(LEARNPI_NO_COMPUTED_GOTO)
+#define VM_COMPUTED_GOTO 1
+#endif
+
+// Structure to keep track of the compilation state
+struct compiler {
+  struct program *program;
+  int depth;
+  int line;             // line of the last OP_LINE emitted
+};
+
+static void compile_node(struct compiler *compiler, struct ast *abstract_syntax_tree);
+
+// Function to append an instruction, keeping track of the stack depth
+static int emit(struct compiler *compiler, int opcode, int a, int b, int stack_effect) {
+  struct program *program = compiler->program;
+
+  if(program->code_count == program->code_capacity) {
+    program->code_capacity = program->code_capacity ? program->code_capacity * 2 : 32;
+    program->code = realloc(program->code, program->code_capacity * sizeof(struct instruction));
+
+    if(!program->code) {
+      yyerror("out of space");
+      exit(0);
+    }
+  }
+
+  program->code[program->code_count].opcode = opcode;
+  program->code[program->code_count].a = a;
+  program->code[program->code_count].b = b;
+
+  compiler->depth += stack_effect;
+  if(compiler->depth > program->max_stack) {
+    program->max_stack = compiler->depth;
+  }
+
+  return program->code_count++;
+}
+
+// Function to point a jump instruction to the next instruction
+static void patch_jump(struct compiler *compiler, int jump) {
+  compiler->program->code[jump].a = compiler->program->code_count;
+}
+
+// Function to add a value to the constant pool
+static int add_constant(struct program *program, struct val value) {
+  if(program->constant_count == program->constant_capacity) {
+    program->constant_capacity = program->constant_capacity ? program->constant_capacity * 2 : 8;
+    program->constants = realloc(program->constants, program->constant_capacity * sizeof(struct val));
+
+    if(!program->constants) {
+      yyerror("out of space");
+      exit(0);
+    }
+  }
+
+  // Interned constants stay alive with the string table, the collector never looks at programs
+  if(value.type == STRING_TYPE) {
+    value.datavalue.string = intern_string(value.datavalue.string, value.length);
+  }
+
+  program->constants[program->constant_count] = value;
+  return program->constant_count++;
+}
+
+// Function to add a symbol name to the name pool, reusing existing entries
+static int add_name(struct program *program, char *name) {
+  for(int i = 0; i < program->name_count; i++) {
+    if(!strcmp(program->names[i], name)) {
+      return i;
+    }
+  }
+
+  if(program->name_count == program->name_capacity) {
+    program->name_capacity = program->name_capacity ? program->name_capacity * 2 : 8;
+    program->names = realloc(program->names, program->name_capacity * sizeof(char *));
+
+    if(!program->names) {
+      yyerror("out of space");
+      exit(0);
+    }
+  }
+
+  program->names[program->name_count] = name;
+  return program->name_count++;
+}
+
+// Function to emit the load of a variable bound by the resolver, or looked up by name otherwise
+static void emit_load(struct compiler *compiler, int scope, int slot, char *name) {
+  switch(scope) {
+    case GLOBAL_SLOT:
+      emit(compiler, OP_LOAD_GLOBAL, slot, 0, 1);
+      break;
+    case LOCAL_SLOT:
+      emit(compiler, OP_LOAD_LOCAL, slot, 0, 1);
+      break;
+    default:
+      emit(compiler, OP_LOAD, add_name(compiler->program, name), 0, 1);
+      break;
+  }
+}
+
+// Function to emit the store of a variable bound by the resolver, or looked up by name otherwise
+static void emit_store(struct compiler *compiler, int scope, int slot, char *name) {
+  switch(scope) {
+    case GLOBAL_SLOT:
+      emit(compiler, OP_STORE_GLOBAL, slot, 0, 0);
+      break;
+    case LOCAL_SLOT:
+      emit(compiler, OP_STORE_LOCAL, slot, 0, 0);
+      break;
+    default:
+      emit(compiler, OP_STORE, add_name(compiler->program, name), 0, 0);
+      break;
+  }
+}
+
+// Function to compile a node that may be missing, pushing an empty value instead
+static void compile_or_null(struct compiler *compiler, struct ast *abstract_syntax_tree) {
+  if(abstract_syntax_tree) {
+    compile_node(compiler, abstract_syntax_tree);
+  } else {
+    emit(compiler, OP_NULL, 0, 0, 1);
+  }
+}
+
+// Function to compile an argument list, returns the number of arguments pushed
+static int compile_arguments(struct compiler *compiler, struct ast *args) {
+  int number_of_arguments = 0;
+
+  while(args) {
+    if(args->nodetype == STATEMENT_LIST) {
+      /* List node */
+      compile_node(compiler, args->l);
+      args = args->r;
+    } else {
+      /* End of the list */
+      compile_node(compiler, args);
+      args = NULL;
+    }
+    number_of_arguments++;
+  }
+
+  return number_of_arguments;
+}
+
+// Function to compile a conditional jump with its two branches
+static void compile_branches(struct compiler *compiler, struct ast *condition, struct ast *then_list, struct ast *else_list) {
+  compile_node(compiler, condition);
+  int jump_to_else = emit(compiler, OP_JUMP_IF_FALSE, 0, 0, -1);
+
+  compile_or_null(compiler, then_list);
+  int jump_to_end = emit(compiler, OP_JUMP, 0, 0, 0);
+
+  // Only one of the branches leaves its value on the stack
+  compiler->depth--;
+  patch_jump(compiler, jump_to_else);
+  compiler->line = 0;
+  compile_or_null(compiler, else_list);
+  patch_jump(compiler, jump_to_end);
+  compiler->line = 0;
+}
+
+// Function to find the instruction of an operation on two numbers of a known type
+static int typed_opcode(struct typed_operation *typed_operation) {
+  int base = typed_operation->operand_type == INTEGER_TYPE ? OP_ADD_INTEGER : OP_ADD_DECIMAL;
+
+  switch(typed_operation->operation) {
+    case '+': return base;
+    case '-': return base + 1;
+    case '*': return base + 2;
+    case '/': return base + 3;
+    case '1': return base + 4;
+    case '2': return base + 5;
+    case '3': return base + 6;
+    case '4': return base + 7;
+    case '5': return base + 8;
+    default: return base + 9;
+  }
+}
+
+// Function to compile a single node, every node leaves exactly one value on the stack
+static void compile_node(struct compiler *compiler, struct ast *abstract_syntax_tree) {
+  struct program *program = compiler->program;
+  struct symbol_reference *symbol_reference = NULL;
+  struct assign_symbol *assign_symbol = NULL;
+  struct declare_symbol *declare_symbol = NULL;
+  struct assign_and_declare_symbol *assign_and_declare_symbol = NULL;
+  struct assign_and_declare_complex_symbol *assign_and_declare_complex_symbol = NULL;
+  struct user_function_call *user_function_call = NULL;
+  int number_of_arguments = 0;
+  int loop_start = 0;
+  int jump_to_end = 0;
+  int type_check = 0;
+
+  // Statement lists are made when the next line is read already, their statements have the right lines.
+  // A loop marks its line at its condition, which every iteration runs.
+  if(current_context->profile && abstract_syntax_tree->line && abstract_syntax_tree->line != compiler->line
+     && abstract_syntax_tree->nodetype != STATEMENT_LIST && abstract_syntax_tree->nodetype != LOOP_STATEMENT) {
+    compiler->line = abstract_syntax_tree->line;
+    emit(compiler, OP_LINE, compiler->line, 0, 0);
+  }
+
+  switch(abstract_syntax_tree->nodetype) {
+    case CONSTANT:
+      emit(compiler, OP_CONSTANT, add_constant(program, ((struct constant_value *)abstract_syntax_tree)->v), 0, 1);
+      break;
+
+    case NEW_REFERENCE:
+      symbol_reference = (struct symbol_reference *)abstract_syntax_tree;
+      emit_load(compiler, symbol_reference->scope, symbol_reference->slot, symbol_reference->s);
+      break;
+
+    case ASSIGNMENT:
+      assign_symbol = (struct assign_symbol *)abstract_syntax_tree;
+      compile_or_null(compiler, assign_symbol->v);
+      emit_store(compiler, assign_symbol->scope, assign_symbol->slot, assign_symbol->s);
+      break;
+
+    case '+':
+    case '-':
+    case '*':
+    case '/':
+    case LOGICAL_AND:
+    case LOGICAL_OR:
+    case '1':  case '2':  case '3':  case '4':  case '5':  case '6':
+      compile_node(compiler, abstract_syntax_tree->l);
+      compile_node(compiler, abstract_syntax_tree->r);
+
+      switch(abstract_syntax_tree->nodetype) {
+        case '+': emit(compiler, OP_ADD, 0, 0, -1); break;
+        case '-': emit(compiler, OP_SUBTRACT, 0, 0, -1); break;
+        case '*': emit(compiler, OP_MULTIPLY, 0, 0, -1); break;
+        case '/': emit(compiler, OP_DIVIDE, 0, 0, -1); break;
+        case LOGICAL_AND: emit(compiler, OP_AND, 0, 0, -1); break;
+        case LOGICAL_OR: emit(compiler, OP_OR, 0, 0, -1); break;
+        case '1': emit(compiler, OP_GREATER, 0, 0, -1); break;
+        case '2': emit(compiler, OP_LESS, 0, 0, -1); break;
+        case '3': emit(compiler, OP_NOT_EQUAL, 0, 0, -1); break;
+        case '4': emit(compiler, OP_EQUAL, 0, 0, -1); break;
+        case '5': emit(compiler, OP_GREATER_EQUAL, 0, 0, -1); break;
+        case '6': emit(compiler, OP_LESS_EQUAL, 0, 0, -1); break;
+      }
+      break;
+
+    case TYPED_OPERATION:
+      compile_node(compiler, abstract_syntax_tree->l);
+      compile_node(compiler, abstract_syntax_tree->r);
+      emit(compiler, typed_opcode((struct typed_operation *)abstract_syntax_tree), 0, 0, -1);
+      break;
+
+    case TO_DECIMAL:
+      compile_node(compiler, abstract_syntax_tree->l);
+      emit(compiler, OP_TO_DECIMAL, 0, 0, 0);
+      break;
+
+    case '|':
+      compile_node(compiler, abstract_syntax_tree->l);
+      emit(compiler, OP_ABSOLUTE, 0, 0, 0);
+      break;
+
+    case UNARY_MINUS:
+      compile_node(compiler, abstract_syntax_tree->l);
+      emit(compiler, OP_NEGATE, 0, 0, 0);
+      break;
+
+    case IF_STATEMENT:
+      compile_branches(compiler,
+        ((struct flow *)abstract_syntax_tree)->condition,
+        ((struct flow *)abstract_syntax_tree)->then_list,
+        ((struct flow *)abstract_syntax_tree)->else_list
+      );
+      break;
+
+    case FOR_STATEMENT:
+      // Same shape as eval() used to run: initialization, then a single conditional branch
+      compile_or_null(compiler, ((struct for_flow *)abstract_syntax_tree)->initialization);
+      emit(compiler, OP_POP, 0, 0, -1);
+      compile_branches(compiler,
+        ((struct for_flow *)abstract_syntax_tree)->condition,
+        ((struct for_flow *)abstract_syntax_tree)->then_list,
+        ((struct for_flow *)abstract_syntax_tree)->else_list
+      );
+      break;
+
+    case LOOP_STATEMENT:
+      // The value of a loop is the value of its last iteration
+      emit(compiler, OP_NULL, 0, 0, 1);
+
+      if(!((struct flow *)abstract_syntax_tree)->then_list) {
+        break;
+      }
+
+      // Code reached by a jump marks its line again
+      loop_start = program->code_count;
+      compiler->line = 0;
+      compile_node(compiler, ((struct flow *)abstract_syntax_tree)->condition);
+      jump_to_end = emit(compiler, OP_JUMP_IF_FALSE, 0, 0, -1);
+      emit(compiler, OP_POP, 0, 0, -1);
+      compile_node(compiler, ((struct flow *)abstract_syntax_tree)->then_list);
+
+      // Every iteration ends a statement list, so its output changes reach the pins
+      emit(compiler, OP_FLUSH, 0, 0, 0);
+      emit(compiler, OP_JUMP, loop_start, 0, 0);
+      patch_jump(compiler, jump_to_end);
+      compiler->line = 0;
+      break;
+
+    case STATEMENT_LIST:
+      compile_or_null(compiler, abstract_syntax_tree->l);
+      emit(compiler, OP_POP, 0, 0, -1);
+      compile_or_null(compiler, abstract_syntax_tree->r);
+      break;
+
+    case BUILTIN_TYPE:
+      number_of_arguments = compile_arguments(compiler, ((struct builtin_function_call *)abstract_syntax_tree)->argument_list);
+      emit(compiler, OP_BUILTIN, ((struct builtin_function_call *)abstract_syntax_tree)->function_type, number_of_arguments, 1 - number_of_arguments);
+      break;
+
+    case USER_CALL:
+      user_function_call = (struct user_function_call *)abstract_syntax_tree;
+      number_of_arguments = compile_arguments(compiler, user_function_call->argument_list);
+
+      if(user_function_call->scope == GLOBAL_SLOT) {
+        emit(compiler, OP_CALL_GLOBAL, user_function_call->slot, number_of_arguments, 1 - number_of_arguments);
+      } else {
+        emit(compiler, OP_CALL, add_name(program, user_function_call->s), number_of_arguments, 1 - number_of_arguments);
+      }
+      break;
+
+    case DECLARATION:
+      // A declaration stores the default value and evaluates to an empty value
+      declare_symbol = (struct declare_symbol *)abstract_syntax_tree;
+      emit(compiler, OP_DEFAULT, declare_symbol->type, 0, 1);
+      emit_store(compiler, declare_symbol->scope, declare_symbol->slot, declare_symbol->s);
+      emit(compiler, OP_POP, 0, 0, -1);
+      emit(compiler, OP_NULL, 0, 0, 1);
+      break;
+
+    case DECLARATION_WITH_ASSIGNMENT:
+      assign_and_declare_symbol = (struct assign_and_declare_symbol *)abstract_syntax_tree;
+      compile_or_null(compiler, assign_and_declare_symbol->value);
+      type_check = emit(compiler, OP_CHECK_TYPE, assign_and_declare_symbol->type, 0, 0);
+      emit_store(compiler, assign_and_declare_symbol->scope, assign_and_declare_symbol->slot, assign_and_declare_symbol->s);
+      compiler->program->code[type_check].b = compiler->program->code_count;
+      break;
+
+    case COMPLEX_ASSIGNMENT:
+      assign_and_declare_complex_symbol = (struct assign_and_declare_complex_symbol *)abstract_syntax_tree;
+      number_of_arguments = compile_arguments(compiler, assign_and_declare_complex_symbol->value);
+      emit(compiler, OP_DEVICE, assign_and_declare_complex_symbol->type, number_of_arguments, 1 - number_of_arguments);
+      emit_store(compiler, assign_and_declare_complex_symbol->scope, assign_and_declare_complex_symbol->slot, assign_and_declare_complex_symbol->s);
+      break;
+
+    default:
+      yyerror("internal error: bad node %d\n", abstract_syntax_tree->nodetype);
+      emit(compiler, OP_NULL, 0, 0, 1);
+      break;
+  }
+}
+
+// Function to compile an AST into a program
+struct program *compile(struct ast *abstract_syntax_tree) {
+  struct program *program = calloc(1, sizeof(struct program));
+
+  if(!program) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  struct compiler compiler = { program, 0, 0 };
+
+  compile_or_null(&compiler, abstract_syntax_tree);
+  emit(&compiler, OP_HALT, 0, 0, 0);
+
+  return program;
+}
+
+// Function to free a compiled program, the constants and names still belong to the AST
+void free_program(struct program *program) {
+  if(!program) {
+    return;
+  }
+
+  if(!program->mapped) {
+    free(program->code);
+  }
+  free(program->constants);
+  free(program->names);
+  free(program);
+}
+
+// Function to create the value of a variable declared without assignment
+static struct val create_default_value(int type) {
+  switch(type) {
+    case BIT_TYPE:
+      return create_bit_value(0);
+    case INTEGER_TYPE:
+      return create_integer_value(0);
+    case DECIMAL_TYPE:
+      return create_decimal_value(0.0);
+    case STRING_TYPE:
+      return create_string_value("");
+    case LED:
+      return create_led_value(NULL, 1);
+    case BUTTON:
+      return create_button_value(NULL, 1);
+    case KEYPAD:
+      return create_keypad_value(NULL, 1);
+    case BUZZER:
+      return create_buzzer_value(NULL, 1);
+    case SERVO_MOTOR:
+      return create_servo_motor_value(NULL, 1);
+    default:
+      yyerror("Type not recognized.");
+      return create_empty_value();
+  }
+}
+
+// Function to create a device from the pins on the stack, a servo can follow its pin with its pulse widths
+static struct val create_device(int type, struct val *pins, int number_of_arguments) {
+  switch(type) {
+    case LED:
+      trace(TRACE_INFO, "LED TYPE detected.\n");
+      return create_LED(pins);
+    case BUTTON:
+      trace(TRACE_INFO, "BUTTON TYPE detected.\n");
+      return create_BUTTON(pins);
+    case KEYPAD:
+      trace(TRACE_INFO, "KEYPAD TYPE detected.\n");
+      return create_KEYPAD(pins);
+    case BUZZER:
+      trace(TRACE_INFO, "BUZZER TYPE detected.\n");
+      return create_BUZZER(pins);
+    case SERVO_MOTOR:
+      trace(TRACE_INFO, "SERVO_MOTOR TYPE detected.\n");
+      return create_SERVO_MOTOR(pins, number_of_arguments);
+    default:
+      trace(TRACE_INFO, "NO TYPE detected.\n");
+      return create_empty_value();
+  }
+}
+
+#ifdef VM_COMPUTED_GOTO
+#define TARGET(op) label_##op:
+#define DISPATCH() goto *dispatch_table[(instruction = ip++)->opcode]
+#else
+#define TARGET(op) case op:
+#define DISPATCH() goto dispatch
+#endif
+
+// Function to allocate the value and call stacks of an interpreter
+void allocate_stacks(struct interpreter_context *context) {
+  context->value_stack = malloc(VALUE_STACK_SIZE * sizeof(struct val));
+  context->call_stack = malloc(CALL_STACK_SIZE * sizeof(struct call_frame));
+
+  if(!context->value_stack || !context->call_stack) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  context->stack_top = context->value_stack;
+}
+
+// Function to run a compiled top-level program, the functions it calls run on the same value stack
+struct val run_program(struct program *program) {
+  struct interpreter_context *context = current_context;
+  struct val *stack = NULL;
+  struct val *sp = NULL;
+  struct val *frame = NULL;
+  struct call_frame *call = NULL;
+  struct symbol *symtab = context->symtab;
+  struct instruction *ip = program->code;
+  struct instruction *instruction = NULL;
+  struct symbol *s = NULL;
+  struct program *callee = NULL;
+  struct val v;
+
+  if(!context->value_stack) {
+    allocate_stacks(context);
+  }
+
+  stack = sp = frame = context->value_stack;
+  call = context->call_stack;
+
+  if(program->max_stack + 1 > VALUE_STACK_SIZE) {
+    yyerror("Statement is too large to run.");
+    return create_empty_value();
+  }
+
+#ifdef VM_COMPUTED_GOTO
+  static void *dispatch_table[OPCODE_COUNT] = {
+    [OP_HALT] = &&label_OP_HALT,
+    [OP_CONSTANT] = &&label_OP_CONSTANT,
+    [OP_NULL] = &&label_OP_NULL,
+    [OP_POP] = &&label_OP_POP,
+    [OP_LOAD] = &&label_OP_LOAD,
+    [OP_STORE] = &&label_OP_STORE,
+    [OP_LOAD_GLOBAL] = &&label_OP_LOAD_GLOBAL,
+    [OP_STORE_GLOBAL] = &&label_OP_STORE_GLOBAL,
+    [OP_LOAD_LOCAL] = &&label_OP_LOAD_LOCAL,
+    [OP_STORE_LOCAL] = &&label_OP_STORE_LOCAL,
+    [OP_DEFAULT] = &&label_OP_DEFAULT,
+    [OP_CHECK_TYPE] = &&label_OP_CHECK_TYPE,
+    [OP_DEVICE] = &&label_OP_DEVICE,
+    [OP_ADD] = &&label_OP_ADD,
+    [OP_SUBTRACT] = &&label_OP_SUBTRACT,
+    [OP_MULTIPLY] = &&label_OP_MULTIPLY,
+    [OP_DIVIDE] = &&label_OP_DIVIDE,
+    [OP_ABSOLUTE] = &&label_OP_ABSOLUTE,
+    [OP_NEGATE] = &&label_OP_NEGATE,
+    [OP_AND] = &&label_OP_AND,
+    [OP_OR] = &&label_OP_OR,
+    [OP_GREATER] = &&label_OP_GREATER,
+    [OP_LESS] = &&label_OP_LESS,
+    [OP_NOT_EQUAL] = &&label_OP_NOT_EQUAL,
+    [OP_EQUAL] = &&label_OP_EQUAL,
+    [OP_GREATER_EQUAL] = &&label_OP_GREATER_EQUAL,
+    [OP_LESS_EQUAL] = &&label_OP_LESS_EQUAL,
+    [OP_ADD_INTEGER] = &&label_OP_ADD_INTEGER,
+    [OP_SUBTRACT_INTEGER] = &&label_OP_SUBTRACT_INTEGER,
+    [OP_MULTIPLY_INTEGER] = &&label_OP_MULTIPLY_INTEGER,
+    [OP_DIVIDE_INTEGER] = &&label_OP_DIVIDE_INTEGER,
+    [OP_GREATER_INTEGER] = &&label_OP_GREATER_INTEGER,
+    [OP_LESS_INTEGER] = &&label_OP_LESS_INTEGER,
+    [OP_NOT_EQUAL_INTEGER] = &&label_OP_NOT_EQUAL_INTEGER,
+    [OP_EQUAL_INTEGER] = &&label_OP_EQUAL_INTEGER,
+    [OP_GREATER_EQUAL_INTEGER] = &&label_OP_GREATER_EQUAL_INTEGER,
+    [OP_LESS_EQUAL_INTEGER] = &&label_OP_LESS_EQUAL_INTEGER,
+    [OP_ADD_DECIMAL] = &&label_OP_ADD_DECIMAL,
+    [OP_SUBTRACT_DECIMAL] = &&label_OP_SUBTRACT_DECIMAL,
+    [OP_MULTIPLY_DECIMAL] = &&label_OP_MULTIPLY_DECIMAL,
+    [OP_DIVIDE_DECIMAL] = &&label_OP_DIVIDE_DECIMAL,
+    [OP_GREATER_DECIMAL] = &&label_OP_GREATER_DECIMAL,
+    [OP_LESS_DECIMAL] = &&label_OP_LESS_DECIMAL,
+    [OP_NOT_EQUAL_DECIMAL] = &&label_OP_NOT_EQUAL_DECIMAL,
+    [OP_EQUAL_DECIMAL] = &&label_OP_EQUAL_DECIMAL,
+    [OP_GREATER_EQUAL_DECIMAL] = &&label_OP_GREATER_EQUAL_DECIMAL,
+    [OP_LESS_EQUAL_DECIMAL] = &&label_OP_LESS_EQUAL_DECIMAL,
+    [OP_TO_DECIMAL] = &&label_OP_TO_DECIMAL,
+    [OP_JUMP] = &&label_OP_JUMP,
+    [OP_JUMP_IF_FALSE] = &&label_OP_JUMP_IF_FALSE,
+    [OP_BUILTIN] = &&label_OP_BUILTIN,
+    [OP_CALL] = &&label_OP_CALL,
+    [OP_CALL_GLOBAL] = &&label_OP_CALL_GLOBAL,
+    [OP_FLUSH] = &&label_OP_FLUSH,
+    [OP_LINE] = &&label_OP_LINE
+  };
+#endif
+
+  DISPATCH();
+
+#ifndef VM_COMPUTED_GOTO
+dispatch:
+  switch((instruction = ip++)->opcode) {
+#endif
+
+    TARGET(OP_HALT)
+      v = sp > frame + program->frame_size ? sp[-1] : create_empty_value();
+
+    return_value:
+      // The end of a program is a safe point, its value is still on the stack
+      context->stack_top = sp;
+      heap_safe_point();
+
+      if(call == context->call_stack) {
+        // The time until the next program runs, like waiting at the prompt, belongs to no line
+        if(context->profile) {
+          profile_resume(-1);
+        }
+
+        context->stack_top = stack;
+        return v;
+      }
+
+      // Drop the frame of the function and continue its caller with the value of the call
+      call--;
+      sp = frame;
+      *sp++ = v;
+      program = call->program;
+      ip = call->ip;
+      frame = call->frame;
+
+      if(context->profile) {
+        profile_resume(call - context->call_stack);
+      }
+
+      DISPATCH();
+
+    TARGET(OP_CONSTANT)
+      *sp++ = program->constants[instruction->a];
+      DISPATCH();
+
+    TARGET(OP_NULL)
+      *sp++ = create_empty_value();
+      DISPATCH();
+
+    TARGET(OP_POP)
+      sp--;
+      DISPATCH();
+
+    TARGET(OP_LOAD)
+      s = lookup(program->names[instruction->a]);
+      *sp++ = s->value;
+      DISPATCH();
+
+    TARGET(OP_STORE)
+      s = lookup(program->names[instruction->a]);
+      s->value = sp[-1];
+      DISPATCH();
+
+    TARGET(OP_LOAD_GLOBAL)
+      *sp++ = symtab[instruction->a].value;
+      DISPATCH();
+
+    TARGET(OP_STORE_GLOBAL)
+      symtab[instruction->a].value = sp[-1];
+      DISPATCH();
+
+    TARGET(OP_LOAD_LOCAL)
+      *sp++ = frame[instruction->a];
+      DISPATCH();
+
+    TARGET(OP_STORE_LOCAL)
+      frame[instruction->a] = sp[-1];
+      DISPATCH();
+
+    TARGET(OP_DEFAULT)
+      *sp++ = create_default_value(instruction->a);
+      DISPATCH();
+
+    TARGET(OP_CHECK_TYPE)
+      // Check if the value matches the declared type
+      if(sp[-1].type != NO_TYPE && instruction->a != sp[-1].type) {
+        yyerror("Type not recognized.");
+        sp[-1] = create_empty_value();
+        ip = program->code + instruction->b;
+      }
+      DISPATCH();
+
+    TARGET(OP_DEVICE)
+      sp -= instruction->b;
+      *sp = create_device(instruction->a, sp, instruction->b);
+      sp++;
+      DISPATCH();
+
+    TARGET(OP_ADD)
+      sp--;
+      sp[-1] = sum(sp[-1], sp[0]);
+      DISPATCH();
+
+    TARGET(OP_SUBTRACT)
+      sp--;
+      sp[-1] = subtract(sp[-1], sp[0]);
+      DISPATCH();
+
+    TARGET(OP_MULTIPLY)
+      sp--;
+      sp[-1] = multiply(sp[-1], sp[0]);
+      DISPATCH();
+
+    TARGET(OP_DIVIDE)
+      sp--;
+      sp[-1] = divide(sp[-1], sp[0]);
+      DISPATCH();
+
+    TARGET(OP_ABSOLUTE)
+      sp[-1] = get_absolute_value(sp[-1]);
+      DISPATCH();
+
+    TARGET(OP_NEGATE)
+      sp[-1] = change_sign(sp[-1]);
+      DISPATCH();
+
+    TARGET(OP_AND)
+      sp--;
+      sp[-1] = calculate_logical_and(sp[-1], sp[0]);
+      DISPATCH();
+
+    TARGET(OP_OR)
+      sp--;
+      sp[-1] = calculate_logical_or(sp[-1], sp[0]);
+      DISPATCH();
+
+    TARGET(OP_GREATER)
+      sp--;
+      sp[-1] = calculate_greater_than(sp[-1], sp[0]);
+      DISPATCH();
+
+    TARGET(OP_LESS)
+      sp--;
+      sp[-1] = calculate_less_than(sp[-1], sp[0]);
+      DISPATCH();
+
+    TARGET(OP_NOT_EQUAL)
+      sp--;
+      sp[-1] = calculate_not_equals(sp[-1], sp[0]);
+      DISPATCH();
+
+    TARGET(OP_EQUAL)
+      sp--;
+      sp[-1] = calculate_equals(sp[-1], sp[0]);
+      DISPATCH();
+
+    TARGET(OP_GREATER_EQUAL)
+      sp--;
+      sp[-1] = calculate_greater_equal_than(sp[-1], sp[0]);
+      DISPATCH();
+
+    TARGET(OP_LESS_EQUAL)
+      sp--;
+      sp[-1] = calculate_less_equal_than(sp[-1], sp[0]);
+      DISPATCH();
+
+    TARGET(OP_ADD_INTEGER)
+      sp--;
+      sp[-1].datavalue.integer = sp[-1].datavalue.integer + sp[0].datavalue.integer;
+      DISPATCH();
+
+    TARGET(OP_SUBTRACT_INTEGER)
+      sp--;
+      sp[-1].datavalue.integer = sp[-1].datavalue.integer - sp[0].datavalue.integer;
+      DISPATCH();
+
+    TARGET(OP_MULTIPLY_INTEGER)
+      sp--;
+      sp[-1].datavalue.integer = sp[-1].datavalue.integer * sp[0].datavalue.integer;
+      DISPATCH();
+
+    TARGET(OP_DIVIDE_INTEGER)
+      sp--;
+
+      // Same results as divide(): an integer when exact, a decimal otherwise, nothing for zero
+      if(sp[0].datavalue.integer == 0) {
+        sp[-1] = create_empty_value();
+      } else if(sp[-1].datavalue.integer % sp[0].datavalue.integer == 0) {
+        sp[-1].datavalue.integer = sp[-1].datavalue.integer / sp[0].datavalue.integer;
+      } else {
+        sp[-1] = create_decimal_value((double)sp[-1].datavalue.integer / (double)sp[0].datavalue.integer);
+      }
+      DISPATCH();
+
+    TARGET(OP_GREATER_INTEGER)
+      sp--;
+      sp[-1].datavalue.bit = sp[-1].datavalue.integer > sp[0].datavalue.integer;
+      sp[-1].type = BIT_TYPE;
+      DISPATCH();
+
+    TARGET(OP_LESS_INTEGER)
+      sp--;
+      sp[-1].datavalue.bit = sp[-1].datavalue.integer < sp[0].datavalue.integer;
+      sp[-1].type = BIT_TYPE;
+      DISPATCH();
+
+    TARGET(OP_NOT_EQUAL_INTEGER)
+      sp--;
+      sp[-1].datavalue.bit = sp[-1].datavalue.integer != sp[0].datavalue.integer;
+      sp[-1].type = BIT_TYPE;
+      DISPATCH();
+
+    TARGET(OP_EQUAL_INTEGER)
+      sp--;
+      sp[-1].datavalue.bit = sp[-1].datavalue.integer == sp[0].datavalue.integer;
+      sp[-1].type = BIT_TYPE;
+      DISPATCH();
+
+    TARGET(OP_GREATER_EQUAL_INTEGER)
+      sp--;
+      sp[-1].datavalue.bit = sp[-1].datavalue.integer >= sp[0].datavalue.integer;
+      sp[-1].type = BIT_TYPE;
+      DISPATCH();
+
+    TARGET(OP_LESS_EQUAL_INTEGER)
+      sp--;
+      sp[-1].datavalue.bit = sp[-1].datavalue.integer <= sp[0].datavalue.integer;
+      sp[-1].type = BIT_TYPE;
+      DISPATCH();
+
+    TARGET(OP_ADD_DECIMAL)
+      sp--;
+      sp[-1].datavalue.decimal = sp[-1].datavalue.decimal + sp[0].datavalue.decimal;
+      DISPATCH();
+
+    TARGET(OP_SUBTRACT_DECIMAL)
+      sp--;
+      sp[-1].datavalue.decimal = sp[-1].datavalue.decimal - sp[0].datavalue.decimal;
+      DISPATCH();
+
+    TARGET(OP_MULTIPLY_DECIMAL)
+      sp--;
+      sp[-1].datavalue.decimal = sp[-1].datavalue.decimal * sp[0].datavalue.decimal;
+      DISPATCH();
+
+    TARGET(OP_DIVIDE_DECIMAL)
+      sp--;
+
+      if(sp[0].datavalue.decimal == 0) {
+        sp[-1] = create_empty_value();
+      } else {
+        sp[-1].datavalue.decimal = sp[-1].datavalue.decimal / sp[0].datavalue.decimal;
+      }
+      DISPATCH();
+
+    TARGET(OP_GREATER_DECIMAL)
+      sp--;
+      sp[-1].datavalue.bit = sp[-1].datavalue.decimal > sp[0].datavalue.decimal;
+      sp[-1].type = BIT_TYPE;
+      DISPATCH();
+
+    TARGET(OP_LESS_DECIMAL)
+      sp--;
+      sp[-1].datavalue.bit = sp[-1].datavalue.decimal < sp[0].datavalue.decimal;
+      sp[-1].type = BIT_TYPE;
+      DISPATCH();
+
+    TARGET(OP_NOT_EQUAL_DECIMAL)
+      sp--;
+      sp[-1].datavalue.bit = sp[-1].datavalue.decimal != sp[0].datavalue.decimal;
+      sp[-1].type = BIT_TYPE;
+      DISPATCH();
+
+    TARGET(OP_EQUAL_DECIMAL)
+      sp--;
+      sp[-1].datavalue.bit = sp[-1].datavalue.decimal == sp[0].datavalue.decimal;
+      sp[-1].type = BIT_TYPE;
+      DISPATCH();
+
+    TARGET(OP_GREATER_EQUAL_DECIMAL)
+      sp--;
+      sp[-1].datavalue.bit = sp[-1].datavalue.decimal >= sp[0].datavalue.decimal;
+      sp[-1].type = BIT_TYPE;
+      DISPATCH();
+
+    TARGET(OP_LESS_EQUAL_DECIMAL)
+      sp--;
+      sp[-1].datavalue.bit = sp[-1].datavalue.decimal <= sp[0].datavalue.decimal;
+      sp[-1].type = BIT_TYPE;
+      DISPATCH();
+
+    TARGET(OP_TO_DECIMAL)
+      sp[-1] = create_decimal_value(sp[-1].datavalue.integer);
+      DISPATCH();
+
+    TARGET(OP_JUMP)
+      ip = program->code + instruction->a;
+      DISPATCH();
+
+    TARGET(OP_JUMP_IF_FALSE)
+      v = *--sp;
+
+      // Check if value type is comparison
+      // An invalid condition ends the function it is in
+      if(get_value_type(v) != BIT_TYPE) {
+        yyerror("invalid condition");
+        v = create_empty_value();
+        goto return_value;
+      }
+
+      if(v.datavalue.bit == 0) {
+        ip = program->code + instruction->a;
+      }
+      DISPATCH();
+
+    TARGET(OP_BUILTIN)
+      sp -= instruction->b;
+
+      if(context->profile) {
+        profile_builtin(instruction->a, call - context->call_stack);
+        *sp = builtin_function_call(instruction->a, sp, instruction->b);
+        profile_resume(call - context->call_stack);
+      } else {
+        *sp = builtin_function_call(instruction->a, sp, instruction->b);
+      }
+
+      sp++;
+      DISPATCH();
+
+    TARGET(OP_LINE)
+      profile_line(program, call - context->call_stack, instruction->a);
+      DISPATCH();
+
+    TARGET(OP_CALL)
+      s = lookup(program->names[instruction->a]);
+      goto call_function;
+
+    TARGET(OP_CALL_GLOBAL)
+      s = &symtab[instruction->a];
+
+    call_function:
+      sp -= instruction->b;
+      callee = s->code;
+
+      if(!callee) {
+        yyerror("Call to undefined function %s", s->name);
+        *sp++ = create_empty_value();
+        DISPATCH();
+      }
+
+      if(instruction->b < callee->parameter_count) {
+        yyerror("Too few args in call to %s", s->name);
+        *sp++ = create_empty_value();
+        DISPATCH();
+      }
+
+      if(call == context->call_stack + CALL_STACK_SIZE || sp + callee->frame_size + callee->max_stack + 1 > context->value_stack + VALUE_STACK_SIZE) {
+        yyerror("Too many nested calls to %s", s->name);
+        *sp++ = create_empty_value();
+        DISPATCH();
+      }
+
+      call->program = program;
+      call->ip = ip;
+      call->frame = frame;
+      call++;
+
+      // The arguments on the stack are the first slots of the frame, the declared locals start empty
+      frame = sp;
+      sp = frame + callee->parameter_count;
+
+      while(sp < frame + callee->frame_size) {
+        *sp++ = create_empty_value();
+      }
+
+      program = callee;
+      ip = program->code;
+      DISPATCH();
+
+    TARGET(OP_FLUSH)
+      // Every loop iteration ends here, so long running loops collect their garbage
+      flush_gpio_writes();
+      context->stack_top = sp;
+      heap_safe_point();
+      DISPATCH();
+
+#ifndef VM_COMPUTED_GOTO
+    default:
+      yyerror("internal error: bad opcode %d\n", instruction->opcode);
+      v = create_empty_value();
+      goto return_value;
+  }
+#endif
+
+  context->stack_top = stack;
+  return create_empty_value();
+}
@@ -0,0 +1,123 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "learnpi.h"
+
+// Instruction set of the virtual machine
+enum opcode {
+  OP_HALT,
+  OP_CONSTANT,          // push constants[a]
+  OP_NULL,              // push an empty value
+  OP_POP,               // drop the value on top of the stack
+  OP_LOAD,              // push the value of names[a], looked up at run time
+  OP_STORE,             // assign the top of the stack to names[a], keep it on the stack
+  OP_LOAD_GLOBAL,       // push the value of symtab[a]
+  OP_STORE_GLOBAL,      // assign the top of the stack to symtab[a], keep it on the stack
+  OP_LOAD_LOCAL,        // push the value of frame slot a
+  OP_STORE_LOCAL,       // assign the top of the stack to frame slot a, keep it on the stack
+  OP_DEFAULT,           // push the default value of type a
+  OP_CHECK_TYPE,        // check the top of the stack has type a, else replace it and continue at b
+  OP_DEVICE,            // pop b pins and push a new device of type a
+  OP_ADD,
+  OP_SUBTRACT,
+  OP_MULTIPLY,
+  OP_DIVIDE,
+  OP_ABSOLUTE,
+  OP_NEGATE,
+  OP_AND,
+  OP_OR,
+  OP_GREATER,
+  OP_LESS,
+  OP_NOT_EQUAL,
+  OP_EQUAL,
+  OP_GREATER_EQUAL,
+  OP_LESS_EQUAL,
+  OP_ADD_INTEGER,       // arithmetic and comparisons on two integers, no type checks
+  OP_SUBTRACT_INTEGER,
+  OP_MULTIPLY_INTEGER,
+  OP_DIVIDE_INTEGER,
+  OP_GREATER_INTEGER,
+  OP_LESS_INTEGER,
+  OP_NOT_EQUAL_INTEGER,
+  OP_EQUAL_INTEGER,
+  OP_GREATER_EQUAL_INTEGER,
+  OP_LESS_EQUAL_INTEGER,
+  OP_ADD_DECIMAL,       // arithmetic and comparisons on two decimals, no type checks
+  OP_SUBTRACT_DECIMAL,
+  OP_MULTIPLY_DECIMAL,
+  OP_DIVIDE_DECIMAL,
+  OP_GREATER_DECIMAL,
+  OP_LESS_DECIMAL,
+  OP_NOT_EQUAL_DECIMAL,
+  OP_EQUAL_DECIMAL,
+  OP_GREATER_EQUAL_DECIMAL,
+  OP_LESS_EQUAL_DECIMAL,
+  OP_TO_DECIMAL,        // turn the integer on top of the stack into a decimal
+  OP_JUMP,              // continue at instruction a
+  OP_JUMP_IF_FALSE,     // pop a bit condition, continue at instruction a if it is 0
+  OP_BUILTIN,           // pop b arguments and call built in function a
+  OP_CALL,              // pop b arguments and call user function names[a]
+  OP_CALL_GLOBAL,       // pop b arguments and call user function symtab[a]
+  OP_FLUSH,             // write the queued gpio levels
+  OP_LINE,              // line a starts, only compiled in with --profile
+  OPCODE_COUNT
+};
+
+// Structure for a single instruction
+struct instruction {
+  int opcode;
+  int a;
+  int b;
+};
+
+// Structure for a compiled program
+struct program {
+  const char *name;     // name of a function body, NULL for statements of the script
+  struct instruction *code;
+  int code_count;
+  int code_capacity;
+
+  struct val *constants;
+  int constant_count;
+  int constant_capacity;
+
+  char **names;
+  int name_count;
+  int name_capacity;
+
+  int max_stack;
+
+  // Number of frame slots a function body expects as arguments
+  int parameter_count;
+
+  // Number of frame slots of a function body, its parameters and then its declared locals
+  int frame_size;
+
+  // Set when the code lives in a mapped compiled image and must not be freed
+  int mapped;
+};
+
+// Values one interpreter can have on its stack, and calls it can have running at once
+#define VALUE_STACK_SIZE 65536
+#define CALL_STACK_SIZE 8192
+
+// Structure for the caller of a running function, its frame and operands stay on the value stack below the callee
+struct call_frame {
+  struct program *program;
+  struct instruction *ip;
+  struct val *frame;
+};
+
+// Function to compile an AST into a program
+struct program *compile(struct ast *abstract_syntax_tree);
+
+// Function to run a compiled top-level program, the functions it calls run on the same value stack
+struct val run_program(struct program *program);
+
+// Function to allocate the value and call stacks of an interpreter
+void allocate_stacks(struct interpreter_context *context);
+
+// Function to free a compiled program
+void free_program(struct program *program);
+
+#endif
@@ -0,0 +1,630 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "learnpi.h"
+#include "functions.h"
+#include "bytecode.h"
+#include "cache.h"
+#include "trace.h"
+
+// Bump the version whenever the image layout or the meaning of an opcode changes
+#define IMAGE_MAGIC "LEARNPIC"
+#define IMAGE_VERSION 2
+#define IMAGE_ALIGNMENT 8
+
+// Kinds of top-level units in an image, in the order the script ran them
+enum image_unit_kind {
+  IMAGE_STATEMENT = 1,
+  IMAGE_FUNCTION
+};
+
+// Structure at the start of an image, the strings follow the units
+struct image_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t opcode_count;
+  uint64_t source_hash;
+  uint64_t source_size;
+  uint64_t image_size;
+  uint32_t unit_count;
+  uint32_t strings_offset;
+};
+
+// Structure for a compiled unit, followed by its instructions, constants, names and globals.
+// Global slot operands are indices into the globals, which hold symbol names,
+// so the unit can be relocated to the symbol table of the process that maps it.
+struct image_unit {
+  uint32_t kind;
+  uint32_t name;
+  uint32_t parameter_count;
+  uint32_t max_stack;
+  uint32_t code_count;
+  uint32_t constant_count;
+  uint32_t name_count;
+  uint32_t global_count;
+  uint32_t line;
+  uint32_t frame_size;
+};
+
+// Structure for a constant, strings are offsets into the string table
+struct image_constant {
+  int32_t type;
+  uint32_t string;
+  int32_t integer;
+  int32_t padding;
+  double decimal;
+};
+
+// Structure for a growing block of image bytes
+struct image_buffer {
+  char *data;
+  size_t size;
+  size_t capacity;
+};
+
+// Structure for a unit mapped from an image, ready to run or to install
+struct loaded_unit {
+  int kind;
+  int line;
+  char *name;
+  struct program *program;
+};
+
+int cache_disabled = 0;
+
+// Structure for the recording state of the script an interpreter is parsing
+struct image_recording {
+  char *path;
+  uint64_t hash;
+  uint64_t size;
+  uint32_t unit_count;
+  struct image_buffer units;
+  struct image_buffer strings;
+};
+
+// Function to hash a block of bytes with 64 bit FNV-1a
+static uint64_t fnv1a(const unsigned char *data, size_t size) {
+  uint64_t hash = 14695981039346656037ULL;
+
+  for(size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 1099511628211ULL;
+  }
+
+  return hash;
+}
+
+// Function to hash the content of a file, returns 0 if it cannot be read
+static int hash_file(char *path, uint64_t *hash, uint64_t *size) {
+  struct stat status;
+  void *content = NULL;
+  int fd = open(path, O_RDONLY);
+
+  if(fd < 0) {
+    return 0;
+  }
+
+  if(fstat(fd, &status) < 0) {
+    close(fd);
+    return 0;
+  }
+
+  *size = status.st_size;
+
+  if(status.st_size == 0) {
+    *hash = fnv1a(NULL, 0);
+    close(fd);
+    return 1;
+  }
+
+  content = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if(content == MAP_FAILED) {
+    return 0;
+  }
+
+  *hash = fnv1a(content, status.st_size);
+  munmap(content, status.st_size);
+
+  return 1;
+}
+
+// Function to name the image of a script, foo.learnpi is cached in foo.learnpic
+static char *image_path(char *source_path) {
+  char *path = malloc(strlen(source_path) + 2);
+
+  if(!path) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  strcpy(path, source_path);
+  strcat(path, "c");
+
+  return path;
+}
+
+// Function to append bytes to an image buffer
+static void buffer_append(struct image_buffer *buffer, const void *data, size_t size) {
+  if(buffer->size + size > buffer->capacity) {
+    while(buffer->size + size > buffer->capacity) {
+      buffer->capacity = buffer->capacity ? buffer->capacity * 2 : 1024;
+    }
+
+    buffer->data = realloc(buffer->data, buffer->capacity);
+
+    if(!buffer->data) {
+      yyerror("out of space");
+      exit(0);
+    }
+  }
+
+  memcpy(buffer->data + buffer->size, data, size);
+  buffer->size += size;
+}
+
+// Function to pad an image buffer to the image alignment
+static void buffer_align(struct image_buffer *buffer) {
+  static const char zeros[IMAGE_ALIGNMENT] = {0};
+
+  if(buffer->size % IMAGE_ALIGNMENT) {
+    buffer_append(buffer, zeros, IMAGE_ALIGNMENT - buffer->size % IMAGE_ALIGNMENT);
+  }
+}
+
+// Function to empty an image buffer
+static void buffer_free(struct image_buffer *buffer) {
+  free(buffer->data);
+  buffer->data = NULL;
+  buffer->size = 0;
+  buffer->capacity = 0;
+}
+
+// Function to add length characters to the string table, reusing an equal string
+static uint32_t add_characters(char *characters, size_t length) {
+  struct image_buffer *strings = &current_context->recording->strings;
+  size_t offset = 0;
+  size_t size = 0;
+
+  while(offset < strings->size) {
+    size = strlen(strings->data + offset);
+
+    if(size == length && !memcmp(strings->data + offset, characters, length)) {
+      return offset;
+    }
+
+    offset += size + 1;
+  }
+
+  buffer_append(strings, characters, length);
+  buffer_append(strings, "", 1);
+  return offset;
+}
+
+// Function to add a string to the string table, reusing an equal string
+static uint32_t add_string(char *string) {
+  return add_characters(string, strlen(string));
+}
+
+// Function to check if an instruction addresses the symbol table by slot
+static int has_global_operand(int opcode) {
+  return opcode == OP_LOAD_GLOBAL || opcode == OP_STORE_GLOBAL || opcode == OP_CALL_GLOBAL;
+}
+
+// Function to add the symbol of a slot to the globals of a unit, reusing an earlier entry
+static uint32_t add_global(uint32_t *globals, uint32_t *global_count, int slot) {
+  uint32_t name = add_string(current_context->symtab[slot].name);
+
+  for(uint32_t i = 0; i < *global_count; i++) {
+    if(globals[i] == name) {
+      return i;
+    }
+  }
+
+  globals[*global_count] = name;
+  return (*global_count)++;
+}
+
+// Function to serialize a compiled unit into the image being recorded
+static void record_unit(int kind, char *name, struct program *program) {
+  struct image_buffer *units = &current_context->recording->units;
+  struct image_unit unit;
+  struct instruction instruction;
+  struct image_constant constant;
+  uint32_t *globals = malloc((program->code_count + 1) * sizeof(uint32_t));
+  uint32_t global_count = 0;
+  uint32_t offset = 0;
+
+  if(!globals) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  memset(&unit, 0, sizeof(unit));
+  unit.kind = kind;
+  unit.name = name ? add_string(name) : 0;
+  unit.parameter_count = program->parameter_count;
+  unit.frame_size = program->frame_size;
+  unit.max_stack = program->max_stack;
+  unit.code_count = program->code_count;
+  unit.constant_count = program->constant_count;
+  unit.name_count = program->name_count;
+
+  // Errors while running report the line the parser had reached
+  unit.line = current_line();
+
+  // The global count is only known after the code is written
+  size_t unit_offset = units->size;
+  buffer_append(units, &unit, sizeof(unit));
+
+  for(int i = 0; i < program->code_count; i++) {
+    instruction = program->code[i];
+
+    if(has_global_operand(instruction.opcode)) {
+      instruction.a = add_global(globals, &global_count, instruction.a);
+    }
+
+    buffer_append(units, &instruction, sizeof(instruction));
+  }
+  buffer_align(units);
+
+  for(int i = 0; i < program->constant_count; i++) {
+    memset(&constant, 0, sizeof(constant));
+    constant.type = program->constants[i].type;
+
+    if(constant.type == STRING_TYPE) {
+      constant.string = add_characters(program->constants[i].datavalue.string, program->constants[i].length);
+    } else if(constant.type == DECIMAL_TYPE) {
+      constant.decimal = program->constants[i].datavalue.decimal;
+    } else {
+      constant.integer = program->constants[i].datavalue.integer;
+    }
+
+    buffer_append(units, &constant, sizeof(constant));
+  }
+
+  for(int i = 0; i < program->name_count; i++) {
+    offset = add_string(program->names[i]);
+    buffer_append(units, &offset, sizeof(offset));
+  }
+  buffer_align(units);
+
+  buffer_append(units, globals, global_count * sizeof(uint32_t));
+  buffer_align(units);
+
+  ((struct image_unit *)(units->data + unit_offset))->global_count = global_count;
+  current_context->recording->unit_count++;
+
+  free(globals);
+}
+
+// Function to start recording the compiled top-level units of a script
+void begin_script_cache(char *source_path) {
+  struct image_recording *recording = NULL;
+
+  if(cache_disabled) {
+    return;
+  }
+
+  recording = calloc(1, sizeof(struct image_recording));
+
+  if(!recording) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  if(!hash_file(source_path, &recording->hash, &recording->size)) {
+    free(recording);
+    return;
+  }
+
+  recording->path = image_path(source_path);
+  current_context->recording = recording;
+}
+
+// Function to record a compiled top-level statement
+void cache_statement(struct program *program) {
+  if(current_context->recording) {
+    record_unit(IMAGE_STATEMENT, NULL, program);
+  }
+}
+
+// Function to record a compiled function definition
+void cache_function(char *name, struct program *program) {
+  if(current_context->recording) {
+    record_unit(IMAGE_FUNCTION, name, program);
+  }
+}
+
+// Function to write the recorded image next to the script, nothing is written if save is 0
+void end_script_cache(int save) {
+  struct image_recording *recording = current_context->recording;
+  struct image_header header;
+  char *temporary_path = NULL;
+  FILE *f = NULL;
+  int written = 0;
+
+  if(!recording) {
+    return;
+  }
+
+  if(save) {
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+    header.version = IMAGE_VERSION;
+    header.opcode_count = OPCODE_COUNT;
+    header.source_hash = recording->hash;
+    header.source_size = recording->size;
+    header.unit_count = recording->unit_count;
+    header.strings_offset = sizeof(header) + recording->units.size;
+    header.image_size = header.strings_offset + recording->strings.size;
+
+    // Write a temporary file first so a concurrent run never maps half an image, it is named after the
+    // process and the interpreter because the same script may run in several processes and on several threads
+    temporary_path = malloc(strlen(recording->path) + 48);
+
+    if(!temporary_path) {
+      yyerror("out of space");
+      exit(0);
+    }
+
+    sprintf(temporary_path, "%s.%d.%p.tmp", recording->path, (int)getpid(), (void *)current_context);
+    f = fopen(temporary_path, "wb");
+
+    written = f && fwrite(&header, sizeof(header), 1, f) == 1
+      && fwrite(recording->units.data, 1, recording->units.size, f) == recording->units.size
+      && fwrite(recording->strings.data, 1, recording->strings.size, f) == recording->strings.size;
+
+    // The file is closed once whatever happened, a close that fails loses the buffered end of the image
+    if(f && fclose(f) != 0) {
+      written = 0;
+    }
+
+    if(written) {
+      rename(temporary_path, recording->path);
+      trace(TRACE_INFO, "Wrote compiled image %s.\n", recording->path);
+    } else {
+      unlink(temporary_path);
+      trace(TRACE_INFO, "Cannot write compiled image %s.\n", recording->path);
+    }
+
+    free(temporary_path);
+  }
+
+  free(recording->path);
+  buffer_free(&recording->units);
+  buffer_free(&recording->strings);
+  free(recording);
+  current_context->recording = NULL;
+}
+
+// Function to check a string offset and return the string, NULL if it is outside the image
+static char *image_string(char *image, struct image_header *header, uint32_t offset) {
+  if(offset >= header->image_size - header->strings_offset) {
+    return NULL;
+  }
+
+  return image + header->strings_offset + offset;
+}
+
+// Function to map the unit at offset to a program, relocating its global slots in place.
+// Returns 0 if the unit does not fit in the image.
+static int load_unit(char *image, struct image_header *header, size_t *offset, struct loaded_unit *loaded) {
+  struct image_unit *unit = NULL;
+  struct instruction *code = NULL;
+  struct image_constant *constants = NULL;
+  uint32_t *names = NULL;
+  uint32_t *globals = NULL;
+  struct program *program = NULL;
+  size_t end = *offset + sizeof(struct image_unit);
+
+  if(end > header->strings_offset) {
+    return 0;
+  }
+
+  unit = (struct image_unit *)(image + *offset);
+
+  // Work out where each section starts and check the unit ends before the strings
+  code = (struct instruction *)(image + end);
+  end += unit->code_count * sizeof(struct instruction);
+  end = (end + IMAGE_ALIGNMENT - 1) & ~(size_t)(IMAGE_ALIGNMENT - 1);
+  constants = (struct image_constant *)(image + end);
+  end += unit->constant_count * sizeof(struct image_constant);
+  names = (uint32_t *)(image + end);
+  end += unit->name_count * sizeof(uint32_t);
+  end = (end + IMAGE_ALIGNMENT - 1) & ~(size_t)(IMAGE_ALIGNMENT - 1);
+  globals = (uint32_t *)(image + end);
+  end += unit->global_count * sizeof(uint32_t);
+  end = (end + IMAGE_ALIGNMENT - 1) & ~(size_t)(IMAGE_ALIGNMENT - 1);
+
+  if(end > header->strings_offset || unit->code_count == 0 || unit->frame_size < unit->parameter_count) {
+    return 0;
+  }
+
+  program = calloc(1, sizeof(struct program));
+
+  if(!program) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  // The code runs straight from the mapping, only the pointer tables are built
+  program->mapped = 1;
+  program->code = code;
+  program->code_count = unit->code_count;
+  program->max_stack = unit->max_stack;
+  program->parameter_count = unit->parameter_count;
+  program->frame_size = unit->frame_size;
+  program->constant_count = unit->constant_count;
+  program->name_count = unit->name_count;
+  program->constants = malloc((unit->constant_count + 1) * sizeof(struct val));
+  program->names = malloc((unit->name_count + 1) * sizeof(char *));
+
+  if(!program->constants || !program->names) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  loaded->kind = unit->kind;
+  loaded->line = unit->line;
+  loaded->name = unit->kind == IMAGE_FUNCTION ? image_string(image, header, unit->name) : NULL;
+  loaded->program = program;
+
+  if(unit->kind == IMAGE_FUNCTION && !loaded->name) {
+    return 0;
+  }
+
+  for(uint32_t i = 0; i < unit->constant_count; i++) {
+    program->constants[i] = create_empty_value();
+    program->constants[i].type = constants[i].type;
+
+    if(constants[i].type == STRING_TYPE) {
+      if(!image_string(image, header, constants[i].string)) {
+        return 0;
+      }
+
+      // String constants are interned like the ones the scanner reads
+      program->constants[i] = create_string_value(image_string(image, header, constants[i].string));
+    } else if(constants[i].type == DECIMAL_TYPE) {
+      program->constants[i].datavalue.decimal = constants[i].decimal;
+    } else {
+      program->constants[i].datavalue.integer = constants[i].integer;
+    }
+  }
+
+  for(uint32_t i = 0; i < unit->name_count; i++) {
+    program->names[i] = image_string(image, header, names[i]);
+
+    if(!program->names[i]) {
+      return 0;
+    }
+  }
+
+  for(uint32_t i = 0; i < unit->code_count; i++) {
+    if(code[i].opcode < 0 || code[i].opcode >= OPCODE_COUNT) {
+      return 0;
+    }
+
+    if(has_global_operand(code[i].opcode)) {
+      if((uint32_t)code[i].a >= unit->global_count || !image_string(image, header, globals[code[i].a])) {
+        return 0;
+      }
+
+      code[i].a = lookup(image_string(image, header, globals[code[i].a])) - current_context->symtab;
+    }
+  }
+
+  *offset = end;
+  return 1;
+}
+
+// Function to run a script from its compiled image, returns 0 if the image is missing or stale
+int run_cached_script(char *source_path) {
+  struct image_header *header = NULL;
+  struct loaded_unit *loaded = NULL;
+  struct symbol *function = NULL;
+  struct stat status;
+  uint64_t source_hash = 0;
+  uint64_t source_size = 0;
+  size_t offset = sizeof(struct image_header);
+  char *path = NULL;
+  char *image = NULL;
+  uint32_t loaded_count = 0;
+  int fd = -1;
+
+  if(cache_disabled || !hash_file(source_path, &source_hash, &source_size)) {
+    return 0;
+  }
+
+  path = image_path(source_path);
+  fd = open(path, O_RDONLY);
+
+  if(fd < 0) {
+    free(path);
+    return 0;
+  }
+
+  if(fstat(fd, &status) < 0 || status.st_size < (off_t)sizeof(struct image_header)) {
+    close(fd);
+    free(path);
+    return 0;
+  }
+
+  // A private writable mapping lets the global slots be relocated without touching the file
+  image = mmap(NULL, status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if(image == MAP_FAILED) {
+    free(path);
+    return 0;
+  }
+
+  header = (struct image_header *)image;
+
+  if(memcmp(header->magic, IMAGE_MAGIC, sizeof(header->magic))
+     || header->version != IMAGE_VERSION
+     || header->opcode_count != OPCODE_COUNT
+     || header->source_hash != source_hash
+     || header->source_size != source_size
+     || header->image_size != (uint64_t)status.st_size
+     || header->strings_offset < sizeof(struct image_header)
+     || header->strings_offset > header->image_size
+     || (header->image_size > header->strings_offset && image[header->image_size - 1] != '\0')) {
+    trace(TRACE_INFO, "Compiled image %s is stale.\n", path);
+    munmap(image, status.st_size);
+    free(path);
+    return 0;
+  }
+
+  // Map every unit before running any, so a damaged image falls back before side effects
+  loaded = calloc(header->unit_count + 1, sizeof(struct loaded_unit));
+
+  if(!loaded) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  while(loaded_count < header->unit_count) {
+    if(!load_unit(image, header, &offset, &loaded[loaded_count])) {
+      trace(TRACE_INFO, "Compiled image %s is damaged.\n", path);
+
+      for(uint32_t i = 0; i <= loaded_count && i < header->unit_count; i++) {
+        free_program(loaded[i].program);
+      }
+
+      free(loaded);
+      munmap(image, status.st_size);
+      free(path);
+      return 0;
+    }
+
+    loaded_count++;
+  }
+
+  trace(TRACE_INFO, "Running compiled image %s.\n", path);
+
+  // Run the units in the order the script defined them, the image stays mapped for its strings
+  for(uint32_t i = 0; i < loaded_count; i++) {
+    current_context->line = loaded[i].line;
+
+    if(loaded[i].kind == IMAGE_FUNCTION) {
+      function = lookup(loaded[i].name);
+      free_program(function->code);
+      function->code = loaded[i].program;
+    } else {
+      run_program(loaded[i].program);
+      free_program(loaded[i].program);
+    }
+  }
+
+  free(loaded);
+  free(path);
+  return 1;
+}
@@ -0,0 +1,24 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "bytecode.h"
+
+// Function to run a script from its compiled image, returns 0 if the image is missing or stale
+int run_cached_script(char *source_path);
+
+// Function to start recording the compiled top-level units of a script
+void begin_script_cache(char *source_path);
+
+// Function to record a compiled top-level statement
+void cache_statement(struct program *program);
+
+// Function to record a compiled function definition
+void cache_function(char *name, struct program *program);
+
+// Function to write the recorded image next to the script, nothing is written if save is 0
+void end_script_cache(int save);
+
+// Set with --no-cache to always parse scripts
+extern int cache_disabled;
+
+#endif
@@ -1,4 +1,4 @@
 #!/bin/bash
 bison -d parser.y
 flex lexer.l
-gcc -Wall -lfl *.c -o learnpi -lm -lpigpio -lpthread;
\ No newline at end of file
+gcc -Wall -DLEARNPI_PIGPIO -lfl *.c -o learnpi -lm -lpigpio -lpthread;
\ No newline at end of file
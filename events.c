@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+
+#include "learnpi.h"
+#include "events.h"
+#include "backend.h"
+#include "trace.h"
+
+// Single producer, single consumer ring of level changes.
+// The producer is the pigpio alert thread, scripts on several threads share the consumer side
+// under consumer_lock. The simulation backend has no producer, its presses follow a virtual clock.
+static struct edge_event queue[EVENT_QUEUE_SIZE];
+static atomic_uint queue_head;  // next slot the producer writes
+static atomic_uint queue_tail;  // next slot the consumer reads
+static sem_t queue_semaphore;   // posted once for every queued event
+static atomic_uint dropped_events;
+
+// Last known level of every gpio, the buttons are pulled up so they idle high
+static atomic_int levels[MAX_GPIO];
+
+// Gpios reported by the event source
+static atomic_int watched[MAX_GPIO];
+
+static pthread_once_t initialized = PTHREAD_ONCE_INIT;
+
+// Function to queue a level change, called from the alert thread only
+void push_edge_event(unsigned gpio, int level, uint32_t tick) {
+  unsigned head = atomic_load_explicit(&queue_head, memory_order_relaxed);
+
+  if(gpio >= MAX_GPIO) {
+    return;
+  }
+
+  atomic_store_explicit(&levels[gpio], level, memory_order_relaxed);
+
+  // Keep the level but drop the edge if the interpreter is not keeping up
+  if(head - atomic_load_explicit(&queue_tail, memory_order_acquire) == EVENT_QUEUE_SIZE) {
+    atomic_fetch_add_explicit(&dropped_events, 1, memory_order_relaxed);
+    return;
+  }
+
+  queue[head & (EVENT_QUEUE_SIZE - 1)].gpio = gpio;
+  queue[head & (EVENT_QUEUE_SIZE - 1)].level = level;
+  queue[head & (EVENT_QUEUE_SIZE - 1)].tick = tick;
+  atomic_store_explicit(&queue_head, head + 1, memory_order_release);
+
+  sem_post(&queue_semaphore);
+}
+
+// Edges taken off the queue while waiting on another gpio, owned by the consumer
+static int pending_edges[MAX_GPIO][2];
+
+// One waiter sleeps on the semaphore, the others on edge_drained until it drains the queue
+static pthread_mutex_t consumer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t edge_drained = PTHREAD_COND_INITIALIZER;
+static int semaphore_waiter = 0;
+
+// Function to take the oldest level change off the queue, returns 0 if it is empty
+static int pop_edge_event(struct edge_event *event) {
+  unsigned tail = atomic_load_explicit(&queue_tail, memory_order_relaxed);
+
+  if(tail == atomic_load_explicit(&queue_head, memory_order_acquire)) {
+    return 0;
+  }
+
+  *event = queue[tail & (EVENT_QUEUE_SIZE - 1)];
+  atomic_store_explicit(&queue_tail, tail + 1, memory_order_release);
+
+  return 1;
+}
+
+// Function called by pigpio on every level change of a watched gpio
+static void alert_callback(int gpio, int level, uint32_t tick) {
+  // Level 2 is a watchdog timeout, not a level change
+  if(level == 2) {
+    return;
+  }
+
+  push_edge_event(gpio, level, tick);
+}
+
+// Function to wait for an edge from the alert thread, the hardware side of wait_for_edge
+static int wait_for_queued_edge(unsigned gpio, int level, int timeout_ms) {
+  struct edge_event event;
+  struct timespec deadline;
+
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += timeout_ms / 1000;
+  deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+  if(deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+
+  pthread_mutex_lock(&consumer_lock);
+
+  for(;;) {
+    // Edges of other gpios stay pending for their own waits
+    while(pop_edge_event(&event)) {
+      pending_edges[event.gpio][event.level ? 1 : 0]++;
+    }
+
+    if(pending_edges[gpio][level ? 1 : 0] > 0) {
+      pending_edges[gpio][level ? 1 : 0]--;
+      pthread_mutex_unlock(&consumer_lock);
+      return 1;
+    }
+
+    if(semaphore_waiter) {
+      // Another script sleeps on the semaphore and wakes everyone once it drained the queue
+      if(timeout_ms < 0) {
+        pthread_cond_wait(&edge_drained, &consumer_lock);
+      } else if(pthread_cond_timedwait(&edge_drained, &consumer_lock, &deadline) == ETIMEDOUT) {
+        pthread_mutex_unlock(&consumer_lock);
+        return 0;
+      }
+
+      continue;
+    }
+
+    semaphore_waiter = 1;
+    pthread_mutex_unlock(&consumer_lock);
+
+    int timed_out = 0;
+
+    if(timeout_ms < 0) {
+      while(sem_wait(&queue_semaphore) == -1 && errno == EINTR);
+    } else if(sem_timedwait(&queue_semaphore, &deadline) == -1 && errno == ETIMEDOUT) {
+      timed_out = 1;
+    }
+
+    // Hand the semaphore over, the other waiters check the drained edges or take it
+    pthread_mutex_lock(&consumer_lock);
+    semaphore_waiter = 0;
+    pthread_cond_broadcast(&edge_drained);
+
+    if(timed_out) {
+      pthread_mutex_unlock(&consumer_lock);
+      return 0;
+    }
+  }
+}
+
+// Function to read the virtual time of the current interpreter in microseconds
+uint64_t virtual_time_us() {
+  return current_context->clock.now_us;
+}
+
+// Function to advance the virtual time of the current interpreter, used instead of sleeping by the simulation backend.
+// The clock stops at every pattern edge and servo update on the way, so the backend sees each one at its own time.
+void advance_virtual_time(uint64_t us) {
+  struct virtual_clock *clock = &current_context->clock;
+  uint64_t until_us = clock->now_us + us;
+  uint64_t edge_us = 0;
+  uint64_t update_us = 0;
+
+  for(;;) {
+    edge_us = next_pattern_edge_us();
+    update_us = next_servo_update_us();
+
+    if(update_us < edge_us) {
+      edge_us = update_us;
+    }
+
+    if(edge_us > until_us) {
+      break;
+    }
+
+    clock->now_us = edge_us;
+    render_pattern(edge_us);
+    render_servos(edge_us);
+  }
+
+  clock->now_us = until_us;
+}
+
+// Function to set up the queue and the event source, run once on first use
+static void initialize_events() {
+  for(int i = 0; i < MAX_GPIO; i++) {
+    atomic_init(&levels[i], 1);
+    atomic_init(&watched[i], 0);
+  }
+
+  sem_init(&queue_semaphore, 0, 0);
+}
+
+// Function to start reporting level changes of a button gpio
+void watch_gpio(unsigned gpio) {
+  if(gpio >= MAX_GPIO) {
+    return;
+  }
+
+  pthread_once(&initialized, initialize_events);
+
+  if(gpio_backend->simulated) {
+    // Only edges after the button was declared reach the script
+    current_context->clock.edge_us[gpio][0] = current_context->clock.now_us;
+    current_context->clock.edge_us[gpio][1] = current_context->clock.now_us;
+  } else {
+    atomic_store(&levels[gpio], gpio_backend->read(gpio));
+  }
+
+  gpio_backend->watch(gpio, alert_callback);
+
+  atomic_store(&watched[gpio], 1);
+}
+
+// Function to read the last known level of a gpio without touching the hardware
+int cached_level(unsigned gpio) {
+  if(gpio >= MAX_GPIO) {
+    return -1;
+  }
+
+  if(gpio_backend->simulated) {
+    return simulated_level(current_context->clock.now_us);
+  }
+
+  return atomic_load_explicit(&levels[gpio], memory_order_relaxed);
+}
+
+// Function to wait until gpio changes to level, returns 0 on timeout, blocks forever if timeout_ms < 0
+int wait_for_edge(unsigned gpio, int level, int timeout_ms) {
+  if(gpio >= MAX_GPIO || !atomic_load(&watched[gpio])) {
+    return 0;
+  }
+
+  if(!gpio_backend->simulated) {
+    return wait_for_queued_edge(gpio, level, timeout_ms);
+  }
+
+  struct virtual_clock *clock = &current_context->clock;
+
+  // Edges that passed while the script was busy are taken in order, like queued events
+  uint64_t edge_us = next_simulated_edge(level, clock->edge_us[gpio][level ? 1 : 0]);
+
+  if(timeout_ms >= 0 && edge_us > clock->now_us + timeout_ms * 1000ULL) {
+    advance_virtual_time(timeout_ms * 1000ULL);
+    return 0;
+  }
+
+  clock->edge_us[gpio][level ? 1 : 0] = edge_us;
+
+  if(edge_us > clock->now_us) {
+    advance_virtual_time(edge_us - clock->now_us);
+  }
+
+  trace(TRACE_INFO, "Simulated edge to %d on gpio %u at %llu us.\n", level, gpio, (unsigned long long)edge_us);
+  return 1;
+}
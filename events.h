@@ -0,0 +1,34 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <stdint.h>
+
+#define MAX_GPIO 54
+#define EVENT_QUEUE_SIZE 256 // must be a power of two
+
+// Structure for a level change reported on a gpio
+struct edge_event {
+  unsigned gpio;
+  int level;
+  uint32_t tick;
+};
+
+// Function to start reporting level changes of a button gpio
+void watch_gpio(unsigned gpio);
+
+// Function to read the last known level of a gpio without touching the hardware
+int cached_level(unsigned gpio);
+
+// Function to queue a level change, called from the alert thread only
+void push_edge_event(unsigned gpio, int level, uint32_t tick);
+
+// Function to wait until gpio changes to level, returns 0 on timeout, blocks forever if timeout_ms < 0
+int wait_for_edge(unsigned gpio, int level, int timeout_ms);
+
+// Function to read the virtual time of the current interpreter in microseconds
+uint64_t virtual_time_us();
+
+// Function to advance the virtual time of the current interpreter, used instead of sleeping by the simulation backend
+void advance_virtual_time(uint64_t us);
+
+#endif
@@ -0,0 +1,228 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "learnpi.h"
+#include "functions.h"
+
+// Function to check if a type is a number
+static int is_number(int type) {
+  return type == INTEGER_TYPE || type == DECIMAL_TYPE;
+}
+
+// Function to check if a node is a constant of the given type and integer or bit value
+static int is_constant(struct ast *abstract_syntax_tree, int type, int value) {
+  struct constant_value *constant = (struct constant_value *)abstract_syntax_tree;
+
+  if(!abstract_syntax_tree || abstract_syntax_tree->nodetype != CONSTANT || constant->v.type != type) {
+    return 0;
+  }
+
+  return type == BIT_TYPE ? constant->v.datavalue.bit == value : constant->v.datavalue.integer == value;
+}
+
+// Function to check if an operation on constant operands runs without reporting an error
+static int folds_silently(int nodetype, struct val first, struct val second) {
+  switch(nodetype) {
+    case '+':
+    case '1':  case '2':  case '3':  case '4':  case '5':  case '6':
+      return is_number(first.type) || first.type == STRING_TYPE;
+
+    case '-':
+    case '*':
+    case '/':
+    case '|':
+    case UNARY_MINUS:
+      return is_number(first.type);
+
+    case LOGICAL_AND:
+    case LOGICAL_OR:
+      return first.type == BIT_TYPE && second.type == BIT_TYPE;
+
+    default:
+      return 0;
+  }
+}
+
+// Function to run an operation on constant operands with the same functions the interpreter uses
+static struct val fold_operation(int nodetype, struct val first, struct val second) {
+  switch(nodetype) {
+    case '+': return sum(first, second);
+    case '-': return subtract(first, second);
+    case '*': return multiply(first, second);
+    case '/': return divide(first, second);
+    case '|': return get_absolute_value(first);
+    case UNARY_MINUS: return change_sign(first);
+    case LOGICAL_AND: return calculate_logical_and(first, second);
+    case LOGICAL_OR: return calculate_logical_or(first, second);
+    case '1': return calculate_greater_than(first, second);
+    case '2': return calculate_less_than(first, second);
+    case '3': return calculate_not_equals(first, second);
+    case '4': return calculate_equals(first, second);
+    case '5': return calculate_greater_equal_than(first, second);
+    case '6': return calculate_less_equal_than(first, second);
+    default: return create_empty_value();
+  }
+}
+
+// Function to drop the operations that do not change their other operand, like x*1 or x+0
+static struct ast *simplify_identity(struct ast *abstract_syntax_tree) {
+  struct ast *l = abstract_syntax_tree->l;
+  struct ast *r = abstract_syntax_tree->r;
+
+  switch(abstract_syntax_tree->nodetype) {
+    case '+':
+      if(is_constant(r, INTEGER_TYPE, 0) && is_number(static_type(l))) return l;
+      if(is_constant(l, INTEGER_TYPE, 0) && is_number(static_type(r))) return r;
+      break;
+
+    case '-':
+      if(is_constant(r, INTEGER_TYPE, 0) && is_number(static_type(l))) return l;
+      break;
+
+    case '*':
+      if(is_constant(r, INTEGER_TYPE, 1) && is_number(static_type(l))) return l;
+      if(is_constant(l, INTEGER_TYPE, 1) && is_number(static_type(r))) return r;
+      break;
+
+    case '/':
+      if(is_constant(r, INTEGER_TYPE, 1) && is_number(static_type(l))) return l;
+      break;
+
+    case LOGICAL_AND:
+      if(is_constant(r, BIT_TYPE, 1) && static_type(l) == BIT_TYPE) return l;
+      if(is_constant(l, BIT_TYPE, 1) && static_type(r) == BIT_TYPE) return r;
+      break;
+
+    case LOGICAL_OR:
+      if(is_constant(r, BIT_TYPE, 0) && static_type(l) == BIT_TYPE) return l;
+      if(is_constant(l, BIT_TYPE, 0) && static_type(r) == BIT_TYPE) return r;
+      break;
+  }
+
+  return abstract_syntax_tree;
+}
+
+// Function to fold square_root of a constant number
+static struct ast *fold_builtin(struct builtin_function_call *builtin_function_call) {
+  struct ast *argument = builtin_function_call->argument_list;
+
+  if(builtin_function_call->function_type != BUILT_IN_SQUARE_ROOT || !argument || argument->nodetype != CONSTANT) {
+    return (struct ast *)builtin_function_call;
+  }
+
+  if(!is_number(((struct constant_value *)argument)->v.type)) {
+    return (struct ast *)builtin_function_call;
+  }
+
+  return new_value(square_root(((struct constant_value *)argument)->v));
+}
+
+// Function to fold the constant subtrees of an AST, returns the node to use in its place
+struct ast *fold(struct ast *abstract_syntax_tree) {
+  struct flow *flow = NULL;
+  struct for_flow *for_flow = NULL;
+  struct val first;
+  struct val second;
+
+  if(!abstract_syntax_tree) {
+    return NULL;
+  }
+
+  switch(abstract_syntax_tree->nodetype) {
+    case CONSTANT:
+    case NEW_REFERENCE:
+    case DECLARATION:
+      break;
+
+    case ASSIGNMENT:
+      ((struct assign_symbol *)abstract_syntax_tree)->v = fold(((struct assign_symbol *)abstract_syntax_tree)->v);
+      break;
+
+    case DECLARATION_WITH_ASSIGNMENT:
+      ((struct assign_and_declare_symbol *)abstract_syntax_tree)->value = fold(((struct assign_and_declare_symbol *)abstract_syntax_tree)->value);
+      break;
+
+    case COMPLEX_ASSIGNMENT:
+      ((struct assign_and_declare_complex_symbol *)abstract_syntax_tree)->value = fold(((struct assign_and_declare_complex_symbol *)abstract_syntax_tree)->value);
+      break;
+
+    case STATEMENT_LIST:
+      abstract_syntax_tree->l = fold(abstract_syntax_tree->l);
+      abstract_syntax_tree->r = fold(abstract_syntax_tree->r);
+      break;
+
+    case '+':
+    case '-':
+    case '*':
+    case '/':
+    case LOGICAL_AND:
+    case LOGICAL_OR:
+    case '1':  case '2':  case '3':  case '4':  case '5':  case '6':
+      abstract_syntax_tree->l = fold(abstract_syntax_tree->l);
+      abstract_syntax_tree->r = fold(abstract_syntax_tree->r);
+
+      if(abstract_syntax_tree->l->nodetype == CONSTANT && abstract_syntax_tree->r->nodetype == CONSTANT) {
+        first = ((struct constant_value *)abstract_syntax_tree->l)->v;
+        second = ((struct constant_value *)abstract_syntax_tree->r)->v;
+
+        if(folds_silently(abstract_syntax_tree->nodetype, first, second)) {
+          return new_value(fold_operation(abstract_syntax_tree->nodetype, first, second));
+        }
+      }
+
+      return simplify_identity(abstract_syntax_tree);
+
+    case '|':
+    case UNARY_MINUS:
+      abstract_syntax_tree->l = fold(abstract_syntax_tree->l);
+
+      if(abstract_syntax_tree->l->nodetype == CONSTANT) {
+        first = ((struct constant_value *)abstract_syntax_tree->l)->v;
+
+        if(folds_silently(abstract_syntax_tree->nodetype, first, first)) {
+          return new_value(fold_operation(abstract_syntax_tree->nodetype, first, first));
+        }
+      }
+      break;
+
+    case IF_STATEMENT:
+      flow = (struct flow *)abstract_syntax_tree;
+      flow->condition = fold(flow->condition);
+      flow->then_list = fold(flow->then_list);
+      flow->else_list = fold(flow->else_list);
+
+      // A constant condition keeps only the branch that runs, anything but a bit still fails at run time
+      if(flow->condition->nodetype == CONSTANT && ((struct constant_value *)flow->condition)->v.type == BIT_TYPE) {
+        if(((struct constant_value *)flow->condition)->v.datavalue.bit) {
+          return flow->then_list ? flow->then_list : new_value(create_empty_value());
+        }
+
+        return flow->else_list ? flow->else_list : new_value(create_empty_value());
+      }
+      break;
+
+    case LOOP_STATEMENT:
+      flow = (struct flow *)abstract_syntax_tree;
+      flow->condition = fold(flow->condition);
+      flow->then_list = fold(flow->then_list);
+      break;
+
+    case FOR_STATEMENT:
+      for_flow = (struct for_flow *)abstract_syntax_tree;
+      for_flow->initialization = fold(for_flow->initialization);
+      for_flow->condition = fold(for_flow->condition);
+      for_flow->then_list = fold(for_flow->then_list);
+      for_flow->else_list = fold(for_flow->else_list);
+      break;
+
+    case BUILTIN_TYPE:
+      ((struct builtin_function_call *)abstract_syntax_tree)->argument_list = fold(((struct builtin_function_call *)abstract_syntax_tree)->argument_list);
+      return fold_builtin((struct builtin_function_call *)abstract_syntax_tree);
+
+    case USER_CALL:
+      ((struct user_function_call *)abstract_syntax_tree)->argument_list = fold(((struct user_function_call *)abstract_syntax_tree)->argument_list);
+      break;
+  }
+
+  return abstract_syntax_tree;
+}
@@ -1,7 +1,10 @@
 #define _GNU_SOURCE
 #include "learnpi.h"
 #include "functions.h"
-#include <pigpio.h>
+#include "trace.h"
+#include "events.h"
+#include "gpio_batch.h"
+#include "backend.h"
 #include <stdarg.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -9,28 +12,33 @@
 #include <unistd.h>
 #include <math.h>
 
+int trace_level = TRACE_NONE;
+
 void yyerror(char *s, ...) {
-  printf("yyerror\n");
+  trace(TRACE_DEBUG, "yyerror\n");
   va_list ap;
   va_start(ap, s);
 
-  fprintf(stderr, "%d: error: ", yylineno);
+  fprintf(stderr, "%d: error: ", current_line());
   vfprintf(stderr, s, ap);
   fprintf(stderr, "\n");
+  va_end(ap);
 }
 
-int get_value_type(struct val *value) {
-	if(value) {
-  	    return value->type;
-	} else {
-		return -1;
-	}
+void trace_print(char *s, ...) {
+  va_list ap;
+  va_start(ap, s);
+
+  vfprintf(stderr, s, ap);
+  va_end(ap);
 }
 
-struct val *print_type(struct val *value) {
-    struct val *result = malloc(sizeof(struct val));
+int get_value_type(struct val value) {
+    return value.type;
+}
 
-    switch (value->type) {
+struct val print_type(struct val value) {
+    switch (value.type) {
         case BIT_TYPE:
             printf("Value has BIT_TYPE.\n");
             break;
@@ -72,674 +80,676 @@ struct val *print_type(struct val *value) {
             break;
     }
 
-    return result; 
+    return create_empty_value();
 }
 
-struct val *square_root(struct val *value) {
-    struct val *result = malloc(sizeof(struct val));
+struct val square_root(struct val value) {
+    struct val result;
 
-    result->type = DECIMAL_TYPE;
-    if(value->type == INTEGER_TYPE) {
-        result->datavalue.decimal = sqrt((double)(value->datavalue.integer));    
+    result.type = DECIMAL_TYPE;
+    if(value.type == INTEGER_TYPE) {
+        result.datavalue.decimal = sqrt((double)(value.datavalue.integer));    
     } else {
-        result->datavalue.decimal = sqrt(value->datavalue.decimal);
+        result.datavalue.decimal = sqrt(value.datavalue.decimal);
     }
     
     return result;
 }
 
-struct val *create_LED(struct val ** pin) {
-    struct val *result;
+struct val create_LED(struct val * pin) {
+    struct val result;
     result = create_complex_value(pin, 1, LED);
 
+    if(result.type == NO_TYPE) {
+        return result;
+    }
+
     int currentMode = -1;
 
     // Set the current mode to output
-    #ifdef RPI_SIMULATION
-        currentMode = gpioSetMode(result->datavalue.GPIO_PIN[0], 1);
-    #else
+    if(gpio_backend->simulated) {
         printf("Simulated gpioSetMode function after LED creation.\n");
-        currentMode = 0;
-    #endif
+    }
+    currentMode = gpio_backend->set_mode(result.datavalue.GPIO_PIN[0], PI_OUTPUT);
 
     // Check errors
     if(currentMode != 0) {
         printf("PI_BAD_GPIO or PI_BAD_LEVEL!\n");
-        return NULL;        
+        return create_empty_value();        
     }
     
     return result;
 }
 
-struct val *create_BUTTON(struct val ** pin) {
-    struct val *result;
+struct val create_BUTTON(struct val * pin) {
+    struct val result;
     result = create_complex_value(pin, 1, BUTTON);
 
+    if(result.type == NO_TYPE) {
+        return result;
+    }
+
     int currentMode = -1;
     int pullUpLevel = -1;
 
-    // Set the current mode to output and PULL_UP to HIGH
-    #ifdef RPI_SIMULATION
-        currentMode = gpioSetMode(result->datavalue.GPIO_PIN[0], 0);
-        pullUpLevel = gpioSetPullUpDown(result->datavalue.GPIO_PIN[0], PI_PUD_UP)
-    #else
+    // Set the current mode to input and PULL_UP to HIGH
+    if(gpio_backend->simulated) {
         printf("Simulated gpioSetMode and gpioSetPullUpDown functions after BUTTON creation.\n");
-        currentMode = 0;
-        pullUpLevel = 2;
-    #endif
+    }
+    currentMode = gpio_backend->set_mode(result.datavalue.GPIO_PIN[0], PI_INPUT);
+    pullUpLevel = gpio_backend->set_pull(result.datavalue.GPIO_PIN[0], PI_PUD_UP);
 
     // Check errors
-    if(currentMode != 0 || pullUpLevel != 2) {
+    if(currentMode != 0 || pullUpLevel != 0) {
         printf("PI_BAD_GPIO or PI_BAD_LEVEL!\n");
-        return NULL;        
+        return create_empty_value();        
     }
+
+    // Keep the level of the button up to date from edge events instead of polling
+    watch_gpio(result.datavalue.GPIO_PIN[0]);
     
     return result;
 }
 
-struct val *create_KEYPAD(struct val ** pin) {
-    struct val *result;
+struct val create_KEYPAD(struct val * pin) {
+    struct val result;
     result = create_complex_value(pin, 8, KEYPAD);
-    
-    int currentMode = -1;
-    int pullUpLevel = -1;
-    int writeResult = -1;
 
-    // Set the first 4 pins to input mode and PULL_UP to HIGH
-    #ifdef RPI_SIMULATION
-        for(int i = 0; i < 4; i++) {
-            currentMode = gpioSetMode(result->datavalue.GPIO_PIN[0], 0);
-            pullUpDnControl(result->datavalue.GPIO_PIN[i], PI_PUD_UP);
-        }
+    if(result.type == NO_TYPE) {
+        return result;
+    }
 
-        // Set the last 4 pins to output mode and write 1
-        for (int i = 4; i < 8; i++) {
-            currentMode = gpioSetMode(result->datavalue.GPIO_PIN[0], 1);
-            gpioWrite(result->datavalue.GPIO_PIN[0], 1);
-        }
-    #else
+    int status = 0;
+
+    // The first 4 pins are rows, inputs pulled up to HIGH, the last 4 are columns, outputs held HIGH
+    if(gpio_backend->simulated) {
         printf("Simulated gpioSetMode and gpioSetPullUpDown functions after KEYPAD creation.\n");
-        currentMode = 1;
-        pullUpLevel = 1;
-        writeResult = 0;
-    #endif
+    }
+
+    for(int i = 0; i < 4 && status == 0; i++) {
+        status = gpio_backend->set_mode(result.datavalue.GPIO_PIN[i], PI_INPUT);
+        if(status == 0) status = gpio_backend->set_pull(result.datavalue.GPIO_PIN[i], PI_PUD_UP);
+    }
 
-    // Check errors upon writing pins
-    if(writeResult != 0  || pullUpLevel != 1 || writeResult != 0 || currentMode != 1) {
+    for(int i = 4; i < 8 && status == 0; i++) {
+        status = gpio_backend->set_mode(result.datavalue.GPIO_PIN[i], PI_OUTPUT);
+        if(status == 0) status = gpio_backend->write(result.datavalue.GPIO_PIN[i], 1);
+    }
+
+    // Check errors upon setting up the pins
+    if(status != 0) {
         printf("PI_BAD_GPIO or PI_BAD_LEVEL!\n");
-        return NULL;
+        return create_empty_value();
+    }
+
+    // The scanner thread reads the keys from now on
+    if(start_keypad(result.datavalue.GPIO_PIN) != 0) {
+        yyerror("Too many keypads, at most %d can be scanned.", MAX_KEYPADS);
+        return create_empty_value();
     }
 
     return result;
 }
 
-struct val *create_BUZZER(struct val ** pin) {
-    struct val *result;
+struct val create_BUZZER(struct val * pin) {
+    struct val result;
     result = create_complex_value(pin, 1, BUZZER);
 
+    if(result.type == NO_TYPE) {
+        return result;
+    }
+
     int currentMode = -1;
 
     // Set the current mode to output
-    #ifdef RPI_SIMULATION
-        currentMode = gpioSetMode(result->datavalue.GPIO_PIN[0], 0);
-    #else
+    if(gpio_backend->simulated) {
         printf("Simulated gpioSetMode function after BUZZER creation.\n");
-        currentMode = 0;
-    #endif
+    }
+    currentMode = gpio_backend->set_mode(result.datavalue.GPIO_PIN[0], PI_OUTPUT);
 
     // Check errors
     if(currentMode != 0) {
         printf("PI_BAD_GPIO or PI_BAD_LEVEL!\n");
-        return NULL;        
+        return create_empty_value();        
     }
     
     return result;
 }
 
-struct val *create_SERVO_MOTOR(struct val ** pin) {
-    struct val *result;
+struct val create_SERVO_MOTOR(struct val * pin, int number_of_arguments) {
+    struct val result;
     result = create_complex_value(pin, 1, SERVO_MOTOR);
-    
-    int currentMode = -1;
-    int pwmStatus = -1;
-    int range = -1;
-    int frequency = -1;
-
-    // Set the first 4 pins to input mode and PULL_UP to HIGH
-    #ifdef RPI_SIMULATION
-        currentMode = gpioSetMode(result->datavalue.GPIO_PIN[0], 2);
-        
-        range = gpioSetPWMrange(result->datavalue.GPIO_PIN[0], 2000); // Fully on
-        frequency = gpioSetPWMfrequency(24, 500);
-        pwmStatus = gpioPWM(result->datavalue.GPIO_PIN[0], 0); // 0 degrees as default
-    #else
-        printf("Simulated gpioSetMode, gpioSetPWMrange, gpioSetPWMfrequency and gpioPWM functions after SERVO_MOTOR creation.\n");
-        currentMode = 2;
-        
-        range = 0;
-        frequency = 500;
-        pwmStatus = 0;
-    #endif
-
-    // Check errors upon writing pins
-    if(pwmStatus != 0 || currentMode != 2 || frequency != 500 || range != 0) {
-        printf("PI_BAD_GPIO or PI_BAD_LEVEL!\n");
-        return NULL;
+
+    if(result.type == NO_TYPE) {
+        return result;
+    }
+
+    // The pulse widths of 0 and 180 degrees follow the pin, the range of gpioServo by default
+    int min_us = SERVO_MIN_PULSE_US;
+    int max_us = SERVO_MAX_PULSE_US;
+
+    if(number_of_arguments == 3) {
+        min_us = pin[1].type == INTEGER_TYPE ? pin[1].datavalue.integer : 0;
+        max_us = pin[2].type == INTEGER_TYPE ? pin[2].datavalue.integer : 0;
+    } else if(number_of_arguments != 1) {
+        yyerror("A servo takes a pin, or a pin and the pulse widths of 0 and %d degrees.", SERVO_MAX_ANGLE);
+        return create_empty_value();
+    }
+
+    if(min_us < SERVO_MIN_PULSE_US || max_us > SERVO_MAX_PULSE_US || min_us >= max_us) {
+        yyerror("Pulse widths should be integers from %d to %d microseconds, the first one smaller.", SERVO_MIN_PULSE_US, SERVO_MAX_PULSE_US);
+        return create_empty_value();
+    }
+
+    if(gpio_backend->simulated) {
+        printf("Simulated gpioServo function after SERVO_MOTOR creation.\n");
+    }
+
+    // Hold the servo at 0 degrees
+    if(attach_servo(result.datavalue.GPIO_PIN[0], min_us, max_us) != 0) {
+        printf("PI_BAD_GPIO or PI_BAD_PULSEWIDTH!\n");
+        return create_empty_value();
     }
 
     return result;
 }
 
-struct val *create_COMPLEXTYPE(struct val ** pin, int pin_no, int datatype) {
-    // Allocate memory 
-    struct val *result = malloc(sizeof(struct val));
+struct val create_COMPLEXTYPE(struct val * pin, int pin_no, int datatype) {
+    struct val result = create_empty_value();
 
     // Local helper
     int i = 0;
     unsigned int current;
 
     // Assign the argument datatype to result type    
-    result->type = datatype;
-    result->datavalue.GPIO_PIN = malloc(pin_no * sizeof(int));
+    result.type = datatype;
+    result.datavalue.GPIO_PIN = malloc(pin_no * sizeof(int));
 
     while(i < pin_no) {
-        current = (unsigned int)pin[i]->datavalue.GPIO_PIN;
+        current = (unsigned int)pin[i].datavalue.integer;
         if(current < 0 || current > 50) {
-            yyerror("invalid value %d for pin declaration", pin[i]->datavalue.GPIO_PIN);
-            free(result);
-            break;
+            yyerror("invalid value %d for pin declaration", pin[i].datavalue.integer);
+            free(result.datavalue.GPIO_PIN);
+            return create_empty_value();
         }
 
-        result->datavalue.GPIO_PIN[i] = current;
+        result.datavalue.GPIO_PIN[i] = current;
         i =+ 1;
     }
     return result;
 }
 
-struct val *sum(struct val *first, struct val *second) {
-    struct val *result = malloc(sizeof(struct val));
+struct val sum(struct val first, struct val second) {
+    struct val result = create_empty_value();
 
     switch(get_value_type(first)) {
         case INTEGER_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->type = INTEGER_TYPE;
-                result->datavalue.integer = first->datavalue.integer + second->datavalue.integer;
+                result.type = INTEGER_TYPE;
+                result.datavalue.integer = first.datavalue.integer + second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->type = DECIMAL_TYPE;
-                result->datavalue.decimal = first->datavalue.integer + second->datavalue.decimal;
+                result.type = DECIMAL_TYPE;
+                result.datavalue.decimal = first.datavalue.integer + second.datavalue.decimal;
             }
             break;
         case DECIMAL_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->type = DECIMAL_TYPE;
-                result->datavalue.decimal = first->datavalue.decimal + second->datavalue.integer;
+                result.type = DECIMAL_TYPE;
+                result.datavalue.decimal = first.datavalue.decimal + second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->type = DECIMAL_TYPE;
-                result->datavalue.decimal = first->datavalue.decimal + second->datavalue.decimal;
+                result.type = DECIMAL_TYPE;
+                result.datavalue.decimal = first.datavalue.decimal + second.datavalue.decimal;
             }
             break;
         case STRING_TYPE:
             if(get_value_type(second) == STRING_TYPE) {
-                result->type = STRING_TYPE;
-                asprintf(&result->datavalue.string, "%s%s", first->datavalue.string, second->datavalue.string);
+                result = concatenate_strings(first, second);
             }
             break;
         default:
             yyerror("Sum error between types.");
-            free(result);
-            return NULL;
+            return create_empty_value();
     }
 
     return result;
 }
 
-struct val *subtract(struct val *first, struct val *second) {
-    struct val *result = malloc(sizeof(struct val));
+struct val subtract(struct val first, struct val second) {
+    struct val result = create_empty_value();
 
     switch(get_value_type(first)) {
         case INTEGER_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->type = INTEGER_TYPE;
-                result->datavalue.integer = first->datavalue.integer - second->datavalue.integer;
+                result.type = INTEGER_TYPE;
+                result.datavalue.integer = first.datavalue.integer - second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->type = DECIMAL_TYPE;
-                result->datavalue.decimal = first->datavalue.integer - second->datavalue.decimal;
+                result.type = DECIMAL_TYPE;
+                result.datavalue.decimal = first.datavalue.integer - second.datavalue.decimal;
             }
             break;
         case DECIMAL_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->type = DECIMAL_TYPE;
-                result->datavalue.decimal = first->datavalue.decimal - second->datavalue.integer;
+                result.type = DECIMAL_TYPE;
+                result.datavalue.decimal = first.datavalue.decimal - second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->type = DECIMAL_TYPE;
-                result->datavalue.decimal = first->datavalue.decimal - second->datavalue.decimal;
+                result.type = DECIMAL_TYPE;
+                result.datavalue.decimal = first.datavalue.decimal - second.datavalue.decimal;
             }
             break;
         default:
             yyerror("Subtraction error between types.");
-            free(result);
-            return NULL;
+            return create_empty_value();
     }
 
     return result;
 }
 
-struct val *multiply(struct val *first, struct val *second) {
-    struct val *result = malloc(sizeof(struct val));
+struct val multiply(struct val first, struct val second) {
+    struct val result = create_empty_value();
 
     switch(get_value_type(first)) {
         case INTEGER_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->type = INTEGER_TYPE;
-                result->datavalue.integer = first->datavalue.integer * second->datavalue.integer;
+                result.type = INTEGER_TYPE;
+                result.datavalue.integer = first.datavalue.integer * second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->type = DECIMAL_TYPE;
-                result->datavalue.decimal = first->datavalue.integer * second->datavalue.decimal;
+                result.type = DECIMAL_TYPE;
+                result.datavalue.decimal = first.datavalue.integer * second.datavalue.decimal;
             }
             break;
         case DECIMAL_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->type = DECIMAL_TYPE;
-                result->datavalue.decimal = first->datavalue.decimal * second->datavalue.integer;
+                result.type = DECIMAL_TYPE;
+                result.datavalue.decimal = first.datavalue.decimal * second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->type = DECIMAL_TYPE;
-                result->datavalue.decimal = first->datavalue.decimal * second->datavalue.decimal;
+                result.type = DECIMAL_TYPE;
+                result.datavalue.decimal = first.datavalue.decimal * second.datavalue.decimal;
             }
             break;
         default:
             yyerror("Multiplication error between types.");
-            free(result);
-            return NULL;
+            return create_empty_value();
     }
 
     return result;
 }
 
-struct val *divide(struct val *first, struct val *second) {
-    struct val *result = malloc(sizeof(struct val));
+struct val divide(struct val first, struct val second) {
+    struct val result = create_empty_value();
 
     switch(get_value_type(first)) {
         case INTEGER_TYPE:
-            if(get_value_type(second) == INTEGER_TYPE && second->datavalue.integer != 0) {
-                if(first->datavalue.integer % second->datavalue.integer == 0) {
-                    result->type = INTEGER_TYPE;
-                    result->datavalue.integer = first->datavalue.integer / second->datavalue.integer;
+            if(get_value_type(second) == INTEGER_TYPE && second.datavalue.integer != 0) {
+                if(first.datavalue.integer % second.datavalue.integer == 0) {
+                    result.type = INTEGER_TYPE;
+                    result.datavalue.integer = first.datavalue.integer / second.datavalue.integer;
                 } else {
-                    result->type = DECIMAL_TYPE;
-                    result->datavalue.decimal = (double)first->datavalue.integer / (double)second->datavalue.integer;
+                    result.type = DECIMAL_TYPE;
+                    result.datavalue.decimal = (double)first.datavalue.integer / (double)second.datavalue.integer;
                 }
-            } else if(get_value_type(second) == DECIMAL_TYPE  && second->datavalue.decimal != 0) {
-                result->type = DECIMAL_TYPE;
-                result->datavalue.decimal = (double)first->datavalue.integer / second->datavalue.decimal;
+            } else if(get_value_type(second) == DECIMAL_TYPE  && second.datavalue.decimal != 0) {
+                result.type = DECIMAL_TYPE;
+                result.datavalue.decimal = (double)first.datavalue.integer / second.datavalue.decimal;
             }
             break;
         case DECIMAL_TYPE:
-            if(get_value_type(second) == INTEGER_TYPE  && second->datavalue.integer != 0) {
-                result->type = DECIMAL_TYPE;
-                result->datavalue.decimal = first->datavalue.decimal / (double)second->datavalue.integer;
-            } else if(get_value_type(second) == DECIMAL_TYPE  && second->datavalue.decimal != 0) {
-                result->type = DECIMAL_TYPE;
-                result->datavalue.decimal = first->datavalue.decimal / second->datavalue.decimal;
+            if(get_value_type(second) == INTEGER_TYPE  && second.datavalue.integer != 0) {
+                result.type = DECIMAL_TYPE;
+                result.datavalue.decimal = first.datavalue.decimal / (double)second.datavalue.integer;
+            } else if(get_value_type(second) == DECIMAL_TYPE  && second.datavalue.decimal != 0) {
+                result.type = DECIMAL_TYPE;
+                result.datavalue.decimal = first.datavalue.decimal / second.datavalue.decimal;
             }
             break;
         default:
             yyerror("Division error between types.");
-            free(result);
-            return NULL;
+            return create_empty_value();
     }
 
     return result;
 }
 
-struct val *get_absolute_value(struct val *value) {
-    struct val *result = malloc(sizeof(struct val));
+struct val get_absolute_value(struct val value) {
+    struct val result = create_empty_value();
 
     switch (get_value_type(value)) {
         case INTEGER_TYPE:
-            if(value->datavalue.integer < 0) {
-                result->datavalue.integer = -(value->datavalue.integer);
+            if(value.datavalue.integer < 0) {
+                result.datavalue.integer = -(value.datavalue.integer);
             } else {
-                result->datavalue.integer = value->datavalue.integer;
+                result.datavalue.integer = value.datavalue.integer;
             }
             break;
         case DECIMAL_TYPE:
-            if(value->datavalue.integer < 0) {
-                result->datavalue.decimal = -(value->datavalue.decimal);
+            if(value.datavalue.decimal < 0) {
+                result.datavalue.decimal = -(value.datavalue.decimal);
             } else {
-                result->datavalue.decimal = value->datavalue.decimal;
+                result.datavalue.decimal = value.datavalue.decimal;
             }
             break;
         default:
             yyerror("Absolute value error");
-            free(result);
+            return create_empty_value();
     }
 
-    result->type = get_value_type(value);
+    result.type = get_value_type(value);
     return result;
 }
 
-struct val *change_sign(struct val *value) {
-    struct val *result = malloc(sizeof(struct val));
+struct val change_sign(struct val value) {
+    struct val result = create_empty_value();
     
     switch (get_value_type(value)) {
         case INTEGER_TYPE:
-            result->datavalue.integer = -(value->datavalue.integer);
+            result.datavalue.integer = -(value.datavalue.integer);
             break;
         case DECIMAL_TYPE:
-            result->datavalue.decimal = -(value->datavalue.decimal);
+            result.datavalue.decimal = -(value.datavalue.decimal);
             break;
         default:
             yyerror("Sign change error");
-            free(result);
+            return create_empty_value();
     }
 
-    result->type = get_value_type(value);
+    result.type = get_value_type(value);
     return result;
 }
 
-struct val *calculate_logical_and(struct val *first, struct val *second) {
-    struct val * result = malloc(sizeof(struct val));
+struct val calculate_logical_and(struct val first, struct val second) {
+    struct val result = create_bit_value(0);
 
     if(get_value_type(first) == BIT_TYPE && get_value_type(second) == BIT_TYPE) {
-        result->type = BIT_TYPE;
-        result->datavalue.bit = first->datavalue.bit && second->datavalue.bit;
+        result.type = BIT_TYPE;
+        result.datavalue.bit = first.datavalue.bit && second.datavalue.bit;
     } else {
         yyerror("Logical AND error");
-        free(result);
+        return create_empty_value();
     }
 
     return result;  
 }
 
-struct val *calculate_logical_or(struct val *first, struct val *second) {
-    struct val * result = malloc(sizeof(struct val));
+struct val calculate_logical_or(struct val first, struct val second) {
+    struct val result = create_bit_value(0);
 
     if(get_value_type(first) == BIT_TYPE && get_value_type(second) == BIT_TYPE) {
-        result->type = BIT_TYPE;
-        result->datavalue.bit = first->datavalue.bit || second->datavalue.bit;
+        result.type = BIT_TYPE;
+        result.datavalue.bit = first.datavalue.bit || second.datavalue.bit;
     } else {
         yyerror("Logical OR error");
-        free(result);
+        return create_empty_value();
     }
 
     return result; 
 }
 
-struct val *calculate_greater_than(struct val *first, struct val *second) {
-    struct val * result = malloc(sizeof(struct val));
+struct val calculate_greater_than(struct val first, struct val second) {
+    struct val result = create_bit_value(0);
     int helper;
 
     switch(get_value_type(first)) {
         case INTEGER_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->datavalue.bit = first->datavalue.integer > second->datavalue.integer;
+                result.datavalue.bit = first.datavalue.integer > second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->datavalue.bit = first->datavalue.integer > second->datavalue.decimal;
+                result.datavalue.bit = first.datavalue.integer > second.datavalue.decimal;
             }
             break;
         case DECIMAL_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->datavalue.bit = first->datavalue.decimal > second->datavalue.integer;
+                result.datavalue.bit = first.datavalue.decimal > second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->datavalue.bit = first->datavalue.decimal > second->datavalue.decimal;
+                result.datavalue.bit = first.datavalue.decimal > second.datavalue.decimal;
             }
             break;
         case STRING_TYPE:
             if(get_value_type(second) == STRING_TYPE) {
                 // String comparision
-                helper = strcmp(first->datavalue.string, second->datavalue.string);
+                helper = compare_strings(first, second);
 
                 // Check if strings are equal
                 if(helper == 1) {
-                    result->datavalue.bit = 1;
+                    result.datavalue.bit = 1;
                 } else {
-                    result->datavalue.bit = 0;
+                    result.datavalue.bit = 0;
                 }
             }
             break;
         default:
             yyerror("Cannot calculate if greater than.");
-            free(result);
+            return create_empty_value();
     }
 
-    result->type = BIT_TYPE;
+    result.type = BIT_TYPE;
     return result;
 }
 
-struct val *calculate_less_than(struct val *first, struct val *second) {
-    struct val * result = malloc(sizeof(struct val));
+struct val calculate_less_than(struct val first, struct val second) {
+    struct val result = create_bit_value(0);
     int helper;
 
     switch(get_value_type(first)) {
         case INTEGER_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->datavalue.bit = first->datavalue.integer < second->datavalue.integer;
+                result.datavalue.bit = first.datavalue.integer < second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->datavalue.bit = first->datavalue.integer < second->datavalue.decimal;
+                result.datavalue.bit = first.datavalue.integer < second.datavalue.decimal;
             }
             break;
         case DECIMAL_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->datavalue.bit = first->datavalue.decimal < second->datavalue.integer;
+                result.datavalue.bit = first.datavalue.decimal < second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->datavalue.bit = first->datavalue.decimal < second->datavalue.decimal;
+                result.datavalue.bit = first.datavalue.decimal < second.datavalue.decimal;
             }
             break;
         case STRING_TYPE:
             if(get_value_type(second) == STRING_TYPE) {
                 // String comparision
-                helper = strcmp(first->datavalue.string, second->datavalue.string);
+                helper = compare_strings(first, second);
 
                 // Check if strings are equal
                 if(helper == -1) {
-                    result->datavalue.bit = 1;
+                    result.datavalue.bit = 1;
                 } else {
-                    result->datavalue.bit = 0;
+                    result.datavalue.bit = 0;
                 }
             }
             break;
         default:
             yyerror("Cannot calculate if less than.");
-            free(result);
+            return create_empty_value();
     }
 
-    result->type = BIT_TYPE;
+    result.type = BIT_TYPE;
     return result;
 }
 
-struct val *calculate_equals(struct val *first, struct val *second) {
-    struct val * result = malloc(sizeof(struct val));
-    int helper;
+struct val calculate_equals(struct val first, struct val second) {
+    struct val result = create_bit_value(0);
 
     switch(get_value_type(first)) {
         case INTEGER_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->datavalue.bit = first->datavalue.integer == second->datavalue.integer;
+                result.datavalue.bit = first.datavalue.integer == second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->datavalue.bit = first->datavalue.integer == second->datavalue.decimal;
+                result.datavalue.bit = first.datavalue.integer == second.datavalue.decimal;
             }
             break;
         case DECIMAL_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->datavalue.bit = first->datavalue.decimal == second->datavalue.integer;
+                result.datavalue.bit = first.datavalue.decimal == second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->datavalue.bit = first->datavalue.decimal == second->datavalue.decimal;
+                result.datavalue.bit = first.datavalue.decimal == second.datavalue.decimal;
             }
             break;
         case STRING_TYPE:
             if(get_value_type(second) == STRING_TYPE) {
-                // String comparision
-                helper = strcmp(first->datavalue.string, second->datavalue.string);
-
-                // Check if strings are equal
-                if(helper == 0) {
-                    result->datavalue.bit = 1;
-                } else {
-                    result->datavalue.bit = 0;
-                }
+                // Interned strings are compared by address
+                result.datavalue.bit = strings_equal(first, second);
             }
             break;
         default:
             yyerror("Cannot calculate if equals.");
-            free(result);
+            return create_empty_value();
     }
 
-    result->type = BIT_TYPE;
+    result.type = BIT_TYPE;
     return result;
 }
 
-struct val *calculate_not_equals(struct val *first, struct val *second) {
-    struct val * result = malloc(sizeof(struct val));
-    int helper;
+struct val calculate_not_equals(struct val first, struct val second) {
+    struct val result = create_bit_value(0);
 
     switch(get_value_type(first)) {
         case INTEGER_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->datavalue.bit = first->datavalue.integer != second->datavalue.integer;
+                result.datavalue.bit = first.datavalue.integer != second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->datavalue.bit = first->datavalue.integer != second->datavalue.decimal;
+                result.datavalue.bit = first.datavalue.integer != second.datavalue.decimal;
             }
             break;
         case DECIMAL_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->datavalue.bit = first->datavalue.decimal != second->datavalue.integer;
+                result.datavalue.bit = first.datavalue.decimal != second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->datavalue.bit = first->datavalue.decimal != second->datavalue.decimal;
+                result.datavalue.bit = first.datavalue.decimal != second.datavalue.decimal;
             }
             break;
         case STRING_TYPE:
             if(get_value_type(second) == STRING_TYPE) {
-                // String comparision
-                helper = strcmp(first->datavalue.string, second->datavalue.string);
-
-                // Check if strings are equal
-                if(helper != 0) {
-                    result->datavalue.bit = 1;
-                } else {
-                    result->datavalue.bit = 0;
-                }
+                // Interned strings are compared by address
+                result.datavalue.bit = !strings_equal(first, second);
             }
             break;
         default:
             yyerror("Cannot calculate if not equals.");
-            free(result);
+            return create_empty_value();
     }
 
-    result->type = BIT_TYPE;
+    result.type = BIT_TYPE;
     return result;
 }
 
-struct val *calculate_greater_equal_than(struct val *first, struct val *second) {
-    struct val * result = malloc(sizeof(struct val));
+struct val calculate_greater_equal_than(struct val first, struct val second) {
+    struct val result = create_bit_value(0);
     int helper;
 
     switch(get_value_type(first)) {
         case INTEGER_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->datavalue.bit = first->datavalue.integer >= second->datavalue.integer;
+                result.datavalue.bit = first.datavalue.integer >= second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->datavalue.bit = first->datavalue.integer >= second->datavalue.decimal;
+                result.datavalue.bit = first.datavalue.integer >= second.datavalue.decimal;
             }
             break;
         case DECIMAL_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->datavalue.bit = first->datavalue.decimal >= second->datavalue.integer;
+                result.datavalue.bit = first.datavalue.decimal >= second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->datavalue.bit = first->datavalue.decimal >= second->datavalue.decimal;
+                result.datavalue.bit = first.datavalue.decimal >= second.datavalue.decimal;
             }
             break;
         case STRING_TYPE:
             if(get_value_type(second) == STRING_TYPE) {
                 // String comparision
-                helper = strcmp(first->datavalue.string, second->datavalue.string);
+                helper = compare_strings(first, second);
 
                 // Check if strings are equal
                 if(helper == 0 || helper == 1) {
-                    result->datavalue.bit = 1;
+                    result.datavalue.bit = 1;
                 } else {
-                    result->datavalue.bit = 0;
+                    result.datavalue.bit = 0;
                 }
             }
             break;
         default:
             yyerror("Cannot calculate if greater equal than.");
-            free(result);
+            return create_empty_value();
     }
 
-    result->type = BIT_TYPE;
+    result.type = BIT_TYPE;
     return result;
 }
 
-struct val *calculate_less_equal_than(struct val *first, struct val *second) {
-    struct val * result = malloc(sizeof(struct val));
+struct val calculate_less_equal_than(struct val first, struct val second) {
+    struct val result = create_bit_value(0);
     int helper;
 
     switch(get_value_type(first)) {
         case INTEGER_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->datavalue.bit = first->datavalue.integer <= second->datavalue.integer;
+                result.datavalue.bit = first.datavalue.integer <= second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->datavalue.bit = first->datavalue.integer <= second->datavalue.decimal;
+                result.datavalue.bit = first.datavalue.integer <= second.datavalue.decimal;
             }
             break;
         case DECIMAL_TYPE:
             if(get_value_type(second) == INTEGER_TYPE) {
-                result->datavalue.bit = first->datavalue.decimal <= second->datavalue.integer;
+                result.datavalue.bit = first.datavalue.decimal <= second.datavalue.integer;
             } else if(get_value_type(second) == DECIMAL_TYPE) {
-                result->datavalue.bit = first->datavalue.decimal <= second->datavalue.decimal;
+                result.datavalue.bit = first.datavalue.decimal <= second.datavalue.decimal;
             }
             break;
         case STRING_TYPE:
             if(get_value_type(second) == STRING_TYPE) {
                 // String comparision
-                helper = strcmp(first->datavalue.string, second->datavalue.string);
+                helper = compare_strings(first, second);
 
                 // Check if strings are equal
                 if(helper == 0 || helper == -1) {
-                    result->datavalue.bit = 1;
+                    result.datavalue.bit = 1;
                 } else {
-                    result->datavalue.bit = 0;
+                    result.datavalue.bit = 0;
                 }
             }
             break;
         default:
             yyerror("Cannot calculate if less equal than.");
-            free(result);
+            return create_empty_value();
     }
 
-    result->type = BIT_TYPE;
+    result.type = BIT_TYPE;
     return result;
 }
 
-struct val *create_bit_value(int bit_value) {
+struct val create_empty_value() {
+    struct val empty_val;
+    empty_val.type = NO_TYPE;
+    empty_val.datavalue.integer = 0;
+    return empty_val;
+}
+
+struct val create_bit_value(int bit_value) {
     if(bit_value != 0 && bit_value != 1) {
-        return NULL;
+        return create_empty_value();
     }
 
-    struct val *bit_val = malloc(sizeof(struct val));
-    bit_val->type = BIT_TYPE;
-    bit_val->datavalue.bit = bit_value;
+    struct val bit_val;
+    bit_val.type = BIT_TYPE;
+    bit_val.datavalue.bit = bit_value;
     return bit_val;
 }
 
-struct val *create_integer_value(int integer_value) {
-    struct val *integer_val = malloc(sizeof(struct val));
-    integer_val->type = INTEGER_TYPE;
-    integer_val->datavalue.integer = integer_value;
+struct val create_integer_value(int integer_value) {
+    struct val integer_val;
+    integer_val.type = INTEGER_TYPE;
+    integer_val.datavalue.integer = integer_value;
     return integer_val;
 }
 
-struct val *create_decimal_value(double decimal_value) {
-    struct val *decimal_val = malloc(sizeof(struct val));
-    decimal_val->type = DECIMAL_TYPE;
-    decimal_val->datavalue.decimal = decimal_value;
+struct val create_decimal_value(double decimal_value) {
+    struct val decimal_val;
+    decimal_val.type = DECIMAL_TYPE;
+    decimal_val.datavalue.decimal = decimal_value;
     return decimal_val;
 }
 
-struct val *create_string_value(char *string_value) {
-    struct val *string_val = malloc(sizeof(struct val));
-	string_val->type = STRING_TYPE;
-    string_val->datavalue.string = strdup(string_value);
+struct val create_string_value(char *string_value) {
+    struct val string_val;
+	string_val.type = STRING_TYPE;
+    string_val.length = strlen(string_value);
+    string_val.datavalue.string = intern_string(string_value, string_val.length);
     return string_val;
 }
 
@@ -748,12 +758,12 @@ struct val *create_string_value(char *string_value) {
  * if it's a declaration, assigns 0 to GPIO_PIN
  * else evaluates the assignment
  */
-struct val *create_led_value(struct val ** pin, int is_declaration) {
-    struct val *led_val = malloc(sizeof(struct val));
+struct val create_led_value(struct val * pin, int is_declaration) {
+    struct val led_val = create_empty_value();
 
     if(is_declaration == 1) {
-        led_val->type = LED;
-        led_val->datavalue.GPIO_PIN = 0;
+        led_val.type = LED;
+        led_val.datavalue.GPIO_PIN = 0;
     } else {
         led_val = create_complex_value(pin, 1, LED);
     }
@@ -766,12 +776,12 @@ struct val *create_led_value(struct val ** pin, int is_declaration) {
  * if it's a declaration, assigns 0 to GPIO_PIN
  * else evaluates the assignment
  */
-struct val *create_button_value(struct val ** pin, int is_declaration) {
-    struct val * result = malloc(sizeof(struct val));
+struct val create_button_value(struct val * pin, int is_declaration) {
+    struct val result = create_empty_value();
 
     if(is_declaration == 1) {
-        result->type = BUTTON;
-        result->datavalue.GPIO_PIN = 0;
+        result.type = BUTTON;
+        result.datavalue.GPIO_PIN = 0;
     } else {
         result = create_complex_value(pin, 1, BUTTON);
     }
@@ -784,12 +794,12 @@ struct val *create_button_value(struct val ** pin, int is_declaration) {
  * if it's a declaration, assigns 0 to GPIO_PIN
  * else evaluates the assignment
  */
-struct val *create_keypad_value(struct val ** pin, int is_declaration) {
-    struct val * result = malloc(sizeof(struct val));
+struct val create_keypad_value(struct val * pin, int is_declaration) {
+    struct val result = create_empty_value();
 
     if(is_declaration == 1) {
-        result->type = KEYPAD;
-        result->datavalue.GPIO_PIN = 0;
+        result.type = KEYPAD;
+        result.datavalue.GPIO_PIN = 0;
     } else {
         result = create_complex_value(pin, 8, KEYPAD);
     }
@@ -802,13 +812,13 @@ struct val *create_keypad_value(struct val ** pin, int is_declaration) {
  * if it's a declaration, assigns 0 to GPIO_PIN
  * else evaluates the assignment
  */
-struct val *create_buzzer_value(struct val ** pin, int is_declaration) {
-    struct val * result = malloc(sizeof(struct val));
+struct val create_buzzer_value(struct val * pin, int is_declaration) {
+    struct val result = create_empty_value();
     
     // Check if declaration
     if(is_declaration == 1) {
-        result->type = BUZZER;
-        result->datavalue.GPIO_PIN = 0;
+        result.type = BUZZER;
+        result.datavalue.GPIO_PIN = 0;
     } else {
         result = create_complex_value(pin, 1, BUZZER);
     }
@@ -816,13 +826,13 @@ struct val *create_buzzer_value(struct val ** pin, int is_declaration) {
     return result;
 }
 
-struct val *create_servo_motor_value(struct val ** pin, int is_declaration) {
-    struct val * result = malloc(sizeof(struct val));
+struct val create_servo_motor_value(struct val * pin, int is_declaration) {
+    struct val result = create_empty_value();
     
     // Check if declaration
     if(is_declaration == 1) {
-        result->type = SERVO_MOTOR;
-        result->datavalue.GPIO_PIN = 0;
+        result.type = SERVO_MOTOR;
+        result.datavalue.GPIO_PIN = 0;
     } else {
         result = create_complex_value(pin, 1, SERVO_MOTOR);
     }
@@ -830,203 +840,178 @@ struct val *create_servo_motor_value(struct val ** pin, int is_declaration) {
     return result;
 }
 
-struct val *create_complex_value(struct val ** pin, int number_of_pins, int datatype) {
-    struct val *result = malloc(sizeof(struct val));
-    result->type = datatype;
+/*
+ * Only the pin array of a device lives on the heap,
+ * the value itself is returned by value.
+ */
+struct val create_complex_value(struct val * pin, int number_of_pins, int datatype) {
+    struct val result = create_empty_value();
+    result.type = datatype;
 
-    printf("Number of pins: %d\n", number_of_pins);
+    trace(TRACE_DEBUG, "Number of pins: %d\n", number_of_pins);
 
     if(number_of_pins > 0 && pin) {
-        result->datavalue.GPIO_PIN = malloc(number_of_pins * sizeof(int));
+        // The pins are freed by the collector once no value uses the device
+        result.datavalue.GPIO_PIN = heap_alloc(number_of_pins * sizeof(int));
         int current_pin;
 
         for(int i = 0; i < number_of_pins; i++) {
-            //printf("Pin value is: %d\n", pin[i]->datavalue.GPIO_PIN);
-            if(pin[i] == NULL) {
+            //printf("Pin value is: %d\n", pin[i].datavalue.integer);
+            if(pin[i].type == NO_TYPE) {
                 yyerror("No pin found while creating complex value.\n");
-                free(result);
-                return NULL;
+                return create_empty_value();
             }
 
-            current_pin = pin[i]->datavalue.GPIO_PIN;
+            current_pin = pin[i].datavalue.integer;
 
             if(current_pin < 0 || current_pin > 50) {
                 yyerror("%d is not a valid pin number.", current_pin);
-                free(result);
-                break;
+                return create_empty_value();
+            }
+
+            // Scripts running in parallel cannot drive the same pin
+            if(!claim_pin(current_pin)) {
+                yyerror("Pin %d is used by another script.", current_pin);
+                return create_empty_value();
             }
-            result->datavalue.GPIO_PIN[i] = (unsigned int)current_pin;
 
-            printf("Current pin value is: %d\n", current_pin);
+            result.datavalue.GPIO_PIN[i] = (unsigned int)current_pin;
+
+            trace(TRACE_DEBUG, "Current pin value is: %d\n", current_pin);
         }
     }
 
-    printf("Complex value creation completed.\n");
+    trace(TRACE_INFO, "Complex value creation completed.\n");
     return result;
 }
 
 /*
 * Sets the GPIO level to on.
+* The write is queued and reaches the pin at the next flush.
 * gpio: 0-53
 * level: 0-1
 * Returns 0 if OK, otherwise PI_BAD_GPIO or PI_BAD_LEVEL.
 */
 int led_on(struct val * value) {
-    return gpioWrite(value->datavalue.GPIO_PIN[0], 1);
+    return queue_gpio_write(value->datavalue.GPIO_PIN[0], 1);
 }
 
 /*
 * Sets the GPIO level to off.
+* The write is queued and reaches the pin at the next flush.
 * gpio: 0-53
 * level: 0-1
 * Returns 0 if OK, otherwise PI_BAD_GPIO or PI_BAD_LEVEL.
 */
 int led_off(struct val * value) {
-    return gpioWrite(value->datavalue.GPIO_PIN[0], 0);
+    return queue_gpio_write(value->datavalue.GPIO_PIN[0], 0);
+}
+
+/*
+* Sets the GPIO level of several LEDs or BUZZERs at once.
+* All pins change with one write per bank, so the edges are simultaneous.
+* level: 0-1
+* Returns 0 if OK, otherwise PI_BAD_GPIO or PI_BAD_LEVEL.
+*/
+int write_group(int level, struct val * devices, int number_of_devices) {
+    int status = 0;
+
+    for(int i = 0; i < number_of_devices && status == 0; i++) {
+        status = queue_gpio_write(devices[i].datavalue.GPIO_PIN[0], level);
+    }
+
+    flush_gpio_writes();
+    return status;
 }
 
 /*
- * Reads the GPIO level of the button.
+ * Reads the last known GPIO level of the button.
+ * The level is kept up to date by edge events, so no gpioRead is needed.
  * gpio: 0-53
- * Returns the GPIO level if OK, otherwise PI_BAD_GPIO.
+ * Returns 1 if the button is pressed, otherwise 0.
  */
-struct val *is_button_pressed(struct val * value) {
-    struct val *result = malloc(sizeof(struct val));
-    result->type = BIT_TYPE;
-    result->datavalue.bit = 0;
+struct val is_button_pressed(struct val * value) {
+    struct val result = create_bit_value(0);
+    int level = -1;
+
+    // Let queued writes reach the pins before reading
+    flush_gpio_writes();
+    level = cached_level(value->datavalue.GPIO_PIN[0]);
 
     // Check if pin number is correct
-    if(gpioRead(value->datavalue.GPIO_PIN[0]) == PI_BAD_GPIO) {
-        return NULL;
+    if(level < 0) {
+        return create_empty_value();
     }
 
-    if(gpioRead(value->datavalue.GPIO_PIN[0]) == 0) {
-        result->datavalue.bit = 1;
+    // The button is pulled up, so it reads low while pressed
+    if(level == 0) {
+        result.datavalue.bit = 1;
     }
     
     return result;
 }
 
 /*
- * Reads the GPIO level of the keypad.
- * gpio: 0-53
- * Returns the pressed key as string value, else NO_KEY_PRESSED.
+ * Waits until the button is pressed.
+ * Blocks while no edge event arrives, without polling the GPIO.
+ * timeout_ms: milliseconds to wait, negative to wait forever
+ * Returns 1 if the button was pressed, 0 on timeout.
  */
-struct val *get_pressed_key(struct val * value) {
-    struct val *result = malloc(sizeof(struct val));
-    result->type = STRING_TYPE;
-    result->datavalue.string[0] = read_last_pressed_key(value);
-
-    // Debounce for not to read 2 values at the same time
-    gpioDelay(200);
+struct val wait_for_press(struct val * value, int timeout_ms) {
+    flush_gpio_writes();
+    return create_bit_value(wait_for_edge(value->datavalue.GPIO_PIN[0], 0, timeout_ms));
+}
 
-    // Set the second part of the keypad values to LOW
-    for(int i = 4; i < 8; i++) {
-        gpioWrite(value->datavalue.GPIO_PIN[i], 0);
-    }
+/*
+ * Takes the next key pressed on the keypad without waiting.
+ * The scanner thread reads and debounces the keys, see keypad.c.
+ * Returns the pressed key as string value, empty if no key was pressed.
+ */
+struct val get_pressed_key(struct val * value) {
+    char key[2] = {read_key(value->datavalue.GPIO_PIN, 0), '\0'};
 
-    return result;  
+    return create_string_value(key);
 }
 
 /*
- * Utility function to read yhe key from keypad.
- * Standard keypads are contains characters in a 4x4 matrix form.
- * Thus, each character in the keypad is mapped to a 2-D array.
- * Returns the char read when pressed, else '-'
+ * Waits for the next key pressed on the keypad, at most timeout_ms milliseconds or forever if it is negative.
+ * Returns the key as a string, empty if none was pressed in time.
  */
-char read_last_pressed_key(struct val * value) {
-    char pressedKey = '-';
-    char keys[4][4] = {{'1', '2', '3', 'A'}, {'4', '5', '6', 'B'}, {'7', '8', '9', 'C'}, {'*', '0', '#', 'D'}};
-    int column = -1;
-    int row = -1;
-
-    for (int i = 4; i < 8; i++) {
-        // Set HIGH the second part of keypad pins
-        column = value->datavalue.GPIO_PIN[i];
-        gpioWrite(column, 1);
-
-        row = -1;
-
-        for (int i = 0; i < 4; i++) {
-            // Check if the first part of keypad pins value is HIGH
-            if (gpioRead(value->datavalue.GPIO_PIN[i]) == 1) {
-                row = i;
-                break;
-            }
-        }
-
-        if (row != -1 && pressedKey != '-') {
-            pressedKey = keys[row][i-4];
-            return pressedKey;
-        }
-    }
+struct val wait_for_key(struct val * value, int timeout_ms) {
+    char key[2] = {read_key(value->datavalue.GPIO_PIN, timeout_ms), '\0'};
 
-   pressedKey = '-';
-   return pressedKey;
+    return create_string_value(key);
 }
 
 int buzz_start(struct val * value) {
-    return gpioWrite(value->datavalue.GPIO_PIN[0], 1);
+    return queue_gpio_write(value->datavalue.GPIO_PIN[0], 1);
 }
 
 int buzz_stop(struct val * value) {
-    return gpioWrite(value->datavalue.GPIO_PIN[0], 0);
+    return queue_gpio_write(value->datavalue.GPIO_PIN[0], 0);
 }
 
 /*
- * Returns 0 if OK, otherwise PI_BAD_USER_GPIO or PI_BAD_DUTYCYCLE.
- * The angle passed in as a parameter should be between 0 and 255.
+ * Starts moving the servo to an angle between 0 and 180 degrees in duration_ms milliseconds.
+ * The servo thread steps the pulse width, so the call returns at once. 0 ms moves at once.
+ * Returns 0 if OK, otherwise PI_BAD_USER_GPIO or PI_BAD_PULSEWIDTH.
  */
-int move_servo_to_angle(struct val * value, int angle) {
-    int pwmStatus = -1;
-
-    // Sanity check for the angle if it's on limits
-    if(angle < 0 || angle > 255) {
-        printf("Angle should be between 0 and 255.\n");
-        return -1;
-    }
-
-    #ifdef RPI_SIMULATION
-        pwmStatus = gpioPWM(result->datavalue.GPIO_PIN[0], range);
-    #else
-        printf("Simulated gpioPWM function in move_servo_to_angle function.\n");
-        pwmStatus = 0;
-    #endif
-
-    return pwmStatus;
+int move_servo_to_angle(struct val * value, int angle, int duration_ms) {
+    return move_servo(value->datavalue.GPIO_PIN[0], angle, duration_ms);
 }
 
 /*
- * Returns 0 if OK, otherwise PI_BAD_USER_GPIO or PI_BAD_DUTYCYCLE.
- * Rotates 10 times to simulate the infinite movement.
+ * Turns a continuous rotation servo at full speed until servo_stop.
+ * Returns 0 if OK, otherwise PI_BAD_USER_GPIO or PI_BAD_PULSEWIDTH.
  */
 int move_servo_infinitely(struct val * value) {
-    int pwmStatus = -1;
-
-    #ifdef RPI_SIMULATION
-        int i = 0;
-        while(i < 10) {
-            pwmStatus = gpioPWM(result->datavalue.GPIO_PIN[0], 255);
-            i += 1;
-        }
-    #else
-        printf("Simulated gpioPWM function in move_servo_to_angle function.\n");
-        pwmStatus = 0;
-    #endif
-
-    return pwmStatus;
+    return spin_servo(value->datavalue.GPIO_PIN[0]);
 }
 
 /*
- * Stops the servo motor.
+ * Stops the servo motor, its move and its pulses.
  */
-int servo_stop(struct val * value) {        
-    return gpioPWM(value->datavalue.GPIO_PIN[0], 0);
+int servo_stop(struct val * value) {
+    return stop_servo(value->datavalue.GPIO_PIN[0]);
 }
 
-/*
- * Delays 1000 microseconds.
- */
-void delay_pi() {
-    gpioDelay(1000);
-}
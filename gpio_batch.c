@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <stdint.h>
+
+#include "learnpi.h"
+#include "gpio_batch.h"
+#include "backend.h"
+
+// Function to queue a level change of an output gpio until the next flush
+int queue_gpio_write(unsigned gpio, unsigned level) {
+  // Every interpreter queues its own writes, bank 1 is gpio 0-31 and bank 2 is gpio 32-53
+  uint32_t *pending_set = current_context->devices.pending_set;
+  uint32_t *pending_clear = current_context->devices.pending_clear;
+  unsigned bank = gpio / 32;
+  uint32_t bit = (uint32_t)1 << (gpio % 32);
+
+  if(gpio >= MAX_GPIO) {
+    return PI_BAD_GPIO;
+  }
+
+  if(level > 1) {
+    return PI_BAD_LEVEL;
+  }
+
+  // The last write of a pin before the flush wins
+  if(level) {
+    pending_set[bank] |= bit;
+    pending_clear[bank] &= ~bit;
+  } else {
+    pending_clear[bank] |= bit;
+    pending_set[bank] &= ~bit;
+  }
+
+  return 0;
+}
+
+// Function to write every queued level change with one set and one clear per bank
+void flush_gpio_writes() {
+  uint32_t *pending_set = current_context->devices.pending_set;
+  uint32_t *pending_clear = current_context->devices.pending_clear;
+
+  if(!(pending_set[0] | pending_clear[0] | pending_set[1] | pending_clear[1])) {
+    return;
+  }
+
+  gpio_backend->write_banks(pending_set, pending_clear);
+
+  pending_set[0] = pending_clear[0] = 0;
+  pending_set[1] = pending_clear[1] = 0;
+}
@@ -0,0 +1,10 @@
+#ifndef GPIO_BATCH_H
+#define GPIO_BATCH_H
+
+// Function to queue a level change of an output gpio until the next flush
+int queue_gpio_write(unsigned gpio, unsigned level);
+
+// Function to write every queued level change with one set and one clear per bank
+void flush_gpio_writes();
+
+#endif
@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "learnpi.h"
+#include "functions.h"
+#include "heap.h"
+#include "trace.h"
+
+// Bytes to allocate before the first collection, later ones wait until the live bytes are allocated again
+#define HEAP_MIN_THRESHOLD (64 * 1024)
+
+// Seconds between two reports of --mem-stats while a script runs
+#define MEMORY_REPORT_INTERVAL 60
+
+int memory_stats = 0;
+
+// Function to allocate a block of the current interpreter that is freed once no value uses it
+void *heap_alloc(size_t size) {
+  struct heap *heap = &current_context->heap;
+  struct heap_object *object = malloc(sizeof(struct heap_object) + size);
+
+  if(!object) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  object->next = heap->objects;
+  object->size = size;
+  object->marked = 0;
+  heap->objects = object;
+
+  heap->allocations++;
+  heap->allocated_bytes += size;
+  heap->live_bytes += size;
+  if(heap->live_bytes > heap->peak_bytes) {
+    heap->peak_bytes = heap->live_bytes;
+  }
+
+  return object + 1;
+}
+
+// Function to keep the block of a value
+static void mark_block(void *block) {
+  ((struct heap_object *)block - 1)->marked = 1;
+}
+
+// Function to keep the blocks a value uses, strings and device pins are the only values on the heap
+static void mark_value(struct val value) {
+  if(value.type == STRING_TYPE) {
+    mark_block(string_header_of(value.datavalue.string));
+  } else if(value.type >= LED && value.datavalue.GPIO_PIN) {
+    mark_block(value.datavalue.GPIO_PIN);
+  }
+}
+
+// Function to free every value of the current interpreter no root reaches
+void heap_collect() {
+  struct interpreter_context *context = current_context;
+  struct heap *heap = &context->heap;
+  struct heap_object **link = &heap->objects;
+  struct heap_object *object = NULL;
+  size_t freed = 0;
+
+  // Constants are interned, so variables, the interned strings and the value stack are every root
+  for(int i = 0; i < NHASH; i++) {
+    if(context->symtab[i].name) {
+      mark_value(context->symtab[i].value);
+    }
+  }
+
+  for(size_t i = 0; i < context->strings.capacity; i++) {
+    if(context->strings.slots[i]) {
+      mark_block(string_header_of(context->strings.slots[i]));
+    }
+  }
+
+  for(struct val *value = context->value_stack; value && value < context->stack_top; value++) {
+    mark_value(*value);
+  }
+
+  while((object = *link)) {
+    if(object->marked) {
+      object->marked = 0;
+      link = &object->next;
+      continue;
+    }
+
+    *link = object->next;
+    freed += object->size;
+    heap->frees++;
+    free(object);
+  }
+
+  heap->live_bytes -= freed;
+  heap->allocated_bytes = 0;
+  heap->threshold = heap->live_bytes > HEAP_MIN_THRESHOLD ? heap->live_bytes : HEAP_MIN_THRESHOLD;
+  heap->collections++;
+
+  trace(TRACE_DEBUG, "Collected %zu bytes, %zu bytes live.\n", freed, heap->live_bytes);
+}
+
+// Function to collect if enough was allocated since the last collection, only where every live value is a root
+void heap_safe_point() {
+  struct heap *heap = &current_context->heap;
+  time_t now;
+
+  if(heap->allocated_bytes >= (heap->threshold ? heap->threshold : HEAP_MIN_THRESHOLD)) {
+    heap_collect();
+  }
+
+  if(memory_stats) {
+    now = time(NULL);
+
+    if(!heap->last_report) {
+      heap->last_report = now;
+    } else if(now - heap->last_report >= MEMORY_REPORT_INTERVAL) {
+      heap->last_report = now;
+      print_memory_stats();
+    }
+  }
+}
+
+// Function to read the resident set size of the process in KiB, 0 if it is not known
+static long resident_kib() {
+  long pages = 0;
+  long resident = 0;
+  FILE *statm = fopen("/proc/self/statm", "r");
+
+  if(!statm) {
+    return 0;
+  }
+
+  if(fscanf(statm, "%ld %ld", &pages, &resident) != 2) {
+    resident = 0;
+  }
+
+  fclose(statm);
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Function to print the memory use of the current interpreter
+void print_memory_stats() {
+  struct heap *heap = &current_context->heap;
+
+  fprintf(stderr, "Memory: %zu bytes live, %zu bytes peak, %zu allocations, %zu freed, %zu collections, %ld KiB resident\n",
+    heap->live_bytes, heap->peak_bytes, heap->allocations, heap->frees, heap->collections, resident_kib());
+}
+
+// Function to free every block of a heap
+void free_heap(struct heap *heap) {
+  struct heap_object *object = heap->objects;
+  struct heap_object *next = NULL;
+
+  while(object) {
+    next = object->next;
+    free(object);
+    object = next;
+  }
+
+  heap->objects = NULL;
+  heap->live_bytes = 0;
+}
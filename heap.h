@@ -0,0 +1,45 @@
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <stddef.h>
+#include <time.h>
+
+// Structure in front of every block the heap hands out
+struct heap_object {
+  struct heap_object *next;
+  size_t size;
+  size_t marked;
+};
+
+// Structure for the blocks of one interpreter, collected by mark and sweep
+struct heap {
+  struct heap_object *objects;
+  size_t live_bytes;               // bytes of the blocks not freed yet
+  size_t allocated_bytes;          // bytes handed out since the last collection
+  size_t threshold;                // allocated bytes that start the next collection
+  size_t peak_bytes;
+  size_t allocations;
+  size_t frees;
+  size_t collections;
+  time_t last_report;
+};
+
+// Function to allocate a block of the current interpreter that is freed once no value uses it
+void *heap_alloc(size_t size);
+
+// Function to collect if enough was allocated since the last collection, only where every live value is a root
+void heap_safe_point();
+
+// Function to free every value of the current interpreter no root reaches
+void heap_collect();
+
+// Function to print the memory use of the current interpreter
+void print_memory_stats();
+
+// Function to free every block of a heap
+void free_heap(struct heap *heap);
+
+// Set with --mem-stats to report memory use
+extern int memory_stats;
+
+#endif
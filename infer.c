@@ -0,0 +1,622 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "learnpi.h"
+#include "functions.h"
+
+// Type of a global no store has been seen for yet while inferring, never left behind
+#define UNSEEN_TYPE -2
+
+// States of a global slot while looking for its first use in a script
+enum first_use {
+  NOT_USED = 0,
+  STORED_FIRST,   // first used by a top-level store that does not read it, its type can be inferred
+  READ_FIRST      // may be read before it is stored, its type stays unknown
+};
+
+// Function to check if a type is a number
+static int is_number(int type) {
+  return type == INTEGER_TYPE || type == DECIMAL_TYPE;
+}
+
+// Function to check if a type is known, an unseen global may still get any type
+static int is_known(int type) {
+  return type != NO_TYPE && type != UNSEEN_TYPE;
+}
+
+// Function to find the type of an arithmetic operation on two numbers
+static int number_type(int left, int right) {
+  if(left == NO_TYPE || right == NO_TYPE) {
+    return NO_TYPE;
+  }
+
+  if(left == UNSEEN_TYPE || right == UNSEEN_TYPE) {
+    return UNSEEN_TYPE;
+  }
+
+  if(!is_number(left) || !is_number(right)) {
+    return NO_TYPE;
+  }
+
+  return left == INTEGER_TYPE && right == INTEGER_TYPE ? INTEGER_TYPE : DECIMAL_TYPE;
+}
+
+// Function to find the type a node always evaluates to without an error, NO_TYPE if it is not known
+int static_type(struct ast *abstract_syntax_tree) {
+  struct symbol_reference *symbol_reference = NULL;
+  int left = NO_TYPE;
+  int right = NO_TYPE;
+
+  if(!abstract_syntax_tree) {
+    return NO_TYPE;
+  }
+
+  switch(abstract_syntax_tree->nodetype) {
+    case CONSTANT:
+      return ((struct constant_value *)abstract_syntax_tree)->v.type;
+
+    case NEW_REFERENCE:
+      symbol_reference = (struct symbol_reference *)abstract_syntax_tree;
+      return symbol_reference->scope == GLOBAL_SLOT ? current_context->symtab[symbol_reference->slot].inferred_type : NO_TYPE;
+
+    case ASSIGNMENT:
+      return static_type(((struct assign_symbol *)abstract_syntax_tree)->v);
+
+    case STATEMENT_LIST:
+      return static_type(abstract_syntax_tree->r);
+
+    case '+':
+    case '-':
+    case '*':
+      return number_type(static_type(abstract_syntax_tree->l), static_type(abstract_syntax_tree->r));
+
+    case '|':
+    case UNARY_MINUS:
+      left = static_type(abstract_syntax_tree->l);
+      return is_number(left) || left == UNSEEN_TYPE ? left : NO_TYPE;
+
+    case LOGICAL_AND:
+    case LOGICAL_OR:
+      left = static_type(abstract_syntax_tree->l);
+      right = static_type(abstract_syntax_tree->r);
+
+      if(left == NO_TYPE || right == NO_TYPE) {
+        return NO_TYPE;
+      }
+
+      if(left == UNSEEN_TYPE || right == UNSEEN_TYPE) {
+        return UNSEEN_TYPE;
+      }
+
+      return left == BIT_TYPE && right == BIT_TYPE ? BIT_TYPE : NO_TYPE;
+
+    case '1':  case '2':  case '3':  case '4':  case '5':  case '6':
+      // Comparisons only report an error when the left side is not a number or a string
+      left = static_type(abstract_syntax_tree->l);
+
+      if(left == UNSEEN_TYPE) {
+        return UNSEEN_TYPE;
+      }
+
+      return is_number(left) || left == STRING_TYPE ? BIT_TYPE : NO_TYPE;
+
+    case TYPED_OPERATION:
+      switch(((struct typed_operation *)abstract_syntax_tree)->operation) {
+        case '+':
+        case '-':
+        case '*':
+          return ((struct typed_operation *)abstract_syntax_tree)->operand_type;
+
+        case '/':
+          return NO_TYPE;
+
+        default:
+          return BIT_TYPE;
+      }
+
+    case TO_DECIMAL:
+      return DECIMAL_TYPE;
+
+    default:
+      return NO_TYPE;
+  }
+}
+
+// Function to mark the global slots an AST uses, and whether it calls a user function
+static void mark_slots(struct ast *abstract_syntax_tree, unsigned char *marks, int *calls) {
+  struct symbol_reference *symbol_reference = NULL;
+  struct assign_symbol *assign_symbol = NULL;
+  struct declare_symbol *declare_symbol = NULL;
+  struct assign_and_declare_symbol *assign_and_declare_symbol = NULL;
+  struct assign_and_declare_complex_symbol *assign_and_declare_complex_symbol = NULL;
+
+  if(!abstract_syntax_tree) {
+    return;
+  }
+
+  switch(abstract_syntax_tree->nodetype) {
+    case NEW_REFERENCE:
+      symbol_reference = (struct symbol_reference *)abstract_syntax_tree;
+      if(symbol_reference->scope == GLOBAL_SLOT) marks[symbol_reference->slot] = 1;
+      break;
+
+    case ASSIGNMENT:
+      assign_symbol = (struct assign_symbol *)abstract_syntax_tree;
+      mark_slots(assign_symbol->v, marks, calls);
+      if(assign_symbol->scope == GLOBAL_SLOT) marks[assign_symbol->slot] = 1;
+      break;
+
+    case DECLARATION:
+      declare_symbol = (struct declare_symbol *)abstract_syntax_tree;
+      if(declare_symbol->scope == GLOBAL_SLOT) marks[declare_symbol->slot] = 1;
+      break;
+
+    case DECLARATION_WITH_ASSIGNMENT:
+      assign_and_declare_symbol = (struct assign_and_declare_symbol *)abstract_syntax_tree;
+      mark_slots(assign_and_declare_symbol->value, marks, calls);
+      if(assign_and_declare_symbol->scope == GLOBAL_SLOT) marks[assign_and_declare_symbol->slot] = 1;
+      break;
+
+    case COMPLEX_ASSIGNMENT:
+      assign_and_declare_complex_symbol = (struct assign_and_declare_complex_symbol *)abstract_syntax_tree;
+      mark_slots(assign_and_declare_complex_symbol->value, marks, calls);
+      if(assign_and_declare_complex_symbol->scope == GLOBAL_SLOT) marks[assign_and_declare_complex_symbol->slot] = 1;
+      break;
+
+    case '+':
+    case '-':
+    case '*':
+    case '/':
+    case LOGICAL_AND:
+    case LOGICAL_OR:
+    case '1':  case '2':  case '3':  case '4':  case '5':  case '6':
+    case STATEMENT_LIST:
+    case '|':
+    case UNARY_MINUS:
+      mark_slots(abstract_syntax_tree->l, marks, calls);
+      mark_slots(abstract_syntax_tree->r, marks, calls);
+      break;
+
+    case IF_STATEMENT:
+    case LOOP_STATEMENT:
+      mark_slots(((struct flow *)abstract_syntax_tree)->condition, marks, calls);
+      mark_slots(((struct flow *)abstract_syntax_tree)->then_list, marks, calls);
+      mark_slots(((struct flow *)abstract_syntax_tree)->else_list, marks, calls);
+      break;
+
+    case FOR_STATEMENT:
+      mark_slots(((struct for_flow *)abstract_syntax_tree)->initialization, marks, calls);
+      mark_slots(((struct for_flow *)abstract_syntax_tree)->condition, marks, calls);
+      mark_slots(((struct for_flow *)abstract_syntax_tree)->then_list, marks, calls);
+      mark_slots(((struct for_flow *)abstract_syntax_tree)->else_list, marks, calls);
+      break;
+
+    case BUILTIN_TYPE:
+      mark_slots(((struct builtin_function_call *)abstract_syntax_tree)->argument_list, marks, calls);
+      break;
+
+    case USER_CALL:
+      mark_slots(((struct user_function_call *)abstract_syntax_tree)->argument_list, marks, calls);
+      *calls = 1;
+      break;
+  }
+}
+
+// Function to find the global a top-level unit stores before reading anything else, -1 if there is none
+static int first_store(struct ast *abstract_syntax_tree) {
+  struct assign_symbol *assign_symbol = (struct assign_symbol *)abstract_syntax_tree;
+  struct declare_symbol *declare_symbol = (struct declare_symbol *)abstract_syntax_tree;
+  unsigned char *marks = NULL;
+  int calls = 0;
+  int slot = -1;
+
+  if(abstract_syntax_tree->nodetype == DECLARATION && declare_symbol->scope == GLOBAL_SLOT) {
+    return declare_symbol->slot;
+  }
+
+  if(abstract_syntax_tree->nodetype != ASSIGNMENT || assign_symbol->scope != GLOBAL_SLOT) {
+    return -1;
+  }
+
+  // The value must not read the variable it initializes, not even through a function
+  marks = calloc(NHASH, 1);
+
+  if(!marks) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  mark_slots(assign_symbol->v, marks, &calls);
+
+  if(!calls && !marks[assign_symbol->slot]) {
+    slot = assign_symbol->slot;
+  }
+
+  free(marks);
+  return slot;
+}
+
+// Function to combine the type a global already has with the type of one more store
+static int merge_type(int current, int stored) {
+  if(current == UNSEEN_TYPE) return stored;
+  if(stored == UNSEEN_TYPE) return current;
+  return current == stored ? current : NO_TYPE;
+}
+
+// Function to merge the type of every store to a global in an AST, returns 1 if a type changed
+static int merge_stores(struct ast *abstract_syntax_tree) {
+  struct symbol *symtab = current_context->symtab;
+  struct assign_symbol *assign_symbol = NULL;
+  struct declare_symbol *declare_symbol = NULL;
+  struct assign_and_declare_symbol *assign_and_declare_symbol = NULL;
+  struct assign_and_declare_complex_symbol *assign_and_declare_complex_symbol = NULL;
+  int changed = 0;
+  int type = NO_TYPE;
+
+  if(!abstract_syntax_tree) {
+    return 0;
+  }
+
+  switch(abstract_syntax_tree->nodetype) {
+    case ASSIGNMENT:
+      assign_symbol = (struct assign_symbol *)abstract_syntax_tree;
+      changed = merge_stores(assign_symbol->v);
+
+      if(assign_symbol->scope == GLOBAL_SLOT) {
+        type = merge_type(symtab[assign_symbol->slot].inferred_type, static_type(assign_symbol->v));
+        changed |= type != symtab[assign_symbol->slot].inferred_type;
+        symtab[assign_symbol->slot].inferred_type = type;
+      }
+      return changed;
+
+    case DECLARATION:
+      declare_symbol = (struct declare_symbol *)abstract_syntax_tree;
+
+      if(declare_symbol->scope == GLOBAL_SLOT) {
+        type = merge_type(symtab[declare_symbol->slot].inferred_type, declare_symbol->type);
+        changed = type != symtab[declare_symbol->slot].inferred_type;
+        symtab[declare_symbol->slot].inferred_type = type;
+      }
+      return changed;
+
+    case DECLARATION_WITH_ASSIGNMENT:
+      assign_and_declare_symbol = (struct assign_and_declare_symbol *)abstract_syntax_tree;
+      changed = merge_stores(assign_and_declare_symbol->value);
+
+      if(assign_and_declare_symbol->scope == GLOBAL_SLOT) {
+        changed |= symtab[assign_and_declare_symbol->slot].inferred_type != NO_TYPE;
+        symtab[assign_and_declare_symbol->slot].inferred_type = NO_TYPE;
+      }
+      return changed;
+
+    case COMPLEX_ASSIGNMENT:
+      assign_and_declare_complex_symbol = (struct assign_and_declare_complex_symbol *)abstract_syntax_tree;
+      changed = merge_stores(assign_and_declare_complex_symbol->value);
+
+      if(assign_and_declare_complex_symbol->scope == GLOBAL_SLOT) {
+        changed |= symtab[assign_and_declare_complex_symbol->slot].inferred_type != NO_TYPE;
+        symtab[assign_and_declare_complex_symbol->slot].inferred_type = NO_TYPE;
+      }
+      return changed;
+
+    case '+':
+    case '-':
+    case '*':
+    case '/':
+    case LOGICAL_AND:
+    case LOGICAL_OR:
+    case '1':  case '2':  case '3':  case '4':  case '5':  case '6':
+    case STATEMENT_LIST:
+    case '|':
+    case UNARY_MINUS:
+      changed = merge_stores(abstract_syntax_tree->l);
+      changed |= merge_stores(abstract_syntax_tree->r);
+      return changed;
+
+    case IF_STATEMENT:
+    case LOOP_STATEMENT:
+      changed = merge_stores(((struct flow *)abstract_syntax_tree)->condition);
+      changed |= merge_stores(((struct flow *)abstract_syntax_tree)->then_list);
+      changed |= merge_stores(((struct flow *)abstract_syntax_tree)->else_list);
+      return changed;
+
+    case FOR_STATEMENT:
+      changed = merge_stores(((struct for_flow *)abstract_syntax_tree)->initialization);
+      changed |= merge_stores(((struct for_flow *)abstract_syntax_tree)->condition);
+      changed |= merge_stores(((struct for_flow *)abstract_syntax_tree)->then_list);
+      changed |= merge_stores(((struct for_flow *)abstract_syntax_tree)->else_list);
+      return changed;
+
+    case BUILTIN_TYPE:
+      return merge_stores(((struct builtin_function_call *)abstract_syntax_tree)->argument_list);
+
+    case USER_CALL:
+      return merge_stores(((struct user_function_call *)abstract_syntax_tree)->argument_list);
+
+    default:
+      return 0;
+  }
+}
+
+// Function to infer the type of the globals of a script read in batch mode
+void infer_types() {
+  struct interpreter_context *context = current_context;
+  struct symbol *symtab = context->symtab;
+  unsigned char *function_marks = calloc(NHASH, 1);
+  unsigned char *marks = calloc(NHASH, 1);
+  unsigned char *first_use = calloc(NHASH, 1);
+  int calls = 0;
+  int slot = 0;
+  int changed = 0;
+
+  if(!function_marks || !marks || !first_use) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  // A call may run any function body, whichever definition it reaches
+  for(int i = 0; i < context->unit_count; i++) {
+    if(context->units[i].kind == FUNCTION_UNIT) {
+      mark_slots(context->units[i].ast, function_marks, &calls);
+    }
+  }
+
+  // Only a global whose first use stores it is never read before it has a value
+  for(int i = 0; i < context->unit_count; i++) {
+    if(context->units[i].kind != STATEMENT_UNIT) {
+      continue;
+    }
+
+    calls = 0;
+    memset(marks, 0, NHASH);
+    mark_slots(context->units[i].ast, marks, &calls);
+    slot = first_store(context->units[i].ast);
+
+    for(int s = 0; s < NHASH; s++) {
+      if(!first_use[s] && (marks[s] || (calls && function_marks[s]))) {
+        first_use[s] = s == slot ? STORED_FIRST : READ_FIRST;
+      }
+    }
+  }
+
+  for(int s = 0; s < NHASH; s++) {
+    symtab[s].inferred_type = first_use[s] == STORED_FIRST ? UNSEEN_TYPE : NO_TYPE;
+  }
+
+  // Narrow the types until every store agrees, then give up on the globals that are never stored
+  do {
+    do {
+      changed = 0;
+
+      for(int i = 0; i < context->unit_count; i++) {
+        changed |= merge_stores(context->units[i].ast);
+      }
+    } while(changed);
+
+    for(int s = 0; s < NHASH; s++) {
+      if(symtab[s].inferred_type == UNSEEN_TYPE) {
+        symtab[s].inferred_type = NO_TYPE;
+        changed = 1;
+      }
+    }
+  } while(changed);
+
+  free(function_marks);
+  free(marks);
+  free(first_use);
+}
+
+// Function to report an error found before the program runs
+static int type_error(char *message) {
+  yyerror(message);
+  return 1;
+}
+
+// Function to count the operations of an AST that always report an error when they run
+int check_types(struct ast *abstract_syntax_tree) {
+  struct flow *flow = NULL;
+  struct for_flow *for_flow = NULL;
+  int errors = 0;
+  int left = NO_TYPE;
+  int right = NO_TYPE;
+
+  if(!abstract_syntax_tree) {
+    return 0;
+  }
+
+  switch(abstract_syntax_tree->nodetype) {
+    case ASSIGNMENT:
+      return check_types(((struct assign_symbol *)abstract_syntax_tree)->v);
+
+    case DECLARATION_WITH_ASSIGNMENT:
+      return check_types(((struct assign_and_declare_symbol *)abstract_syntax_tree)->value);
+
+    case COMPLEX_ASSIGNMENT:
+      return check_types(((struct assign_and_declare_complex_symbol *)abstract_syntax_tree)->value);
+
+    case STATEMENT_LIST:
+      return check_types(abstract_syntax_tree->l) + check_types(abstract_syntax_tree->r);
+
+    case '+':
+    case '-':
+    case '*':
+    case '/':
+    case LOGICAL_AND:
+    case LOGICAL_OR:
+    case '1':  case '2':  case '3':  case '4':  case '5':  case '6':
+      errors = check_types(abstract_syntax_tree->l) + check_types(abstract_syntax_tree->r);
+      left = static_type(abstract_syntax_tree->l);
+      right = static_type(abstract_syntax_tree->r);
+
+      if(!is_known(left) && abstract_syntax_tree->nodetype != LOGICAL_AND && abstract_syntax_tree->nodetype != LOGICAL_OR) {
+        return errors;
+      }
+
+      switch(abstract_syntax_tree->nodetype) {
+        case '+':
+          if(!is_number(left) && left != STRING_TYPE) errors += type_error("Sum error between types.");
+          break;
+        case '-':
+          if(!is_number(left)) errors += type_error("Subtraction error between types.");
+          break;
+        case '*':
+          if(!is_number(left)) errors += type_error("Multiplication error between types.");
+          break;
+        case '/':
+          if(!is_number(left)) errors += type_error("Division error between types.");
+          break;
+        case LOGICAL_AND:
+          if((is_known(left) && left != BIT_TYPE) || (is_known(right) && right != BIT_TYPE)) errors += type_error("Logical AND error");
+          break;
+        case LOGICAL_OR:
+          if((is_known(left) && left != BIT_TYPE) || (is_known(right) && right != BIT_TYPE)) errors += type_error("Logical OR error");
+          break;
+        default:
+          if(is_number(left) || left == STRING_TYPE) break;
+
+          switch(abstract_syntax_tree->nodetype) {
+            case '1': errors += type_error("Cannot calculate if greater than."); break;
+            case '2': errors += type_error("Cannot calculate if less than."); break;
+            case '3': errors += type_error("Cannot calculate if not equals."); break;
+            case '4': errors += type_error("Cannot calculate if equals."); break;
+            case '5': errors += type_error("Cannot calculate if greater equal than."); break;
+            case '6': errors += type_error("Cannot calculate if less equal than."); break;
+          }
+          break;
+      }
+      return errors;
+
+    case '|':
+    case UNARY_MINUS:
+      errors = check_types(abstract_syntax_tree->l);
+      left = static_type(abstract_syntax_tree->l);
+
+      if(is_known(left) && !is_number(left)) {
+        errors += type_error(abstract_syntax_tree->nodetype == '|' ? "Absolute value error" : "Sign change error");
+      }
+      return errors;
+
+    case IF_STATEMENT:
+    case LOOP_STATEMENT:
+      flow = (struct flow *)abstract_syntax_tree;
+      errors = check_types(flow->condition) + check_types(flow->then_list) + check_types(flow->else_list);
+
+      // A loop without a body never evaluates its condition
+      if(abstract_syntax_tree->nodetype == LOOP_STATEMENT && !flow->then_list) {
+        return errors;
+      }
+
+      left = static_type(flow->condition);
+      if(is_known(left) && left != BIT_TYPE) errors += type_error("invalid condition");
+      return errors;
+
+    case FOR_STATEMENT:
+      for_flow = (struct for_flow *)abstract_syntax_tree;
+      errors = check_types(for_flow->initialization) + check_types(for_flow->condition);
+      errors += check_types(for_flow->then_list) + check_types(for_flow->else_list);
+
+      left = static_type(for_flow->condition);
+      if(is_known(left) && left != BIT_TYPE) errors += type_error("invalid condition");
+      return errors;
+
+    case BUILTIN_TYPE:
+      return check_types(((struct builtin_function_call *)abstract_syntax_tree)->argument_list);
+
+    case USER_CALL:
+      return check_types(((struct user_function_call *)abstract_syntax_tree)->argument_list);
+
+    default:
+      return 0;
+  }
+}
+
+// Function to turn an integer operand of a mixed operation into a decimal
+static struct ast *as_decimal(struct ast *operand, int type) {
+  return type == INTEGER_TYPE ? new_ast_with_child(TO_DECIMAL, operand) : operand;
+}
+
+// Function to replace the arithmetic and comparisons on numbers with operations that skip the type checks
+struct ast *specialize(struct ast *abstract_syntax_tree) {
+  struct flow *flow = NULL;
+  struct for_flow *for_flow = NULL;
+  int left = NO_TYPE;
+  int right = NO_TYPE;
+
+  if(!abstract_syntax_tree) {
+    return NULL;
+  }
+
+  switch(abstract_syntax_tree->nodetype) {
+    case ASSIGNMENT:
+      ((struct assign_symbol *)abstract_syntax_tree)->v = specialize(((struct assign_symbol *)abstract_syntax_tree)->v);
+      break;
+
+    case DECLARATION_WITH_ASSIGNMENT:
+      ((struct assign_and_declare_symbol *)abstract_syntax_tree)->value = specialize(((struct assign_and_declare_symbol *)abstract_syntax_tree)->value);
+      break;
+
+    case COMPLEX_ASSIGNMENT:
+      ((struct assign_and_declare_complex_symbol *)abstract_syntax_tree)->value = specialize(((struct assign_and_declare_complex_symbol *)abstract_syntax_tree)->value);
+      break;
+
+    case STATEMENT_LIST:
+    case LOGICAL_AND:
+    case LOGICAL_OR:
+      abstract_syntax_tree->l = specialize(abstract_syntax_tree->l);
+      abstract_syntax_tree->r = specialize(abstract_syntax_tree->r);
+      break;
+
+    case '|':
+    case UNARY_MINUS:
+      abstract_syntax_tree->l = specialize(abstract_syntax_tree->l);
+      break;
+
+    case '+':
+    case '-':
+    case '*':
+    case '/':
+    case '1':  case '2':  case '3':  case '4':  case '5':  case '6':
+      abstract_syntax_tree->l = specialize(abstract_syntax_tree->l);
+      abstract_syntax_tree->r = specialize(abstract_syntax_tree->r);
+      left = static_type(abstract_syntax_tree->l);
+      right = static_type(abstract_syntax_tree->r);
+
+      if(!is_number(left) || !is_number(right)) {
+        break;
+      }
+
+      if(left == right) {
+        return new_typed_operation(abstract_syntax_tree->nodetype, left, abstract_syntax_tree->l, abstract_syntax_tree->r);
+      }
+
+      return new_typed_operation(abstract_syntax_tree->nodetype, DECIMAL_TYPE,
+        as_decimal(abstract_syntax_tree->l, left), as_decimal(abstract_syntax_tree->r, right));
+
+    case IF_STATEMENT:
+    case LOOP_STATEMENT:
+      flow = (struct flow *)abstract_syntax_tree;
+      flow->condition = specialize(flow->condition);
+      flow->then_list = specialize(flow->then_list);
+      flow->else_list = specialize(flow->else_list);
+      break;
+
+    case FOR_STATEMENT:
+      for_flow = (struct for_flow *)abstract_syntax_tree;
+      for_flow->initialization = specialize(for_flow->initialization);
+      for_flow->condition = specialize(for_flow->condition);
+      for_flow->then_list = specialize(for_flow->then_list);
+      for_flow->else_list = specialize(for_flow->else_list);
+      break;
+
+    case BUILTIN_TYPE:
+      ((struct builtin_function_call *)abstract_syntax_tree)->argument_list = specialize(((struct builtin_function_call *)abstract_syntax_tree)->argument_list);
+      break;
+
+    case USER_CALL:
+      ((struct user_function_call *)abstract_syntax_tree)->argument_list = specialize(((struct user_function_call *)abstract_syntax_tree)->argument_list);
+      break;
+  }
+
+  return abstract_syntax_tree;
+}
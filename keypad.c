@@ -0,0 +1,367 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "learnpi.h"
+#include "backend.h"
+#include "trace.h"
+#include "keypad.h"
+
+// Microseconds a column is driven low before its rows are read
+#define KEYPAD_SETTLE_US 5
+
+// States of the debounce of a key, the pending states count the scans the new level held
+enum key_state {
+  KEY_UP,
+  KEY_GOING_DOWN,
+  KEY_DOWN,
+  KEY_GOING_UP
+};
+
+int keypad_rate_hz = KEYPAD_DEFAULT_RATE_HZ;
+
+static struct keypad_scanner keypads[MAX_KEYPADS];
+// Held by the scanner thread for a scan of every keypad and by scripts while they take or free a slot
+static pthread_mutex_t keypad_lock = PTHREAD_MUTEX_INITIALIZER;
+// Signalled when a keypad is added, the scanner thread sleeps on it while there is none
+static pthread_cond_t keypad_added = PTHREAD_COND_INITIALIZER;
+
+// Function to find the keypad of the current interpreter on a first row pin, NULL if it is not scanned
+static struct keypad_scanner *find_keypad(const unsigned *pins) {
+  for(int i = 0; i < MAX_KEYPADS; i++) {
+    if(keypads[i].owner == current_context && keypads[i].rows[0] == pins[0]) {
+      return &keypads[i];
+    }
+  }
+
+  return NULL;
+}
+
+// Characters of a standard 4x4 keypad by row and column
+static const char key_map[KEYPAD_ROWS][KEYPAD_COLUMNS] = {
+  {'1', '2', '3', 'A'},
+  {'4', '5', '6', 'B'},
+  {'7', '8', '9', 'C'},
+  {'*', '0', '#', 'D'}
+};
+
+// Function to queue a key event, called from the scanner thread only
+static void push_key_event(struct keypad_scanner *keypad, char key, int down, uint32_t tick) {
+  unsigned head = atomic_load_explicit(&keypad->head, memory_order_relaxed);
+  struct key_event *event = NULL;
+
+  // Drop the event if the script is not keeping up
+  if(head - atomic_load_explicit(&keypad->tail, memory_order_acquire) == KEY_QUEUE_SIZE) {
+    atomic_fetch_add_explicit(&keypad->dropped_events, 1, memory_order_relaxed);
+    return;
+  }
+
+  event = &keypad->events[head & (KEY_QUEUE_SIZE - 1)];
+  event->key = key;
+  event->down = down;
+  event->tick = tick;
+  atomic_store_explicit(&keypad->head, head + 1, memory_order_release);
+
+  sem_post(&keypad->available);
+}
+
+// Function to feed one scan of a key to its debounce, a new level has to hold for samples scans to count
+static void debounce_key(struct keypad_scanner *keypad, int row, int column, int down, int samples, uint32_t tick) {
+  struct key_debounce *key = &keypad->keys[row][column];
+
+  switch(key->state) {
+    case KEY_UP:
+    case KEY_GOING_DOWN:
+      if(!down) {
+        key->state = KEY_UP;
+        break;
+      }
+
+      key->samples = key->state == KEY_UP ? 1 : key->samples + 1;
+      key->state = KEY_GOING_DOWN;
+
+      if(key->samples >= samples) {
+        key->state = KEY_DOWN;
+        push_key_event(keypad, key_map[row][column], 1, tick);
+      }
+      break;
+
+    case KEY_DOWN:
+    case KEY_GOING_UP:
+      if(down) {
+        key->state = KEY_DOWN;
+        break;
+      }
+
+      key->samples = key->state == KEY_DOWN ? 1 : key->samples + 1;
+      key->state = KEY_GOING_UP;
+
+      if(key->samples >= samples) {
+        key->state = KEY_UP;
+        push_key_event(keypad, key_map[row][column], 0, tick);
+      }
+      break;
+  }
+}
+
+// Function to wait for the rows to settle after a column is driven low.
+// It spins on the clock instead of a delay of the backend, which a record would take once per column of every scan.
+static void settle_rows() {
+  struct timespec start;
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  do {
+    clock_gettime(CLOCK_MONOTONIC, &now);
+  } while((now.tv_sec - start.tv_sec) * 1000000000L + now.tv_nsec - start.tv_nsec < KEYPAD_SETTLE_US * 1000L);
+}
+
+// Function to read every key of a keypad once, one column at a time
+static void scan_keypad(struct keypad_scanner *keypad, int samples) {
+  uint32_t tick = 0;
+
+  for(int column = 0; column < KEYPAD_COLUMNS; column++) {
+    gpio_backend->write(keypad->columns[column], 0);
+    settle_rows();
+    tick = gpio_backend->tick();
+
+    for(int row = 0; row < KEYPAD_ROWS; row++) {
+      debounce_key(keypad, row, column, gpio_backend->read(keypad->rows[row]) == 0, samples, tick);
+    }
+
+    gpio_backend->write(keypad->columns[column], 1);
+  }
+}
+
+// Function to scan the keypads at the keypad rate, the start routine of the scanner thread
+static void *keypad_thread(void *argument) {
+  struct timespec next;
+  long period_ns = 1000000000L / keypad_rate_hz;
+  // Scans a new level has to hold for the debounce time, at least one
+  int samples = keypad_rate_hz * KEYPAD_DEBOUNCE_MS / 1000;
+  int scanned = 0;
+
+  (void)argument;
+
+  if(samples < 1) {
+    samples = 1;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  pthread_mutex_lock(&keypad_lock);
+
+  for(;;) {
+    scanned = 0;
+
+    for(int i = 0; i < MAX_KEYPADS; i++) {
+      if(keypads[i].owner) {
+        scan_keypad(&keypads[i], samples);
+        scanned = 1;
+      }
+    }
+
+    if(!scanned) {
+      pthread_cond_wait(&keypad_added, &keypad_lock);
+      clock_gettime(CLOCK_MONOTONIC, &next);
+      continue;
+    }
+
+    pthread_mutex_unlock(&keypad_lock);
+
+    // Scans keep their rate however long the last one took
+    next.tv_nsec += period_ns;
+
+    if(next.tv_nsec >= 1000000000L) {
+      next.tv_sec++;
+      next.tv_nsec -= 1000000000L;
+    }
+
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR);
+
+    pthread_mutex_lock(&keypad_lock);
+  }
+
+  return NULL;
+}
+
+// Function to start the scanner thread, run once when the first keypad is declared
+static void start_keypad_thread() {
+  pthread_t thread;
+
+  if(pthread_create(&thread, NULL, keypad_thread, NULL) != 0) {
+    fprintf(stderr, "Cannot start the keypad thread, keypads read no keys.\n");
+    return;
+  }
+
+  pthread_detach(thread);
+}
+
+static pthread_once_t keypad_thread_started = PTHREAD_ONCE_INIT;
+
+// Function to take the oldest event of a keypad off its ring, returns 0 if it is empty
+static int pop_key_event(struct keypad_scanner *keypad, struct key_event *event) {
+  unsigned tail = atomic_load_explicit(&keypad->tail, memory_order_relaxed);
+
+  if(tail == atomic_load_explicit(&keypad->head, memory_order_acquire)) {
+    return 0;
+  }
+
+  *event = keypad->events[tail & (KEY_QUEUE_SIZE - 1)];
+  atomic_store_explicit(&keypad->tail, tail + 1, memory_order_release);
+
+  return 1;
+}
+
+// Function to wait for the next key event of a keypad, 0 ms does not wait and a negative time waits forever
+static int wait_for_key_event(struct keypad_scanner *keypad, struct timespec *deadline, int timeout_ms) {
+  if(timeout_ms == 0) {
+    return sem_trywait(&keypad->available) == 0;
+  }
+
+  if(timeout_ms < 0) {
+    while(sem_wait(&keypad->available) == -1 && errno == EINTR);
+    return 1;
+  }
+
+  while(sem_timedwait(&keypad->available, deadline) == -1) {
+    if(errno != EINTR) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+// Function to take the next simulated press of a keypad, the keys of LEARNPI_SIM_KEYS are pressed in turn at the
+// simulated presses of the buttons. Returns 0 if there is none before the timeout.
+static char simulated_key(struct keypad_scanner *keypad, int timeout_ms) {
+  const char *keys = getenv("LEARNPI_SIM_KEYS");
+  uint64_t press_us = next_simulated_press(keypad->last_press_us);
+  uint64_t now_us = virtual_time_us();
+  char key = 0;
+
+  if(!keys || !*keys) {
+    keys = "A";
+  }
+
+  if(press_us > now_us) {
+    if(timeout_ms == 0) {
+      return 0;
+    }
+
+    if(timeout_ms > 0 && press_us > now_us + timeout_ms * 1000ULL) {
+      advance_virtual_time(timeout_ms * 1000ULL);
+      return 0;
+    }
+
+    advance_virtual_time(press_us - now_us);
+  }
+
+  key = keys[keypad->presses++ % strlen(keys)];
+  keypad->last_press_us = press_us;
+
+  trace(TRACE_INFO, "Simulated key %c pressed at %llu us.\n", key, (unsigned long long)press_us);
+  return key;
+}
+
+// Function to start scanning a keypad, the first four pins are the rows and the last four the columns.
+// Returns 0 if OK, -1 if too many keypads are scanned.
+int start_keypad(const unsigned *pins) {
+  struct keypad_scanner *keypad = NULL;
+
+  // The simulation backend has no scanner, its keys are pressed on the virtual clock of the script
+  if(!gpio_backend->simulated) {
+    pthread_once(&keypad_thread_started, start_keypad_thread);
+  }
+
+  pthread_mutex_lock(&keypad_lock);
+
+  for(int i = 0; i < MAX_KEYPADS && !keypad; i++) {
+    if(!keypads[i].owner) {
+      keypad = &keypads[i];
+    }
+  }
+
+  if(!keypad) {
+    pthread_mutex_unlock(&keypad_lock);
+    return -1;
+  }
+
+  memset(keypad->keys, 0, sizeof(keypad->keys));
+  memcpy(keypad->rows, pins, sizeof(keypad->rows));
+  memcpy(keypad->columns, pins + KEYPAD_ROWS, sizeof(keypad->columns));
+  atomic_init(&keypad->head, 0);
+  atomic_init(&keypad->tail, 0);
+  atomic_init(&keypad->dropped_events, 0);
+  sem_init(&keypad->available, 0, 0);
+
+  // Only simulated presses after the keypad was declared reach the script
+  keypad->presses = 0;
+  keypad->last_press_us = gpio_backend->simulated ? virtual_time_us() : 0;
+
+  keypad->owner = current_context;
+  pthread_cond_signal(&keypad_added);
+  pthread_mutex_unlock(&keypad_lock);
+
+  return 0;
+}
+
+// Function to take the next key pressed on a keypad, waits up to timeout_ms, forever if it is negative.
+// Released keys are skipped. Returns 0 if no key was pressed in time.
+char read_key(const unsigned *pins, int timeout_ms) {
+  struct keypad_scanner *keypad = NULL;
+
+  // Only the interpreter that owns the slot frees it, so it stays valid once found
+  pthread_mutex_lock(&keypad_lock);
+  keypad = find_keypad(pins);
+  pthread_mutex_unlock(&keypad_lock);
+
+  if(!keypad) {
+    return 0;
+  }
+
+  if(gpio_backend->simulated) {
+    return simulated_key(keypad, timeout_ms);
+  }
+
+  struct key_event event;
+  struct timespec deadline;
+
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += timeout_ms / 1000;
+  deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+  if(deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+
+  while(wait_for_key_event(keypad, &deadline, timeout_ms)) {
+    if(pop_key_event(keypad, &event) && event.down) {
+      return event.key;
+    }
+  }
+
+  return 0;
+}
+
+// Function to stop scanning the keypads of the current interpreter
+void release_keypads() {
+  pthread_mutex_lock(&keypad_lock);
+
+  for(int i = 0; i < MAX_KEYPADS; i++) {
+    if(keypads[i].owner == current_context) {
+      keypads[i].owner = NULL;
+      sem_destroy(&keypads[i].available);
+    }
+  }
+
+  pthread_mutex_unlock(&keypad_lock);
+}
@@ -0,0 +1,61 @@
+#ifndef KEYPAD_H
+#define KEYPAD_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <semaphore.h>
+
+// Keypads scanned at the same time, one per script is the usual case
+#define MAX_KEYPADS 8
+#define KEYPAD_ROWS 4
+#define KEYPAD_COLUMNS 4
+#define KEY_QUEUE_SIZE 64 // must be a power of two
+// Scans per second when --keypad-rate does not set it
+#define KEYPAD_DEFAULT_RATE_HZ 1000
+// Time a key has to stay down or up before it counts as pressed or released
+#define KEYPAD_DEBOUNCE_MS 10
+
+// Structure for a key that went down or up
+struct key_event {
+  char key;
+  int down;
+  uint32_t tick;                   // microseconds, pigpio ticks on the Pi and the virtual clock with the simulation backend
+};
+
+// Structure for the debounce of one key, it only changes state after the raw level held for the debounce time
+struct key_debounce {
+  unsigned char state;             // see enum key_state in keypad.c
+  unsigned char samples;           // scans the raw level differed from the state
+};
+
+// Structure for a keypad the scanner thread watches.
+// Its events go through a single producer, single consumer ring: the scanner pushes and the script that declared it pops.
+struct keypad_scanner {
+  void *owner;                     // interpreter that declared the keypad, NULL if the slot is free
+  unsigned rows[KEYPAD_ROWS];      // inputs pulled up, a pressed key pulls its row low
+  unsigned columns[KEYPAD_COLUMNS];  // outputs held high, the scan drives one low at a time
+  struct key_debounce keys[KEYPAD_ROWS][KEYPAD_COLUMNS];
+  struct key_event events[KEY_QUEUE_SIZE];
+  atomic_uint head;                // next slot the scanner writes
+  atomic_uint tail;                // next slot the script reads
+  sem_t available;                 // posted once for every queued event
+  atomic_uint dropped_events;
+  uint64_t presses;                // simulated presses the script has taken, the simulation backend has no scanner
+  uint64_t last_press_us;
+};
+
+// Function to start scanning a keypad, the first four pins are the rows and the last four the columns.
+// Returns 0 if OK, -1 if too many keypads are scanned.
+int start_keypad(const unsigned *pins);
+
+// Function to take the next key pressed on a keypad, waits up to timeout_ms, forever if it is negative.
+// Released keys are skipped. Returns 0 if no key was pressed in time.
+char read_key(const unsigned *pins, int timeout_ms);
+
+// Function to stop scanning the keypads of the current interpreter
+void release_keypads();
+
+// Scans per second, set with --keypad-rate
+extern int keypad_rate_hz;
+
+#endif
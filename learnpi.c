@@ -7,17 +7,27 @@
 #include <stdarg.h>
 #include <stdbool.h>
 #include <string.h>
-
-#ifndef RPI_SIMULATION
-#include <pigpio.h>
-#endif
+#include <pthread.h>
+#include <stdatomic.h>
 
 #include "learnpi.h"
 #include "functions.h"
+#include "bytecode.h"
+#include "arena.h"
+#include "trace.h"
+#include "gpio_batch.h"
+#include "cache.h"
+#include "profile.h"
+#include "realtime.h"
+#include "backend.h"
 
 extern int yydebug;
-extern FILE *yyin;
-int is_file = 0;
+
+// Interpreter of the calling thread
+_Thread_local struct interpreter_context *current_context = NULL;
+
+// Pins claimed by the devices of every interpreter, a pin belongs to one script at a time
+static _Atomic uint64_t claimed_pins = 0;
 
 // Hash a symbol using its string
 static unsigned symhash(char *sym) {
@@ -32,20 +42,24 @@ static unsigned symhash(char *sym) {
 
 // Function to lookup variables in symbol table
 struct symbol *lookup(char* sym) {
+  struct symbol *symtab = current_context->symtab;
   struct symbol *sp = &symtab[symhash(sym)%NHASH];
   int scount = NHASH;		/* how many have we looked at */
 
   while(--scount >= 0) {
     if(sp->name && !strcmp(sp->name, sym)) { 
-      printf("Value already declared.\n");
+      trace(TRACE_DEBUG, "Value already declared.\n");
       return sp; 
     }
 
     if(!sp->name) {		/* new entry */
         sp->name = strdup(sym);
-        sp->value = NULL;
+        sp->value.type = NO_TYPE;
         sp->func = NULL;
         sp->syms = NULL;
+        sp->code = NULL;
+        sp->nodes = NULL;
+        sp->inferred_type = NO_TYPE;
         return sp;
     }
 
@@ -56,9 +70,121 @@ struct symbol *lookup(char* sym) {
   abort(); /* tried them all, table is full */
 }
 
+// Function to create an interpreter with an empty symbol table
+struct interpreter_context *create_interpreter_context() {
+  struct interpreter_context *context = calloc(1, sizeof(struct interpreter_context));
+
+  if(!context) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  context->line = 1;
+  clock_gettime(CLOCK_MONOTONIC, &context->timing.started);
+  context->pattern.wave_id = -1;
+
+  if(realtime_enabled) {
+    preallocate_interpreter(context);
+  }
+
+  return context;
+}
+
+// Function to free an interpreter and release the pins of its devices
+void free_interpreter_context(struct interpreter_context *context) {
+  // A pattern still playing or a keypad still scanned would keep using released pins
+  if(context == current_context) {
+    stop_pattern();
+    release_keypads();
+  }
+
+  for(int i = 0; i < NHASH; i++) {
+    struct symbol *sp = &context->symtab[i];
+
+    if(!sp->name) {
+      continue;
+    }
+
+    free_program(sp->code);
+    if(sp->nodes) arena_free(sp->nodes);
+    free(sp->name);
+  }
+
+  if(context->parse_arena) {
+    arena_free(context->parse_arena);
+  }
+
+  free_string_table(&context->strings);
+  free_heap(&context->heap);
+  free(context->value_stack);
+  free(context->call_stack);
+  atomic_fetch_and(&claimed_pins, ~context->devices.claimed_pins);
+  free(context);
+}
+
+// Function to claim a pin for a device of the current interpreter, returns 0 if another script uses it
+int claim_pin(unsigned pin) {
+  uint64_t bit = (uint64_t)1 << pin;
+
+  if(current_context->devices.claimed_pins & bit) {
+    return 1;
+  }
+
+  if(atomic_fetch_or(&claimed_pins, bit) & bit) {
+    return 0;
+  }
+
+  current_context->devices.claimed_pins |= bit;
+  return 1;
+}
+
+// Function to get the line errors of the current interpreter report
+int current_line() {
+  if(!current_context) {
+    return 0;
+  }
+
+  if(current_context->scanner) {
+    return yyget_lineno(current_context->scanner);
+  }
+
+  return current_context->line;
+}
+
+// Function to allocate in the arena of the current parse unit
+static void *parse_alloc(size_t size) {
+  if(!current_context->parse_arena) {
+    current_context->parse_arena = arena_create();
+
+    if(!current_context->parse_arena) {
+      return NULL;
+    }
+  }
+
+  return arena_alloc(current_context->parse_arena, size);
+}
+
+// Function to allocate a node in the arena of the current parse unit, on the line the scanner is at
+static void *new_node(size_t size) {
+  struct ast *node = parse_alloc(size);
+
+  if(node) {
+    node->line = current_context->scanner ? current_context->token_line : 0;
+  }
+
+  return node;
+}
+
+// Function to free every node of the parse unit that was just evaluated
+void free_parse_unit() {
+  if(current_context->parse_arena) {
+    arena_reset(current_context->parse_arena);
+  }
+}
+
 // Function for new declaration
 struct ast *new_declaration(char *s, int type) {
-  struct declare_symbol *declaration = malloc(sizeof(struct declare_symbol));
+  struct declare_symbol *declaration = new_node(sizeof(struct declare_symbol));
 
   if(!declaration) {
     yyerror("out of space");
@@ -68,13 +194,15 @@ struct ast *new_declaration(char *s, int type) {
   declaration->nodetype = DECLARATION;
   declaration->type = type;
   declaration->s = s;
+  declaration->scope = UNRESOLVED;
+  declaration->slot = 0;
   
   return (struct ast *)declaration;
 }
 
 // Function for new variable agisnment
 struct ast * new_assignment(char *s, struct ast *v) {
-  struct symasgn *assignment = malloc(sizeof(struct symasgn));
+  struct symasgn *assignment = new_node(sizeof(struct symasgn));
 
   if(!assignment) {
     yyerror("out of space");
@@ -84,13 +212,24 @@ struct ast * new_assignment(char *s, struct ast *v) {
   assignment->nodetype = ASSIGNMENT;
   assignment->s = s;
   assignment->v = v;
+  assignment->scope = UNRESOLVED;
+  assignment->slot = 0;
+  assignment->declared = 0;
 
   return (struct ast *)assignment;
 }
 
+// Function for new variable assignment written as a declaration, TYPE NAME = value
+struct ast *new_declared_assignment(char *s, struct ast *v) {
+  struct symasgn *assignment = (struct symasgn *)new_assignment(s, v);
+
+  assignment->declared = 1;
+  return (struct ast *)assignment;
+}
+
 // Function for new complex variable assignment
 struct ast *new_complex_assignment(char *s, int type, struct ast *value) {
-  struct assign_and_declare_complex_symbol *complex_value = malloc(sizeof(struct assign_and_declare_complex_symbol));
+  struct assign_and_declare_complex_symbol *complex_value = new_node(sizeof(struct assign_and_declare_complex_symbol));
 
   if(!complex_value) {
     yyerror("out of space");
@@ -101,13 +240,15 @@ struct ast *new_complex_assignment(char *s, int type, struct ast *value) {
   complex_value->type = type;
   complex_value->value = value;
   complex_value->s = s;
+  complex_value->scope = UNRESOLVED;
+  complex_value->slot = 0;
 
   return (struct ast *)complex_value;
 }
 
 // Function to create an AST with generic node type and one child
 struct ast *new_ast_with_child(int type, struct ast *l) {
-  struct ast *ast = malloc(sizeof(struct ast));
+  struct ast *ast = new_node(sizeof(struct ast));
 
   if(!ast) {
     yyerror("out of space");
@@ -122,7 +263,7 @@ struct ast *new_ast_with_child(int type, struct ast *l) {
 
 // Function to create an AST with generic node type and two children
 struct ast *new_ast_with_children(int type, struct ast *l, struct ast *r) {
-  struct ast *ast = malloc(sizeof(struct ast));
+  struct ast *ast = new_node(sizeof(struct ast));
 
   if(!ast) {
     yyerror("out of space");
@@ -136,9 +277,27 @@ struct ast *new_ast_with_children(int type, struct ast *l, struct ast *r) {
   return ast;
 }
 
+// Function to create an operation on two numbers of a known type
+struct ast *new_typed_operation(int operation, int operand_type, struct ast *l, struct ast *r) {
+  struct typed_operation *ast = new_node(sizeof(struct typed_operation));
+
+  if(!ast) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  ast->nodetype = TYPED_OPERATION;
+  ast->l = l;
+  ast->r = r;
+  ast->operation = operation;
+  ast->operand_type = operand_type;
+
+  return (struct ast *)ast;
+}
+
 // Function to create a new value
-struct ast *new_value(struct val *value) {
-  struct constant_value *ast = malloc(sizeof(struct constant_value));
+struct ast *new_value(struct val value) {
+  struct constant_value *ast = new_node(sizeof(struct constant_value));
 
   if(!ast) {
     yyerror("No space.");
@@ -153,7 +312,7 @@ struct ast *new_value(struct val *value) {
 
 // Function to create a new reference
 struct ast *new_reference(char *s) {
-  struct symbol_reference *ast = malloc(sizeof(struct symbol_reference));
+  struct symbol_reference *ast = new_node(sizeof(struct symbol_reference));
 
   if(!ast) {
     yyerror("No space.");
@@ -162,13 +321,15 @@ struct ast *new_reference(char *s) {
 
   ast->nodetype = NEW_REFERENCE;
   ast->s = s;
+  ast->scope = UNRESOLVED;
+  ast->slot = 0;
 
   return (struct ast *)ast;
 }
 
 // Function to create an AST with comparision type
 struct ast *new_comparison(int type, struct ast *l, struct ast *r) {
-  struct ast *ast = malloc(sizeof(struct ast));
+  struct ast *ast = new_node(sizeof(struct ast));
 
     if(!ast) {
       yyerror("No space");
@@ -193,7 +354,7 @@ void define_function(char *function_name, struct symbol_list *symbol_list, struc
 
 // Function to create a new symbol list
 struct symbol_list *create_symbol_list(char *symbol, struct symbol_list *next) {
-  struct symbol_list *new_symbol_list = malloc(sizeof(struct symbol_list));
+  struct symbol_list *new_symbol_list = parse_alloc(sizeof(struct symbol_list));
 
   if(!new_symbol_list) {
     yyerror("out of space");
@@ -208,7 +369,7 @@ struct symbol_list *create_symbol_list(char *symbol, struct symbol_list *next) {
 
 // Function to create a new control flow
 struct ast *newflow(int nodetype, struct ast *cond, struct ast *tl, struct ast *tr) {
-  struct flow *flow = malloc(sizeof(struct flow));
+  struct flow *flow = new_node(sizeof(struct flow));
 
   if(!flow) {
     yyerror("out of space");
@@ -220,11 +381,16 @@ struct ast *newflow(int nodetype, struct ast *cond, struct ast *tl, struct ast *
   flow->then_list = tl;
   flow->else_list = tr;
 
+  // The node is made once its closing brace is read, it belongs to the line of its condition
+  if(cond) {
+    flow->line = cond->line;
+  }
+
   return (struct ast *)flow;
 }
 
 struct ast *new_for_flow(int nodetype, struct ast *initialization, struct ast *cond, struct ast *tl, struct ast *tr) {
-  struct for_flow *flow = malloc(sizeof(struct for_flow));
+  struct for_flow *flow = new_node(sizeof(struct for_flow));
 
   if(!flow) {
     yyerror("out of space");
@@ -237,493 +403,46 @@ struct ast *new_for_flow(int nodetype, struct ast *initialization, struct ast *c
   flow->then_list = tl;
   flow->else_list = tr;
 
+  if(initialization) {
+    flow->line = initialization->line;
+  }
+
   return (struct ast *)flow;
 }
 
-// Function to evaluate an AST
-struct val * eval(struct ast *abstract_syntax_tree) {
-  struct symbol *s = NULL;
-  struct val *v = NULL;
-  struct val *helper_value = NULL;
-  struct declare_symbol *declare_symbol = NULL;
-  struct assign_and_declare_symbol *assign_and_declare_symbol = NULL;
-  struct assign_and_declare_complex_symbol *assign_and_declare_complex_symbol = NULL;
-  struct ast *args = NULL;
-  struct val *evaluation_helper = NULL;
-  struct val *initialization_helper = NULL;
-
-  // Return null if no AST is found
-  if(!abstract_syntax_tree) {
-    return NULL;
-  }
-
-  switch(abstract_syntax_tree->nodetype) {
-    case CONSTANT:
-      printf("Evaluating CONSTANT...\n");
-      evaluation_helper = ((struct constant_value *)abstract_syntax_tree)->v;
-      switch(evaluation_helper->type) {
-          case BIT_TYPE:
-            v = create_bit_value(evaluation_helper->datavalue.bit);
-            printf("CONSTANT value is: %d\n", v->datavalue.bit);
-            break;
-          case INTEGER_TYPE:
-            v = create_integer_value(evaluation_helper->datavalue.integer);
-            printf("CONSTANT value is: %d\n", v->datavalue.integer);
-            break;
-          case DECIMAL_TYPE:
-            v = create_decimal_value(evaluation_helper->datavalue.decimal);
-            printf("CONSTANT value is: %f\n", v->datavalue.decimal);
-            break;
-          case STRING_TYPE:
-            v = create_string_value(evaluation_helper->datavalue.string);
-            printf("CONSTANT value is: %s\n", v->datavalue.string);
-            break;
-      }
-    break;
-
-    case NEW_REFERENCE:
-      printf("Evaluating NEW REFERENCE...\n");
-      s = lookup(((struct symbol_reference *)abstract_syntax_tree)->s);
-
-      // Check if new reference is created correctly
-      if(!s) {
-        yyerror("variable %s not found.", ((struct symbol_reference *)abstract_syntax_tree)->s);
-        free(abstract_syntax_tree);
-        return NULL;
-      }
-
-      v = s->value;
-      printf("New reference evaluation type is: %d\n", s->value->type);
-      printf("Evaluated NEW REFERENCE...\n");
-      break;
-
-    case ASSIGNMENT:
-      printf("Before the assignment node type is: %d\n", ((struct assign_symbol *)abstract_syntax_tree)->v->nodetype);
-      s = lookup(((struct assign_symbol *)abstract_syntax_tree)->s);
-
-      //Check if symbol exists
-      if(!s) {
-        yyerror("Cannot find symbol %s.\n", ((struct assign_symbol *)abstract_syntax_tree)->s);
-        free(v);
-        free(abstract_syntax_tree);
-        return NULL;
-      }
-
-      // Evaluate the assignment
-      v = eval(((struct assign_symbol *)abstract_syntax_tree)->v);
-
-      // Assign the symbol value to symbol
-      s->value = v;
-      break;
-
-    case '+':
-      v = sum(eval(abstract_syntax_tree->l), eval(abstract_syntax_tree->r));
-      break;
-    case '-': 
-      v = subtract(eval(abstract_syntax_tree->l), eval(abstract_syntax_tree->r));
-      break;
-    case '*': 
-      v = multiply(eval(abstract_syntax_tree->l), eval(abstract_syntax_tree->r));
-      break;
-    case '/': 
-      v = divide(eval(abstract_syntax_tree->l), eval(abstract_syntax_tree->r));
-      break;
-    case '|': 
-      v = get_absolute_value(eval(abstract_syntax_tree->l)); 
-      break;
-    case UNARY_MINUS: 
-      v = change_sign(eval(abstract_syntax_tree->l));
-      break;
-
-    case LOGICAL_AND: 
-      v = calculate_logical_and(eval(abstract_syntax_tree->l),eval(abstract_syntax_tree->r)); 
-      break;
-    case LOGICAL_OR: 
-      v = calculate_logical_or(eval(abstract_syntax_tree->l),eval(abstract_syntax_tree->r)); 
-      break;
-
-    case '1':
-      v = calculate_greater_than(eval(abstract_syntax_tree->l), eval(abstract_syntax_tree->r));
-      break;
-    case '2': 
-      v = calculate_less_than(eval(abstract_syntax_tree->l), eval(abstract_syntax_tree->r));
-      break;
-    case '3':
-      v = calculate_not_equals(eval(abstract_syntax_tree->l), eval(abstract_syntax_tree->r));
-      break;
-    case '4': 
-      v = calculate_equals(eval(abstract_syntax_tree->l), eval(abstract_syntax_tree->r));
-      break;
-    case '5': 
-      v = calculate_greater_equal_than(eval(abstract_syntax_tree->l), eval(abstract_syntax_tree->r)); 
-      break;
-    case '6': 
-      v = calculate_less_equal_than(eval(abstract_syntax_tree->l), eval(abstract_syntax_tree->r)); 
-      break;
-
-    case IF_STATEMENT:
-      helper_value = eval(
-        ((struct flow *)abstract_syntax_tree)->condition
-      );
-
-      // Check if value type is comparison
-      if(get_value_type(helper_value) != 0) {
-        yyerror("invalid condition");
-        free(abstract_syntax_tree);
-        return NULL;
-      }
-
-      // Check if condition is met
-      if(helper_value->datavalue.bit != 0) {
-        if(((struct flow *)abstract_syntax_tree)->then_list) {
-          v = eval(((struct flow *)abstract_syntax_tree)->then_list);
-        } else {
-          v = NULL;
-        }   
-      } else {
-        // Else, create an AST with else list
-        if(((struct flow *)abstract_syntax_tree)->else_list) {
-          v = eval(((struct flow *)abstract_syntax_tree)->else_list);
-        } else {
-          v = NULL;
-        }  
-      }
-      break;
-
-    case FOR_STATEMENT:
-      initialization_helper = eval(((struct for_flow *)abstract_syntax_tree)->initialization);
-      if(initialization_helper != NULL) {
-        printf("Initialization evaluation is not null.\n");
-      }
-
-      helper_value = eval(
-        ((struct for_flow *)abstract_syntax_tree)->condition
-      );
-
-      // Check if value type is comparison
-      if(get_value_type(helper_value) != 0) {
-        yyerror("invalid condition");
-        free(abstract_syntax_tree);
-        return NULL;
-      }
-
-      // Check if condition is met
-      if(helper_value->datavalue.bit != 0) {
-        if(((struct for_flow *)abstract_syntax_tree)->then_list) {
-          v = eval(((struct for_flow *)abstract_syntax_tree)->then_list);
-        } else {
-          v = NULL;
-        }   
-      } else {
-        // Else, create an AST with else list
-        if(((struct for_flow *)abstract_syntax_tree)->else_list) {
-          v = eval(((struct for_flow *)abstract_syntax_tree)->else_list);
-        } else {
-          v = NULL;
-        }  
-      }
-      break;
-
-    case LOOP_STATEMENT:
-      v = NULL;
-
-      // Check if we have then list in AST
-      if(((struct flow *)abstract_syntax_tree)->then_list) {
-        helper_value = (eval(((struct flow *)abstract_syntax_tree)->condition));
-
-        // Check if value type is comparison
-        if(get_value_type(helper_value) != 0) {
-          yyerror("invalid condition");
-          free(abstract_syntax_tree);
-          return NULL;
-        }
-
-        // Loop while condition is met
-        while(helper_value->datavalue.bit != 0) {
-          v = eval(((struct flow *)abstract_syntax_tree)->then_list);
-          helper_value = (eval(((struct flow *)abstract_syntax_tree)->condition));
-        }
-      }
-      break;
-  
-    case STATEMENT_LIST:
-      evaluation_helper = eval(abstract_syntax_tree->l);
-      //eval(abstract_syntax_tree->l);
-      printf("Statement list nodetype is: %d.\n", abstract_syntax_tree->l->nodetype);
-      printf("Value type before second evaluation is: %d\n", evaluation_helper->type);
-      v = eval(abstract_syntax_tree->r);
-
-      // Assign type to value after evaluation in order not to lose the type information
-      switch (evaluation_helper->type) {
-        case BIT_TYPE:
-          v->type = BIT_TYPE;
-          break;
-        
-        case INTEGER_TYPE:
-          v->type = INTEGER_TYPE;
-          break;
-
-        case DECIMAL_TYPE:
-          v->type = DECIMAL_TYPE;
-          break;
+// Function to evaluate an AST by compiling it to bytecode and running it
+struct val eval(struct ast *abstract_syntax_tree) {
+  struct program *program = NULL;
+  struct val v;
 
-        case STRING_TYPE:
-          v->type = STRING_TYPE;
-          break;
-
-        case LED:
-          v->type = LED;
-          break;
-
-        case BUTTON:
-          v->type = BUTTON;
-          break;
-
-        case KEYPAD:
-          v->type = KEYPAD;
-          break;
-
-        case BUZZER:
-          v->type = BUZZER;
-          break;
-
-        case SERVO_MOTOR:
-          v->type = SERVO_MOTOR;
-          break;
-      
-        default:
-        v->type = INTEGER_TYPE;
-          break;
-      }
-      
-      break;
-
-    case BUILTIN_TYPE:
-      v = builtin_function_call((struct builtin_function_call *)abstract_syntax_tree);
-      break;
-
-    case USER_CALL:
-      calluser((struct user_function_call *)abstract_syntax_tree);
-      break;
-
-    case DECLARATION:
-        declare_symbol = (struct declare_symbol *)abstract_syntax_tree;
-        s = lookup(declare_symbol->s);
-        printf("Inserted symbol.");
-
-        // Control if variable is inserted as symbol
-        if(!s) {
-          free(declare_symbol->s);
-          free(declare_symbol);
-          return NULL;
-        }
-
-        // Check symbol declaration types to assign symbol value
-        switch(declare_symbol->type) {
-          case BIT_TYPE:
-            s->value = create_bit_value(0);
-            break;
-          case INTEGER_TYPE:
-            s->value = create_integer_value(0);
-            break;
-          case DECIMAL_TYPE:
-            s->value = create_decimal_value(0.0);
-            break;
-          case STRING_TYPE:
-            s->value = create_string_value("");
-            break;
-          case LED:
-            s->value = create_led_value(NULL, 1);
-            break;
-          case BUTTON:
-            s->value = create_button_value(NULL, 1);
-            break;
-          case KEYPAD:
-            s->value = create_keypad_value(NULL, 1);
-            break;
-          case BUZZER:
-            s->value = create_buzzer_value(NULL, 1);
-            break;
-          case SERVO_MOTOR:
-            s->value = create_servo_motor_value(NULL, 1);
-            break;
-          default:
-            yyerror("Type not recognized.");
-            free(declare_symbol->s);
-            free(declare_symbol);
-            free(s->name);
-            s = NULL;
-            break;
-        }
-      break;
-
-    case DECLARATION_WITH_ASSIGNMENT:
-      assign_and_declare_symbol = ((struct assign_and_declare_symbol *)abstract_syntax_tree);
-      v = eval(assign_and_declare_symbol->value);
-
-      // Control if variable is inserted as symbol
-      if (v && assign_and_declare_symbol->type != v->type) {
-        yyerror("Type not recognized.");
-        free(assign_and_declare_symbol);
-        free(v);
-        return NULL;
-      }
-
-      // Insert the new declaration and do sanity check
-      struct symbol *s = lookup(assign_and_declare_symbol->s);
-      if(!s) {
-        free(assign_and_declare_symbol);
-        free(v);
-        return NULL;
-      }
-      s->value = v;
-      break;
-
-    case COMPLEX_ASSIGNMENT:
-      // Cast AST back to assign_and_declare_complex_symbol in order to access the fields
-      assign_and_declare_complex_symbol = (struct assign_and_declare_complex_symbol *)abstract_syntax_tree;
-
-      // Get the value of assign_and_declare_complex_symbol struct
-      args = assign_and_declare_complex_symbol->value;
-
-      // Get argument number
-      struct ast *helper = args;
-      int argument_number = 0;
-
-      while(helper != NULL) {
-          argument_number +=1;
-          helper = helper->r;
-      }
+  // Return an empty value if no AST is found
+  if(!abstract_syntax_tree) {
+    return create_empty_value();
+  }
 
-      // Declare an helper structure to memorize evaluated part of the assign_and_declare_complex_symbol structure
-      struct val ** argument_storage = (struct val **)malloc(argument_number * sizeof(struct val)); 
- 
-      for(int i=0; args!=NULL; i++) {
-        if(args->nodetype == STATEMENT_LIST) {
-          argument_storage[i] = eval(args->l);
-          args = args->r;
-        } else {
-          argument_storage[i] = eval(args);
-          args = NULL;
-        }
+  resolve(abstract_syntax_tree);
 
-        // Switch the result
-        switch(assign_and_declare_complex_symbol->type) {
-          case LED:
-              printf("LED TYPE detected.\n");
-              v = create_LED(argument_storage);
-              break;
-
-          case BUTTON:
-              printf("BUTTON TYPE detected.\n");
-              v = create_BUTTON(argument_storage);
-              break;
-
-          case KEYPAD:
-              printf("KEYPAD TYPE detected.\n");
-              v = create_KEYPAD(argument_storage);
-              break;
-
-          case BUZZER:
-              printf("BUZZER TYPE detected.\n");
-              v = create_BUZZER(argument_storage);
-              break;
-
-          case SERVO_MOTOR:
-              printf("SERVO_MOTOR TYPE detected.\n");
-              v = create_SERVO_MOTOR(argument_storage);
-              break;              
-
-          default:
-              printf("NO TYPE detected.\n");
-              v = NULL;
-              break;
-        }
-      }
+  // A statement that always fails does not run at all
+  if(check_types(abstract_syntax_tree)) {
+    return create_empty_value();
+  }
 
-      // Insert the symbol memorizing the value
-      s = lookup(assign_and_declare_complex_symbol->s);
-      s->value = v;
-      s->name = assign_and_declare_complex_symbol->s;
-      
-      break;
+  abstract_syntax_tree = fold(abstract_syntax_tree);
+  abstract_syntax_tree = specialize(abstract_syntax_tree);
+  program = compile(abstract_syntax_tree);
+  cache_statement(program);
+  v = run_program(program);
+  free_program(program);
 
-  default:
-    yyerror("internal error: bad node %d\n", abstract_syntax_tree->nodetype);
-    free(abstract_syntax_tree);
-    break;
+  // Scripts keep coalescing writes across statements, the prompt shows every statement at once
+  if(!current_context->is_file) {
+    flush_gpio_writes();
   }
-  
+
   // Return the evaluated value
   return v;
 }
 
-// Function to free AST
-void treefree(struct ast *abstract_syntax_tree) {
-  switch(abstract_syntax_tree->nodetype) {
-    case '+':
-    case '-':
-    case '*':
-    case '/':
-    case LOGICAL_OR:
-    case LOGICAL_AND:
-    case '1':  case '2':  case '3':  case '4':  case '5':  case '6':
-    case STATEMENT_LIST:
-      treefree(abstract_syntax_tree->r);
-      break;
-
-    case '|': 
-    case UNARY_MINUS:
-    case USER_CALL:
-    case BUILTIN_TYPE:
-      if(abstract_syntax_tree->l) {
-        treefree(abstract_syntax_tree->l);
-      }
-      break;
-
-    case CONSTANT: 
-    case NEW_REFERENCE: 
-    case DECLARATION:
-      break;
-
-    case ASSIGNMENT:
-      free(((struct assign_symbol *)abstract_syntax_tree)->v);
-      break;
-
-    case IF_STATEMENT:
-    case LOOP_STATEMENT: 
-      free(((struct flow *)abstract_syntax_tree)->condition);
-      if(((struct flow *)abstract_syntax_tree)->then_list) {
-        free(((struct flow *)abstract_syntax_tree)->then_list);
-      }
-      if(((struct flow *)abstract_syntax_tree)->else_list) {
-        free(((struct flow *)abstract_syntax_tree)->else_list);
-      }
-      break;
-    
-    case FOR_STATEMENT: 
-      free(((struct for_flow *)abstract_syntax_tree)->condition);
-      if(((struct for_flow *)abstract_syntax_tree)->then_list) {
-        free(((struct for_flow *)abstract_syntax_tree)->then_list);
-      }
-      if(((struct for_flow *)abstract_syntax_tree)->else_list) {
-        free(((struct for_flow *)abstract_syntax_tree)->else_list);
-      }
-      break;
-
-    case DECLARATION_WITH_ASSIGNMENT: 
-    case COMPLEX_ASSIGNMENT:
-      if(((struct assign_and_declare_symbol *)abstract_syntax_tree)->value) {
-        treefree(((struct assign_and_declare_symbol *)abstract_syntax_tree)->value);
-      }
-    break;
-
-    default: yyerror("internal error: free bad node %d\n", abstract_syntax_tree->nodetype);
-  }
-  
-  free(abstract_syntax_tree); /* always free the node itself */
-}
-
 // Function to check if we have a primitive type
 bool is_primitive(int type) {
   return type == BIT_TYPE || type == INTEGER_TYPE || type == DECIMAL_TYPE || type == STRING_TYPE;
@@ -731,7 +450,7 @@ bool is_primitive(int type) {
 
 // Function to create a node for built in function in the AST
 struct ast *new_builtin_function(int function_type, char *s, struct ast *argument_list) {
-  struct builtin_function_call *ast = malloc(sizeof(struct builtin_function_call));
+  struct builtin_function_call *ast = new_node(sizeof(struct builtin_function_call));
   
   if(!ast) {
     yyerror("No space.");
@@ -746,66 +465,49 @@ struct ast *new_builtin_function(int function_type, char *s, struct ast *argumen
   return (struct ast *)ast;
 }
 
-// Function to call built in functions
-struct val *builtin_function_call(struct builtin_function_call *builtin_function) {
-  printf("Executing built-in function call.\n");
-  struct val *result = NULL;
-  struct symbol *variable = NULL;
+// Function to create a node for a built in function that takes a list of times, they are passed after the other arguments
+struct ast *new_pattern_function(int function_type, struct ast *device, struct ast *times, struct ast *repeats) {
+  if(function_type != BUILT_IN_PLAY_PATTERN) {
+    yyerror("Only play_pattern takes a list.");
+  }
+
+  return new_builtin_function(function_type, NULL,
+    new_ast_with_children(STATEMENT_LIST, device, new_ast_with_children(STATEMENT_LIST, repeats, times)));
+}
+
+// Function to call built in functions with their evaluated arguments
+struct val builtin_function_call(int function_type, struct val *argument_storage, int number_of_arguments) {
+  trace(TRACE_DEBUG, "Executing built-in function call.\n");
+  struct val result = create_empty_value();
   struct val *value = NULL;
 
-  // Check if function has a name, else pass in an empty string to lookup
-  if(builtin_function->s != NULL) {
-    variable = lookup(builtin_function->s);
-  } else {
-    variable = lookup("");
+  // The first argument is the value the function operates on
+  if(number_of_arguments > 0) {
+    value = &argument_storage[0];
   }
-  
-  // Evaluate the argument list to assign the value
-  variable->value = eval(builtin_function->argument_list);
-  value = variable->value;
 
   if(value == NULL) {
-    printf("Value is null after the assignment!\n");
+    trace(TRACE_DEBUG, "Value is null after the assignment!\n");
   } else {
-    printf("Value is %d after the assignment!\n", value->type);
+    trace(TRACE_DEBUG, "Value is %d after the assignment!\n", value->type);
   }
 
-  struct ast *args = builtin_function->argument_list;
-  int number_of_arguments = 0;
-
-  /* count the arguments */
-  while(args) {
-    args = args->r;
-    number_of_arguments++;
-  }
-
-  // Define a val structure to store the new value
-  struct val ** argument_storage = (struct val **)malloc(number_of_arguments * sizeof(struct val));
-
-  // Memorize the argument list
-  args = builtin_function->argument_list;
+  int expected_argument_numbers = 0;
 
-  /* evaluate the arguments */
-  for(number_of_arguments = 0; args; number_of_arguments++) {
-    if(args->nodetype == STATEMENT_LIST) {
-      /* List node */
-      argument_storage[number_of_arguments] = eval(args->l);
-      args = args->r;
-    } else {			
-      /* End of the list */
-      argument_storage[number_of_arguments] = eval(args);
-      args = NULL;
+  // A device declared without pins has nothing to drive, only print can take it
+  if(function_type != BUILT_IN_PRINT) {
+    for(int i = 0; i < number_of_arguments; i++) {
+      if(argument_storage[i].type >= LED && !argument_storage[i].datavalue.GPIO_PIN) {
+        yyerror("Device has no pins.");
+        return result;
+      }
     }
   }
 
-  int expected_argument_numbers = 0;
-  
-  switch(builtin_function->function_type) {
+  switch(function_type) {
     case BUILT_IN_PRINT:
       if(!value) {
         yyerror("Value is null.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
@@ -813,19 +515,15 @@ struct val *builtin_function_call(struct builtin_function_call *builtin_function
 
       if(number_of_arguments > expected_argument_numbers) {
         yyerror("Too many arguments.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
-      print_type(value);
+      print_type(*value);
       break;
 
     case BUILT_IN_SQUARE_ROOT:
       if(value->type != DECIMAL_TYPE && value->type != INTEGER_TYPE) {
         yyerror("Operation not permitted.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
@@ -833,20 +531,16 @@ struct val *builtin_function_call(struct builtin_function_call *builtin_function
 
       if(number_of_arguments > expected_argument_numbers) {
         yyerror("Too many arguments.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
-      result = square_root(value);
-      printf("SQUARE ROOT result: %f\n", result->datavalue.decimal);
+      result = square_root(*value);
+      trace(TRACE_INFO, "SQUARE ROOT result: %f\n", result.datavalue.decimal);
       break;
 
     case BUILT_IN_LED_ON:
       if(value->type != LED) {
         yyerror("Operation not permitted.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
       
@@ -854,18 +548,14 @@ struct val *builtin_function_call(struct builtin_function_call *builtin_function
 
       if(number_of_arguments > expected_argument_numbers) {
         yyerror("Too many arguments.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
-      #ifdef RPI_SIMULATION
-       // TODO: Check if can assign LED to this pin number
-        int res = led_on(value);
-      #else
+      if(gpio_backend->simulated) {
         printf("Simulated led_on.\n");
-        int res = 0;
-      #endif
+      }
+      // TODO: Check if can assign LED to this pin number
+      int res = led_on(value);
       
       if(res != 0) {
         yyerror("Bad GPIO level.");
@@ -875,8 +565,6 @@ struct val *builtin_function_call(struct builtin_function_call *builtin_function
     case BUILT_IN_LED_OFF:
       if(value->type != LED) {
         yyerror("Operation not permitted.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
@@ -884,17 +572,13 @@ struct val *builtin_function_call(struct builtin_function_call *builtin_function
 
       if(number_of_arguments > expected_argument_numbers) {
         yyerror("Too many arguments.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
-      #ifdef RPI_SIMULATION
-        int res2 = led_off(value);
-      #else
+      if(gpio_backend->simulated) {
         printf("Simulated led_off.\n");
-        int res2 = 0;
-      #endif
+      }
+      int res2 = led_off(value);
 
       if(res2 != 0) {
         yyerror("Bad GPIO level.");
@@ -903,10 +587,8 @@ struct val *builtin_function_call(struct builtin_function_call *builtin_function
 
     case BUILT_IN_IS_BUTTON_PRESSED:
       if(value->type != BUTTON) {
-        printf("Type is: %d\n", value->type);
+        trace(TRACE_DEBUG, "Type is: %d\n", value->type);
         yyerror("Operation not permitted.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
@@ -914,24 +596,16 @@ struct val *builtin_function_call(struct builtin_function_call *builtin_function
 
       if(number_of_arguments > expected_argument_numbers) {
         yyerror("Too many arguments.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
-      printf("Calling pigpio function.\n");
-
-      #ifdef RPI_SIMULATION
-        struct val *res3 = malloc(sizeof(struct val));
-        res3 = is_button_pressed(value);
-      #else
+      // Answered from the level cached by edge events, with the simulation backend as well
+      if(gpio_backend->simulated) {
         printf("Simulated is_button_pressed.\n");
-        struct val *res3 = malloc(sizeof(struct val));
-        res3->type = BIT_TYPE;
-        res3->datavalue.bit = 0; 
-      #endif
+      }
+      struct val res3 = is_button_pressed(value);
 
-      if(res3 == NULL) {
+      if(res3.type == NO_TYPE) {
         yyerror("Pin number is not permitted to be read.\n");
       }
 
@@ -939,11 +613,14 @@ struct val *builtin_function_call(struct builtin_function_call *builtin_function
       break;
 
     case BUILT_IN_GET_PRESSED_KEY:
+      if(!value) {
+        yyerror("Too few arguments.");
+        break;
+      }
+
       if(value->type != KEYPAD) {
-        printf("Type is: %d\n", value->type);
+        trace(TRACE_DEBUG, "Type is: %d\n", value->type);
         yyerror("Operation not permitted.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
@@ -951,34 +628,55 @@ struct val *builtin_function_call(struct builtin_function_call *builtin_function
 
       if(number_of_arguments > expected_argument_numbers) {
         yyerror("Too many arguments.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
-      #ifdef RPI_SIMULATION
-        struct val *res4 = malloc(sizeof(struct val));
-        res4 = is_button_pressed(value);
-      #else
+      if(gpio_backend->simulated) {
         printf("Simulated get_pressed_key.\n");
-        struct val *res4 = malloc(sizeof(struct val));
-        res4->type = STRING_TYPE;
-        res4->datavalue.string = strdup("A"); 
-      #endif
+      }
 
-      if(res4 == NULL) {
-        yyerror("Cannot determine if key is pressed.\n");
+      // An empty string when no key was pressed since the last call
+      result = get_pressed_key(value);
+      break;
+
+    case BUILT_IN_WAIT_FOR_KEY:
+      if(!value) {
+        yyerror("Too few arguments.");
+        break;
+      }
+
+      if(value->type != KEYPAD) {
+        trace(TRACE_DEBUG, "Type is: %d\n", value->type);
+        yyerror("Operation not permitted.");
+        break;
+      }
+
+      expected_argument_numbers = 2;
+
+      if(number_of_arguments > expected_argument_numbers) {
+        yyerror("Too many arguments.");
+        break;
+      }
+
+      // Without a timeout wait until a key is pressed
+      int key_timeout_ms = -1;
+
+      if(number_of_arguments == expected_argument_numbers) {
+        if(argument_storage[1].type != INTEGER_TYPE) {
+          yyerror("Timeout should be an integer in milliseconds.");
+          break;
+        }
+
+        key_timeout_ms = argument_storage[1].datavalue.integer;
       }
 
-      result = res4;
+      result = wait_for_key(value, key_timeout_ms);
       break;
 
     case BUILT_IN_BUZZ_START:
       if(value->type != BUZZER) {
-        printf("Type is: %d\n", value->type);
+        trace(TRACE_DEBUG, "Type is: %d\n", value->type);
         yyerror("Operation not permitted.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
@@ -986,33 +684,26 @@ struct val *builtin_function_call(struct builtin_function_call *builtin_function
 
       if(number_of_arguments > expected_argument_numbers) {
         yyerror("Too many arguments.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
-      struct val *res5 = malloc(sizeof(struct val));
+      int res5 = -1;
 
-      #ifdef RPI_SIMULATION
-        res5 = buzz_start(value);
-      #else
+      if(gpio_backend->simulated) {
         printf("Simulated buzz_start.\n");
-        res5 = 0; 
-      #endif
+      }
+      res5 = buzz_start(value);
 
       if(res5 != 0) {
         yyerror("Bad GPIO level.");
       }
 
-      result = res5;
       break;
 
     case BUILT_IN_BUZZ_STOP:
       if(value->type != BUZZER) {
-        printf("Type is: %d\n", value->type);
+        trace(TRACE_DEBUG, "Type is: %d\n", value->type);
         yyerror("Operation not permitted.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
@@ -1020,67 +711,69 @@ struct val *builtin_function_call(struct builtin_function_call *builtin_function
 
       if(number_of_arguments > expected_argument_numbers) {
         yyerror("Too many arguments.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
-      struct val *res6 = malloc(sizeof(struct val));
+      int res6 = -1;
 
-      #ifdef RPI_SIMULATION
-        res6 = buzz_stop(value);
-      #else
+      if(gpio_backend->simulated) {
         printf("Simulated buzz_stop.\n");
-        res6 = 0; 
-      #endif
+      }
+      res6 = buzz_stop(value);
 
       if(res6 != 0) {
         yyerror("Bad GPIO level.");
       }
 
-      result = res6;
       break;
 
     case BUILT_IN_MOVE_SERVO_TO_ANGLE:
       if(value->type != SERVO_MOTOR) {
-        printf("Type is: %d\n", value->type);
+        trace(TRACE_DEBUG, "Type is: %d\n", value->type);
         yyerror("Operation not permitted.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
-      expected_argument_numbers = 2;
+      expected_argument_numbers = 3;
 
-      if(number_of_arguments != expected_argument_numbers) {
+      if(number_of_arguments < 2 || number_of_arguments > expected_argument_numbers) {
         yyerror("Too many or too few arguments.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
-      struct val *res7 = malloc(sizeof(struct val));
+      if(argument_storage[1].type != INTEGER_TYPE || argument_storage[1].datavalue.integer < 0 || argument_storage[1].datavalue.integer > SERVO_MAX_ANGLE) {
+        yyerror("Angle should be an integer from 0 to %d degrees.", SERVO_MAX_ANGLE);
+        break;
+      }
+
+      // Without a time the servo jumps to the angle
+      int move_ms = 0;
+
+      if(number_of_arguments == expected_argument_numbers) {
+        if(argument_storage[2].type != INTEGER_TYPE || argument_storage[2].datavalue.integer < 0) {
+          yyerror("Time should be a positive integer in milliseconds.");
+          break;
+        }
+
+        move_ms = argument_storage[2].datavalue.integer;
+      }
 
-      #ifdef RPI_SIMULATION
-        res7 = move_servo_to_angle(value, argument_storage[0]);
-      #else
+      if(gpio_backend->simulated) {
         printf("Simulated move_servo_to_angle.\n");
-        res7 = 0; 
-      #endif
+      }
+
+      int res7 = move_servo_to_angle(value, argument_storage[1].datavalue.integer, move_ms);
 
       if(res7 != 0) {
-        yyerror("PI_BAD_DUTYCYCLE.");
+        yyerror("PI_BAD_PULSEWIDTH.");
       }
 
-      result = res7;
       break;
 
     case BUILT_IN_MOVE_SERVO_INFINITELY:
       if(value->type != SERVO_MOTOR) {
-        printf("Type is: %d\n", value->type);
+        trace(TRACE_DEBUG, "Type is: %d\n", value->type);
         yyerror("Operation not permitted.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
@@ -1088,33 +781,25 @@ struct val *builtin_function_call(struct builtin_function_call *builtin_function
 
       if(number_of_arguments != expected_argument_numbers) {
         yyerror("Too many or too few arguments.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
-      struct val *res8 = malloc(sizeof(struct val));
-
-      #ifdef RPI_SIMULATION
-        res8 = move_servo_infinitely(value);
-      #else
+      if(gpio_backend->simulated) {
         printf("Simulated move_servo_infinitely.\n");
-        res8 = 0; 
-      #endif
+      }
+
+      int res8 = move_servo_infinitely(value);
 
       if(res8 != 0) {
-        yyerror("PI_BAD_DUTYCYCLE.");
+        yyerror("PI_BAD_PULSEWIDTH.");
       }
 
-      result = res8;
       break;
 
     case BUILT_IN_SERVO_STOP:
       if(value->type != SERVO_MOTOR) {
-        printf("Type is: %d\n", value->type);
+        trace(TRACE_DEBUG, "Type is: %d\n", value->type);
         yyerror("Operation not permitted.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
@@ -1122,41 +807,211 @@ struct val *builtin_function_call(struct builtin_function_call *builtin_function
 
       if(number_of_arguments > expected_argument_numbers) {
         yyerror("Too many arguments.");
-        free(builtin_function);
-        free(argument_storage);
         break;
       }
 
-      struct val *res9 = malloc(sizeof(struct val));
-
-      #ifdef RPI_SIMULATION
-        res9 = servo_stop(value);
-      #else
+      if(gpio_backend->simulated) {
         printf("Simulated servo_stop.\n");
-        res9 = 0; 
-      #endif
+      }
+
+      int res9 = servo_stop(value);
 
       if(res9 != 0) {
         yyerror("Bad GPIO level.");
       }
 
-      result = res9;
+      break;
+
+    case BUILT_IN_WAIT_FOR_PRESS:
+      if(!value) {
+        yyerror("Too few arguments.");
+        break;
+      }
+
+      if(value->type != BUTTON) {
+        trace(TRACE_DEBUG, "Type is: %d\n", value->type);
+        yyerror("Operation not permitted.");
+        break;
+      }
+
+      expected_argument_numbers = 2;
+
+      if(number_of_arguments > expected_argument_numbers) {
+        yyerror("Too many arguments.");
+        break;
+      }
+
+      // Without a timeout wait until the button is pressed
+      int timeout_ms = -1;
+
+      if(number_of_arguments == expected_argument_numbers) {
+        if(argument_storage[1].type != INTEGER_TYPE) {
+          yyerror("Timeout should be an integer in milliseconds.");
+          break;
+        }
+
+        timeout_ms = argument_storage[1].datavalue.integer;
+      }
+
+      result = wait_for_press(value, timeout_ms);
+      break;
+
+    case BUILT_IN_WRITE_GROUP:
+      if(number_of_arguments < 2) {
+        yyerror("Too few arguments.");
+        break;
+      }
+
+      // The first argument is the level, the rest are the devices to write it to
+      if((value->type != BIT_TYPE && value->type != INTEGER_TYPE) || value->datavalue.integer < 0 || value->datavalue.integer > 1) {
+        yyerror("Level should be 0 or 1.");
+        break;
+      }
+
+      int group_is_valid = 1;
+
+      for(int i = 1; i < number_of_arguments; i++) {
+        if(argument_storage[i].type != LED && argument_storage[i].type != BUZZER) {
+          trace(TRACE_DEBUG, "Type is: %d\n", argument_storage[i].type);
+          group_is_valid = 0;
+        }
+      }
+
+      if(!group_is_valid) {
+        yyerror("Operation not permitted.");
+        break;
+      }
+
+      if(gpio_backend->simulated) {
+        printf("Simulated write_group.\n");
+      }
+
+      if(write_group(value->datavalue.integer, argument_storage + 1, number_of_arguments - 1) != 0) {
+        yyerror("Bad GPIO level.");
+      }
       break;
 
     case BUILT_IN_DELAY:
-      #ifdef RPI_SIMULATION
-        delay_pi();
-      #else
+      expected_argument_numbers = 1;
+
+      if(number_of_arguments > expected_argument_numbers) {
+        yyerror("Too many arguments.");
+        break;
+      }
+
+      // Without an argument delay waits a millisecond
+      int delay = 1000;
+
+      if(value) {
+        if(value->type != INTEGER_TYPE || value->datavalue.integer < 0) {
+          yyerror("Delay should be a positive integer in microseconds.");
+          break;
+        }
+
+        delay = value->datavalue.integer;
+      }
+
+      if(gpio_backend->simulated) {
         printf("Simulated delay.\n");
-      #endif
+      }
+
+      // The simulation backend waits in virtual time
+      delay_us(delay);
+      break;
+
+    case BUILT_IN_DELAY_UNTIL:
+      if(!value || value->type != INTEGER_TYPE) {
+        yyerror("Deadline should be an integer in microseconds.");
+        break;
+      }
+
+      expected_argument_numbers = 1;
+
+      if(number_of_arguments > expected_argument_numbers) {
+        yyerror("Too many arguments.");
+        break;
+      }
+
+      if(gpio_backend->simulated) {
+        printf("Simulated delay_until.\n");
+      }
+
+      // Returns how many microseconds after the deadline the script goes on
+      result = create_integer_value(delay_until_us(value->datavalue.integer));
+      break;
+
+    case BUILT_IN_PLAY_PATTERN:
+      if(number_of_arguments < 4) {
+        yyerror("Too few arguments.");
+        break;
+      }
+
+      if(value->type != LED && value->type != BUZZER) {
+        trace(TRACE_DEBUG, "Type is: %d\n", value->type);
+        yyerror("Operation not permitted.");
+        break;
+      }
 
-      result = NULL;
+      // The device comes first, then the repeats and the times of the list
+      if(argument_storage[1].type != INTEGER_TYPE || argument_storage[1].datavalue.integer < 0 || argument_storage[1].datavalue.integer > MAX_PATTERN_REPEATS) {
+        yyerror("Repeats should be an integer from 0 to %d, 0 repeats forever.", MAX_PATTERN_REPEATS);
+        break;
+      }
+
+      int number_of_times = number_of_arguments - 2;
+
+      if(number_of_times < 2 || number_of_times % 2 || number_of_times > MAX_PATTERN_STEPS) {
+        yyerror("Pattern should be pairs of on and off times, at most %d times.", MAX_PATTERN_STEPS);
+        break;
+      }
+
+      uint32_t times[MAX_PATTERN_STEPS];
+      int times_are_valid = 1;
+
+      for(int i = 0; i < number_of_times; i++) {
+        if(argument_storage[i + 2].type != INTEGER_TYPE || argument_storage[i + 2].datavalue.integer <= 0) {
+          times_are_valid = 0;
+          break;
+        }
+
+        times[i] = argument_storage[i + 2].datavalue.integer;
+      }
+
+      if(!times_are_valid) {
+        yyerror("Times should be positive integers in microseconds.");
+        break;
+      }
+
+      if(gpio_backend->simulated) {
+        printf("Simulated play_pattern.\n");
+      }
+
+      int res10 = play_pattern(value->datavalue.GPIO_PIN[0], times, number_of_times, argument_storage[1].datavalue.integer);
+
+      if(res10 == PATTERN_BUSY) {
+        yyerror("Another script is playing a pattern.");
+      } else if(res10 == PI_BAD_USER_GPIO) {
+        yyerror("Patterns can only be played on gpio 0 to 31.");
+      } else if(res10 != 0) {
+        yyerror("Cannot create the waveform.");
+      }
+      break;
+
+    case BUILT_IN_STOP_PATTERN:
+      if(number_of_arguments > 0) {
+        yyerror("Too many arguments.");
+        break;
+      }
+
+      if(gpio_backend->simulated) {
+        printf("Simulated stop_pattern.\n");
+      }
+
+      stop_pattern();
       break;
     
     default:
-      yyerror("Function does not exist: %d", builtin_function->function_type);
-      free(builtin_function);
-      free(argument_storage);
+      yyerror("Function does not exist: %d", function_type);
       break;
   }
 
@@ -1165,7 +1020,7 @@ struct val *builtin_function_call(struct builtin_function_call *builtin_function
 
 // Function to create a node for user defined function in the AST
 struct ast *new_user_function(char *s, struct ast *argument_list) {
-  struct user_function_call *ast = malloc(sizeof(struct user_function_call));
+  struct user_function_call *ast = new_node(sizeof(struct user_function_call));
   
   if(!ast) {
     yyerror("No space.");
@@ -1175,106 +1030,196 @@ struct ast *new_user_function(char *s, struct ast *argument_list) {
   ast->nodetype = USER_CALL;
   ast->argument_list = argument_list;
   ast->s = s;
+  ast->scope = UNRESOLVED;
+  ast->slot = 0;
 
   return (struct ast *)ast;
 }
 
-// Function to call custom functions
-void calluser(struct user_function_call *user_function) {
-    struct symbol *user_function_call = lookup(user_function->s); /* function name */
-    struct symbol_list *sl; /* dummy arguments */
-    struct ast *args = user_function->argument_list; /* actual arguments */
-    struct val **oldval, **newval; /* saved arg values */
-    int nargs;
-    int i;
-
-    if(!user_function) {
-      yyerror("Call to undefined function", user_function->s);
-      return;
-    }
+// Function to count the dummy arguments of a function
+static int count_parameters(struct symbol_list *symbol_list) {
+  int nargs;
 
-    /* count the arguments */
-    sl = (struct symbol_list *)user_function->argument_list;
-    for(nargs = 0; sl; sl = sl->next)
+  for(nargs = 0; symbol_list; symbol_list = symbol_list->next)
     nargs++;
 
-    /* prepare to save them */
-    oldval = (struct val **)malloc(nargs * sizeof(struct val));
-    newval = (struct val **)malloc(nargs * sizeof(struct val));
+  return nargs;
+}
 
-    if(!oldval || !newval) {
-      yyerror("Out of space in %s", user_function->s);
-    }
+void dodef(char *n, struct symbol_list *symbol_list, struct ast *function) {
+  struct symbol *name = lookup(n);
+  int frame_size = 0;
 
-    /* evaluate the arguments */
-    for(i = 0; i < nargs; i++) {
-      if(!args) {
-        yyerror("Too few args in call to %s", user_function->s);
-        free(oldval); 
-        free(newval);
-        return;
-      }
+  if(name->syms) name->syms = NULL;
+  if(name->nodes) arena_free(name->nodes);
+  if(name->code) {
+    free_program(name->code);
+    name->code = NULL;
+  }
+
+  // Bind the dummy arguments and declared locals to frame slots and everything else to the symbol table
+  frame_size = resolve_function(function, symbol_list);
+  check_types(function);
+  function = fold(function);
+  function = specialize(function);
+  name->syms = symbol_list;
+  name->func = function;
+
+  // The function keeps the nodes of its parse unit, the next unit starts a new arena
+  name->nodes = current_context->parse_arena;
+  current_context->parse_arena = NULL;
+
+  name->code = compile(function);
+  name->code->name = name->name;
+  name->code->parameter_count = count_parameters(symbol_list);
+  name->code->frame_size = frame_size;
+  cache_function(n, name->code);
+}
+
+// Function to append a top-level unit to the script of the current interpreter
+static void add_unit(int kind, char *name, struct symbol_list *parameters, struct ast *ast) {
+  struct interpreter_context *context = current_context;
+
+  if(context->unit_count == context->unit_capacity) {
+    context->unit_capacity = context->unit_capacity ? context->unit_capacity * 2 : 16;
+    context->units = realloc(context->units, context->unit_capacity * sizeof(struct program_unit));
+
+    if(!context->units) {
+      yyerror("out of space");
+      exit(0);
     }
+  }
+
+  struct program_unit *unit = &context->units[context->unit_count++];
+  unit->kind = kind;
+  unit->line = current_line();
+  unit->name = name;
+  unit->parameters = parameters;
+  unit->ast = ast;
+  unit->frame_size = 0;
+  unit->code = NULL;
+}
+
+// Function to run a statement read at the prompt, or keep it for the batch run of a script
+void add_statement(struct ast *statement) {
+  if(!current_context->is_file) {
+    eval(statement);
+    free_parse_unit();
+    return;
+  }
+
+  if(statement) {
+    add_unit(STATEMENT_UNIT, NULL, NULL, statement);
+  }
+}
+
+// Function to define a function read at the prompt, or keep it for the batch run of a script
+void add_function(char *name, struct symbol_list *symbol_list, struct ast *function) {
+  if(!current_context->is_file) {
+    dodef(name, symbol_list, function);
+    return;
+  }
+
+  add_unit(FUNCTION_UNIT, name, symbol_list, function);
+}
+
+// Function to install a compiled function in place of an earlier definition
+static void install_function(char *n, struct program *code) {
+  struct symbol *name = lookup(n);
+
+  if(name->nodes) {
+    arena_free(name->nodes);
+    name->nodes = NULL;
+  }
+
+  free_program(name->code);
+  name->syms = NULL;
+  name->func = NULL;
+  name->code = code;
+  code->name = name->name;
+}
 
-    if(args->nodetype == STATEMENT_LIST) { 
-      /* if this is a list node */
-      newval[i] = eval(args->l);
-      args = args->r;
+// Function to resolve, compile and then run every unit of a script read in batch mode
+void run_units() {
+  struct interpreter_context *context = current_context;
+  struct program_unit *unit = NULL;
+
+  // Every pass sees the whole program before anything runs
+  for(int i = 0; i < context->unit_count; i++) {
+    unit = &context->units[i];
+
+    if(unit->kind == FUNCTION_UNIT) {
+      unit->frame_size = resolve_function(unit->ast, unit->parameters);
     } else {
-      /* if it's the end of the list */
-      newval[i] = eval(args);
-      args = NULL;
+      resolve(unit->ast);
     }
+  }
 
-    /* save old values of dummies, assign new ones */
-    sl = (struct symbol_list *)user_function->argument_list;
-    for(i = 0; i < nargs; i++) {
-      struct symbol *s = lookup(sl->sym);
-      if(s == NULL) {
-        s = lookup(sl->sym);
-      }
+  infer_types();
 
-      oldval[i] = s->value;
-      s->value = newval[i];
-      sl = sl->next;
-    }
+  for(int i = 0; i < context->unit_count; i++) {
+    unit = &context->units[i];
+    context->line = unit->line;
+    context->type_errors += check_types(unit->ast);
+  }
 
-    /* evaluate the function */
-    eval(user_function_call->func);
+  for(int i = 0; i < context->unit_count && !context->type_errors; i++) {
+    unit = &context->units[i];
+    unit->ast = fold(unit->ast);
+    unit->ast = specialize(unit->ast);
+  }
 
-    /* put the dummies back */
-    sl = user_function_call->syms;
-    for(i = 0; i < nargs; i++) {
-      struct symbol *s = lookup(sl->sym);
+  for(int i = 0; i < context->unit_count && !context->type_errors; i++) {
+    unit = &context->units[i];
+    context->line = unit->line;
+    unit->code = compile(unit->ast);
 
-      s->value = oldval[i];
-      sl = sl->next;
+    if(unit->kind == FUNCTION_UNIT) {
+      unit->code->parameter_count = count_parameters(unit->parameters);
+      unit->code->frame_size = unit->frame_size;
+      cache_function(unit->name, unit->code);
+    } else {
+      cache_statement(unit->code);
     }
+  }
 
-    free(newval);
-    free(oldval);
-}
+  // The compiled units no longer need the syntax tree
+  if(context->parse_arena) {
+    arena_free(context->parse_arena);
+    context->parse_arena = NULL;
+  }
 
-void dodef(char *n, struct symbol_list *symbol_list, struct ast *function) {
-  struct symbol *name = (struct symbol *) n;
-  if(name->syms) name->syms = NULL;
-  if(name->func) treefree(name->func);
-  name->syms = symbol_list;
-  name->func = function;
+  // Definitions take effect in script order, so a statement calls the definition read before it
+  for(int i = 0; i < context->unit_count && !context->type_errors; i++) {
+    unit = &context->units[i];
+    context->line = unit->line;
+
+    if(unit->kind == FUNCTION_UNIT) {
+      install_function(unit->name, unit->code);
+    } else {
+      run_program(unit->code);
+      free_program(unit->code);
+    }
+  }
+
+  free(context->units);
+  context->units = NULL;
+  context->unit_count = 0;
+  context->unit_capacity = 0;
 }
 
-// Function to create a new file
+// Function to open a file and start a scanner reading it in the current interpreter
 int newfile(char *fn) {
   FILE *f;
 
   if(strcmp(fn, "stdin")) {
     // Found files
     f = fopen(fn, "r");
-		is_file = 1;
+		current_context->is_file = 1;
   } else {
     // Use standard input
     f = stdin;
-		is_file = 0;
+		current_context->is_file = 0;
   }
 
   if(!f) {
@@ -1282,11 +1227,30 @@ int newfile(char *fn) {
     return -1;
   }
 
-  yyin = f;
+  if(yylex_init(&current_context->scanner)) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  yyset_in(f, current_context->scanner);
 
   return 1;
 }
 
+// Function to stop the scanner of the current interpreter and close its file
+void closefile() {
+  FILE *f = yyget_in(current_context->scanner);
+
+  // Errors after parsing report the last line that was read
+  current_context->line = yyget_lineno(current_context->scanner);
+  yylex_destroy(current_context->scanner);
+  current_context->scanner = NULL;
+
+  if(f != stdin) {
+    fclose(f);
+  }
+}
+
 // Function to check passed in file suffix
 int checkSuffix(const char *str, const char *suffix) {
     if (!str || !suffix)
@@ -1298,31 +1262,231 @@ int checkSuffix(const char *str, const char *suffix) {
     return strncmp(str + lenstr - lensuffix, suffix, lensuffix) == 0;
 }
 
+// The benchmark driver in bench.c brings its own main
+#ifndef LEARNPI_BENCH
+// Function to print the options the interpreter takes
+static void print_usage(const char *program) {
+  fprintf(stderr, "Usage: %s [options] [script.learnpi ...]\n", program);
+  fprintf(stderr, "  --no-cache           parse the scripts instead of mapping their compiled images\n");
+  fprintf(stderr, "  --trace[=LEVEL]      print the trace, level 1 without a level and 2 for the internals\n");
+  fprintf(stderr, "  --mem-stats          print the memory use of each script\n");
+  fprintf(stderr, "  --timing             print the missed deadlines and the latencies of the delays\n");
+  fprintf(stderr, "  --profile            print the slowest lines and write them to a .folded file\n");
+  fprintf(stderr, "  --realtime[=PRIO]    lock the memory and run the scripts with SCHED_FIFO\n");
+  fprintf(stderr, "  --cpu=N              run on cpu N in realtime mode\n");
+  fprintf(stderr, "  --backend=NAME       drive the pins with pigpio, sim, record or record:pigpio\n");
+  fprintf(stderr, "  --record-file=PATH   file the record backend writes\n");
+  fprintf(stderr, "  --keypad-rate=HZ     scans of the keypads per second\n");
+}
+
+// Function to read the command line options, returns the number of script files
+static int parse_options(int argc, char **argv) {
+  int number_of_files = 0;
+
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "--no-cache")) {
+      cache_disabled = 1;
+    } else if(!strcmp(argv[i], "--trace")) {
+      trace_level = TRACE_INFO;
+    } else if(!strncmp(argv[i], "--trace=", 8)) {
+      char *end = NULL;
+      long level = strtol(argv[i] + 8, &end, 10);
+
+      if(end == argv[i] + 8 || *end || level < TRACE_NONE || level > TRACE_DEBUG) {
+        fprintf(stderr, "Trace level should be a number from %d to %d, not %s.\n", TRACE_NONE, TRACE_DEBUG, argv[i] + 8);
+        exit(1);
+      }
+
+      trace_level = level;
+    } else if(!strcmp(argv[i], "--mem-stats")) {
+      memory_stats = 1;
+    } else if(!strcmp(argv[i], "--timing")) {
+      timing_stats = 1;
+    } else if(!strcmp(argv[i], "--profile")) {
+      // Profiled programs are compiled with line markers, a cached image has none
+      profile_enabled = 1;
+      cache_disabled = 1;
+    } else if(!strcmp(argv[i], "--realtime")) {
+      realtime_enabled = 1;
+    } else if(!strncmp(argv[i], "--realtime=", 11)) {
+      realtime_enabled = 1;
+      realtime_priority = atoi(argv[i] + 11);
+    } else if(!strncmp(argv[i], "--cpu=", 6)) {
+      realtime_cpu = atoi(argv[i] + 6);
+    } else if(!strncmp(argv[i], "--backend=", 10)) {
+      if(select_backend(argv[i] + 10) != 0) {
+#ifndef LEARNPI_PIGPIO
+        if(strstr(argv[i] + 10, "pigpio")) {
+          fprintf(stderr, "The pigpio backend is not compiled in, build with make PIGPIO=1.\n");
+          exit(1);
+        }
+#endif
+        fprintf(stderr, "No backend %s, use pigpio, sim, record or record:pigpio.\n", argv[i] + 10);
+        exit(1);
+      }
+    } else if(!strncmp(argv[i], "--record-file=", 14)) {
+      record_path = argv[i] + 14;
+    } else if(!strncmp(argv[i], "--keypad-rate=", 14)) {
+      keypad_rate_hz = atoi(argv[i] + 14);
+
+      if(keypad_rate_hz < 1) {
+        fprintf(stderr, "Keypad rate should be a positive number of scans per second.\n");
+        keypad_rate_hz = KEYPAD_DEFAULT_RATE_HZ;
+      }
+    } else if(argv[i][0] == '-') {
+      // Scripts end in .learnpi, an argument that starts with a dash is a mistyped option
+      fprintf(stderr, "Unknown option %s.\n", argv[i]);
+      print_usage(argv[0]);
+      exit(1);
+    } else {
+      number_of_files++;
+    }
+  }
+
+  if(trace_level > LEARNPI_TRACE_LEVEL) {
+    fprintf(stderr, "Trace level %d is not compiled in, build with -DLEARNPI_TRACE_LEVEL=%d.\n", trace_level, trace_level);
+  }
+
+  return number_of_files;
+}
+
+// Function to run a script in an interpreter of its own, the start routine of script threads
+static void *run_script(void *argument) {
+  char *path = argument;
+
+  if(realtime_enabled) {
+    prefault_stack();
+  }
+
+  current_context = create_interpreter_context();
+
+  if(profile_enabled) {
+    start_profile(path);
+  }
+
+  if(run_cached_script(path)) {
+    flush_gpio_writes();
+  } else if(newfile(path) > 0) {
+    // Record the compiled script so the next run can skip lexing and parsing
+    begin_script_cache(path);
+    yyparse(current_context->scanner);
+    closefile();
+
+    // The whole script is read before any of it runs
+    run_units();
+    end_script_cache(current_context->syntax_errors == 0 && current_context->type_errors == 0);
+    flush_gpio_writes();
+  }
+
+  // A pattern that repeats a number of times and the moves of servos play to their end before the script does
+  finish_pattern();
+  finish_servo_moves();
+
+  if(memory_stats) {
+    print_memory_stats();
+  }
+
+  if(timing_stats) {
+    print_timing_stats();
+  }
+
+  finish_profile();
+  free_interpreter_context(current_context);
+  current_context = NULL;
+
+  return NULL;
+}
+
 int main(int argc, char **argv) {
+  int number_of_files = parse_options(argc, argv);
+  pthread_t *threads = NULL;
+  pthread_attr_t attributes;
+  int number_of_threads = 0;
+
+  if(gpio_backend->init() != 0) {
+    fprintf(stderr, "Cannot start the %s backend.\n", gpio_backend->name);
+    return 1;
+  }
 
-  #ifdef RPI_SIMULATION
-    if (gpioInitialise()<0) return 1;
-    printf("Executing on PI.\n");
-  #else
+  if(gpio_backend->simulated) {
     printf("Executing locally.\n");
-  #endif
+  } else {
+    printf("Executing on PI.\n");
+  }
 
   printf("Learnpi...\n");
-	newfile("stdin");
 
-  if(argc == 1) {
-      printf("%s", "Learnpi~€: ");
-      yyparse();
+  // After the backend starts, so the memory pigpio maps is locked as well
+  if(realtime_enabled) {
+    enter_realtime(number_of_files);
+  }
+
+  if(number_of_files == 0) {
+    current_context = create_interpreter_context();
+
+    if(profile_enabled) {
+      start_profile("learnpi");
+    }
+
+    newfile("stdin");
+    printf("%s", "Learnpi~€: ");
+    yyparse(current_context->scanner);
+    closefile();
+
+    finish_pattern();
+    finish_servo_moves();
+
+    if(memory_stats) {
+      print_memory_stats();
+    }
+
+    if(timing_stats) {
+      print_timing_stats();
+    }
+
+    finish_profile();
+    free_interpreter_context(current_context);
   } else {
+    // Several scripts run in parallel, each on its own thread with its own interpreter
+    threads = malloc(number_of_files * sizeof(pthread_t));
+
+    if(!threads) {
+      yyerror("out of space");
+      exit(0);
+    }
+
+    pthread_attr_init(&attributes);
+
+    if(realtime_enabled) {
+      realtime_thread_attributes(&attributes);
+    }
+
     for(int i = 1; i < argc; i++) {
-      if(checkSuffix(argv[1], ".learnpi") == 1 && newfile(argv[1])) {
-        yyparse();
-      } else {
+      if(argv[i][0] == '-') {
+        continue;
+      }
+
+      if(checkSuffix(argv[i], ".learnpi") != 1) {
         fprintf(stderr, "Not a valid file.\n");
+      } else if(number_of_files == 1) {
+        run_script(argv[i]);
+      } else if(pthread_create(&threads[number_of_threads], &attributes, run_script, argv[i]) == 0) {
+        number_of_threads++;
+      } else {
+        fprintf(stderr, "Cannot start a thread for %s.\n", argv[i]);
       }
     }
+
+    for(int i = 0; i < number_of_threads; i++) {
+      pthread_join(threads[i], NULL);
+    }
+
+    pthread_attr_destroy(&attributes);
+    free(threads);
   }
 
+  gpio_backend->terminate();
   printf("Thanks for using learnpi.\n");
   return 0;
 }
+#endif
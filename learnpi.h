@@ -2,9 +2,16 @@
 #define LEARNPI_H
 
 #define NHASH 9997
-// #define RPI_SIMULATION 1
 #include <stdbool.h>
+#include <stdint.h>
 #include "types.h"
+#include "events.h"
+#include "string_table.h"
+#include "heap.h"
+#include "timing.h"
+#include "wave.h"
+#include "servo.h"
+#include "keypad.h"
 
 // Expression types
 enum expression_type {
@@ -22,23 +29,28 @@ enum expression_type {
   DECLARATION,
   DECLARATION_WITH_ASSIGNMENT,
   BUILTIN_TYPE,
-  USER_CALL
+  USER_CALL,
+  TYPED_OPERATION,
+  TO_DECIMAL
 };
 
-// Structure for a variable symbol
-struct symbol {
-  char *name;
-  struct val *value;
-  struct ast *func;
-  struct symbol_list *syms;
+// Scope of a variable slot bound by the resolver
+enum slot_scope {
+  UNRESOLVED = 0,
+  GLOBAL_SLOT,
+  LOCAL_SLOT
 };
 
-// Symbol table variable
-struct symbol symtab[NHASH];
+// Compiled bytecode program, see bytecode.h
+struct program;
+
+// Arena of AST nodes, see arena.h
+struct arena;
 
-// Structure for value
+// Structure for value, passed by value; only strings and device pins live on the heap
 struct val {
     int type;
+    unsigned length;    // characters of a string, which are not terminated once a longer string shares them
     union datavalue {
         int bit;
         int integer;
@@ -48,15 +60,107 @@ struct val {
     } datavalue;
 };
 
+// Structure for a variable symbol
+struct symbol {
+  char *name;
+  struct val value;
+  struct ast *func;
+  struct symbol_list *syms;
+  struct program *code;
+  struct arena *nodes;
+  int inferred_type;       // type every read of the global sees in a script, NO_TYPE if it is not known
+};
+
+// Kinds of top-level units of a script
+enum unit_kind {
+  STATEMENT_UNIT = 1,
+  FUNCTION_UNIT
+};
+
+// Structure for a top-level statement or function definition of a script read in batch mode
+struct program_unit {
+  int kind;
+  int line;                        // line errors of the unit report
+  char *name;                      // name of a function definition
+  struct symbol_list *parameters;
+  struct ast *ast;
+  int frame_size;                  // frame slots of a function definition
+  struct program *code;
+};
+
+// Recording of a compiled image, see cache.h
+struct image_recording;
+
+// Saved caller of a running function, see bytecode.h
+struct call_frame;
+
+// Time spent on each line of a script run with --profile, see profile.h
+struct profile;
+
+// Structure for the devices declared by one interpreter
+struct device_registry {
+  uint64_t claimed_pins;     // pins this interpreter declared devices on
+  uint32_t pending_set[2];   // queued output writes of bank 1 and bank 2, see gpio_batch.h
+  uint32_t pending_clear[2];
+};
+
+// Structure for the virtual time of the simulation backend, delays and waits advance it instantly
+struct virtual_clock {
+  uint64_t now_us;
+  uint64_t edge_us[MAX_GPIO][2];   // last simulated edge to level 0 and 1 a wait took
+};
+
+// Structure for the state of one interpreter, every script runs in its own
+struct interpreter_context {
+  struct symbol symtab[NHASH];
+  void *scanner;                       // reentrant scanner of the script being parsed
+  struct arena *parse_arena;           // nodes of the parse unit being read
+  struct program_unit *units;          // units of a script, run once it is read
+  int unit_count;
+  int unit_capacity;
+  int is_file;
+  int syntax_errors;                   // syntax errors in the script being parsed
+  int type_errors;                     // errors found in the script before it runs
+  int line;                            // line reported by errors while no scanner runs
+  int token_line;                      // line of the token the scanner read last, new nodes take it
+  struct image_recording *recording;   // NULL when no image is recorded
+  struct device_registry devices;
+  struct virtual_clock clock;
+  struct script_timing timing;         // clock of delay_until and how well the script kept its deadlines
+  struct pattern_playback pattern;     // pattern play_pattern started, see wave.h
+  struct string_table strings;         // interned constants
+  struct heap heap;                    // strings and device pins of the values
+  struct val *value_stack;             // frames and operands of the running programs, see bytecode.h
+  struct val *stack_top;               // end of the values in use, kept up to date at safe points
+  struct call_frame *call_stack;       // callers of the running functions
+  struct profile *profile;             // NULL unless the script runs with --profile
+};
+
+// Interpreter of the calling thread
+extern _Thread_local struct interpreter_context *current_context;
+
+// Function to create an interpreter with an empty symbol table
+struct interpreter_context *create_interpreter_context();
+
+// Function to free an interpreter and release the pins of its devices
+void free_interpreter_context(struct interpreter_context *context);
+
+// Function to claim a pin for a device of the current interpreter, returns 0 if another script uses it
+int claim_pin(unsigned pin);
+
+// Function to get the line errors of the current interpreter report
+int current_line();
+
 // Structure for symbol list
 struct symbol_list {
   char *sym;
   struct symbol_list *next;
 };
 
-// Structure for Abstract Syntax Tree
+// Structure for Abstract Syntax Tree, every node starts with its type and line
 struct ast {
   int nodetype;
+  int line;            // source line the node was read from, 0 for nodes made after parsing
   struct ast *l;
   struct ast *r;
 };
@@ -64,13 +168,18 @@ struct ast {
 // Symbol assignment structure
 struct assign_symbol {
   int nodetype;
+  int line;
   char *s;
   struct ast *v;
+  int scope;
+  int slot;
+  int declared;    // written as TYPE NAME = value, a declaration inside a function gets a frame slot
 };
 
 // Structure for flow control
 struct flow {
   int nodetype;
+  int line;
   struct ast *condition;
   struct ast *then_list;
   struct ast *else_list;
@@ -79,6 +188,7 @@ struct flow {
 // Structure for for_flow control
 struct for_flow {
   int nodetype;
+  int line;
   struct ast *initialization;
   struct ast *condition;
   struct ast *then_list;
@@ -88,48 +198,76 @@ struct for_flow {
 // Structure for symbol reference
 struct symbol_reference {
   int nodetype;
+  int line;
   char *s;
+  int scope;
+  int slot;
 };
 
 // Structure for symbol assignment
 struct symasgn {
   int nodetype;
+  int line;
   char *s;
   struct ast *v;
+  int scope;
+  int slot;
+  int declared;    // written as TYPE NAME = value, a declaration inside a function gets a frame slot
 };
 
 // Structure for variable declaration
 struct declare_symbol {
   int nodetype;
+  int line;
   int type;
   char *s;
+  int scope;
+  int slot;
 };
 
 // Structure for variable declaration with assignment
 struct assign_and_declare_symbol {
   int nodetype;
+  int line;
   int type;
   char *s;
   struct ast *value;
+  int scope;
+  int slot;
 };
 
 // Structure for variable declaration with assignment
 struct assign_and_declare_complex_symbol {
   int nodetype;
+  int line;
   int type;
   char *s;
   struct ast *value;
+  int scope;
+  int slot;
+};
+
+// Structure for arithmetic or a comparison on two numbers of the same type
+struct typed_operation {
+  int nodetype;
+  int line;
+  struct ast *l;
+  struct ast *r;
+  int operation;       // '+', '-', '*', '/' or a comparison
+  int operand_type;    // INTEGER_TYPE or DECIMAL_TYPE
 };
 
 // Structure for constant values
 struct constant_value {
   int nodetype;
-  struct val *v;
+  int line;
+  struct val v;
 };
 
 // Structure for builtin function call
 struct builtin_function_call {
   int nodetype;
+  int line;
   struct ast *argument_list;
   enum built_in_function_types function_type;
   char *s;
@@ -138,8 +276,11 @@ struct builtin_function_call {
 // Structure for user function call
 struct user_function_call {
   int nodetype;
+  int line;
   struct ast *argument_list;
   char *s;
+  int scope;
+  int slot;
 };
 
 // Lookup function
@@ -151,6 +292,9 @@ struct ast *new_declaration(char *s, int type);
 // Function for new variable asignment
 struct ast * new_assignment(char *s, struct ast *v);
 
+// Function for new variable assignment written as a declaration, TYPE NAME = value
+struct ast *new_declared_assignment(char *s, struct ast *v);
+
 // Function to create a new control flow
 struct ast *newflow(int nodetype, struct ast *cond, struct ast *tl, struct ast *tr);
 
@@ -173,7 +317,10 @@ struct ast *new_reference(char *s);
 struct ast *new_comparison(int type, struct ast *l, struct ast *r);
 
 // Function to create a new value
-struct ast *new_value(struct val *value);
+struct ast *new_value(struct val value);
+
+// Function to create an operation on two numbers of a known type
+struct ast *new_typed_operation(int operation, int operand_type, struct ast *l, struct ast *r);
 
 // Symbol table stack reference to use in main function
 struct symtable_stack *symstack;
@@ -193,11 +340,29 @@ struct symbol_list *create_symbol_list(char *symbol, struct symbol_list *next);
 // Function to create a new control flow
 struct ast *newflow(int nodetype, struct ast *cond, struct ast *tl, struct ast *tr);
 
-// Function to evaluate an AST
-struct val *eval(struct ast *);
+// Function to evaluate an AST by compiling it to bytecode and running it
+struct val eval(struct ast *);
+
+// Function to free every node of the parse unit that was just evaluated
+void free_parse_unit();
 
-// Function to free an AST
-void treefree(struct ast *);
+// Function to run a statement read at the prompt, or keep it for the batch run of a script
+void add_statement(struct ast *statement);
+
+// Function to define a function read at the prompt, or keep it for the batch run of a script
+void add_function(char *name, struct symbol_list *symbol_list, struct ast *function);
+
+// Function to resolve, compile and then run every unit of a script read in batch mode
+void run_units();
+
+// Function to open a file and start a scanner reading it in the current interpreter
+int newfile(char *fn);
+
+// Function to stop the scanner of the current interpreter and close its file
+void closefile();
+
+// Function to check passed in file suffix
+int checkSuffix(const char *str, const char *suffix);
 
 // Function to initialize symbol table stack
 void initialize_symbol_table_stack();
@@ -209,16 +374,37 @@ void free_symbol_table_stack();
 bool is_primitive(int type);
 
 // Helper method to check value type
-int get_value_type(struct val *v);
+int get_value_type(struct val v);
 
 // Function to create a node for built in function in the AST
 struct ast *new_builtin_function(int function_type, char *s, struct ast *l);
 
-// Function to call built in functions
-struct val *builtin_function_call(struct builtin_function_call *builtin_function);
+// Function to create a node for a built in function that takes a list of times, they are passed after the other arguments
+struct ast *new_pattern_function(int function_type, struct ast *device, struct ast *times, struct ast *repeats);
+
+// Function to call built in functions with their evaluated arguments
+struct val builtin_function_call(int function_type, struct val *argument_storage, int number_of_arguments);
+
+// Function to bind the variables of a top-level statement to symbol table slots
+void resolve(struct ast *abstract_syntax_tree);
+
+// Function to bind the parameters and declared locals of a function body to frame slots, returns the frame size
+int resolve_function(struct ast *body, struct symbol_list *parameters);
+
+// Function to find the type a node always evaluates to without an error, NO_TYPE if it is not known
+int static_type(struct ast *abstract_syntax_tree);
+
+// Function to infer the type of the globals of a script read in batch mode
+void infer_types();
+
+// Function to count the operations of an AST that always report an error when they run
+int check_types(struct ast *abstract_syntax_tree);
+
+// Function to replace the arithmetic and comparisons on numbers with operations that skip the type checks
+struct ast *specialize(struct ast *abstract_syntax_tree);
 
-// Function to call custom functions
-void calluser(struct user_function_call *user_function);
+// Function to fold the constant subtrees of an AST, returns the node to use in its place
+struct ast *fold(struct ast *abstract_syntax_tree);
 
 void dodef(char *n, struct symbol_list *symbol_list, struct ast *function);
 
@@ -1,8 +1,8 @@
-/* A Bison parser, made by GNU Bison 3.5.1.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison implementation for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2020 Free Software Foundation,
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
    Inc.
 
    This program is free software: you can redistribute it and/or modify
@@ -16,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -34,6 +34,10 @@
 /* C LALR(1) parser skeleton written by Richard Stallman, by
    simplifying the original so-called "semantic" parser.  */
 
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
 /* All symbols defined below should begin with yy or YY, to avoid
    infringing on user name space.  This should be done even for local
    variables, as they might otherwise be expanded by user macros.
@@ -41,20 +45,17 @@
    define necessary library symbols; they are noted "INFRINGES ON
    USER NAME SPACE" below.  */
 
-/* Undocumented macros, especially those whose name start with YY_,
-   are private implementation details.  Do not rely on them.  */
-
-/* Identify Bison output.  */
-#define YYBISON 1
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
 
-/* Bison version.  */
-#define YYBISON_VERSION "3.5.1"
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
 
 /* Skeleton name.  */
 #define YYSKELETON_NAME "yacc.c"
 
 /* Pure parsers.  */
-#define YYPURE 0
+#define YYPURE 2
 
 /* Push parsers.  */
 #define YYPUSH 0
@@ -75,9 +76,10 @@
 
 #define YYDEBUG 1
 
-int yylex();   
+// The pure parser hands its scanner to yyerror, report through the interpreter's yyerror
+#define yyerror(scanner, message) yyerror("%s", message)
 
-#line 81 "parser.tab.c"
+#line 83 "parser.tab.c"
 
 # ifndef YY_CAST
 #  ifdef __cplusplus
@@ -100,79 +102,64 @@ int yylex();
 #  endif
 # endif
 
-/* Enabling verbose error messages.  */
-#ifdef YYERROR_VERBOSE
-# undef YYERROR_VERBOSE
-# define YYERROR_VERBOSE 1
-#else
-# define YYERROR_VERBOSE 0
-#endif
-
-/* Use api.header.include to #include this header
-   instead of duplicating it here.  */
-#ifndef YY_YY_PARSER_TAB_H_INCLUDED
-# define YY_YY_PARSER_TAB_H_INCLUDED
-/* Debug traces.  */
-#ifndef YYDEBUG
-# define YYDEBUG 0
-#endif
-#if YYDEBUG
-extern int yydebug;
-#endif
-
-/* Token type.  */
-#ifndef YYTOKENTYPE
-# define YYTOKENTYPE
-  enum yytokentype
-  {
-    TYPE = 258,
-    COMPLEX_TYPE = 259,
-    NAME = 260,
-    VALUE = 261,
-    BUILT_IN_FUNCTION = 262,
-    IF = 263,
-    ELSE = 264,
-    EOL = 265,
-    WHILE = 266,
-    FOR = 267,
-    FUN = 268,
-    OR_OPERATION = 269,
-    AND_OPERATION = 270,
-    NOT_OPERATION = 271,
-    CMP = 272,
-    UMINUS = 273
-  };
-#endif
-
-/* Value type.  */
-#if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
-union YYSTYPE
+#include "parser.tab.h"
+/* Symbol kind.  */
+enum yysymbol_kind_t
 {
-#line 12 "parser.y"
-
-  struct ast *ast;
-  struct symbol_list *symbol_list;
-  struct val *value;
-  int function_id;
-  char *str;
-  int type;
-
-#line 161 "parser.tab.c"
-
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_TYPE = 3,                       /* TYPE  */
+  YYSYMBOL_COMPLEX_TYPE = 4,               /* COMPLEX_TYPE  */
+  YYSYMBOL_NAME = 5,                       /* NAME  */
+  YYSYMBOL_VALUE = 6,                      /* VALUE  */
+  YYSYMBOL_BUILT_IN_FUNCTION = 7,          /* BUILT_IN_FUNCTION  */
+  YYSYMBOL_IF = 8,                         /* IF  */
+  YYSYMBOL_ELSE = 9,                       /* ELSE  */
+  YYSYMBOL_EOL = 10,                       /* EOL  */
+  YYSYMBOL_WHILE = 11,                     /* WHILE  */
+  YYSYMBOL_FOR = 12,                       /* FOR  */
+  YYSYMBOL_FUN = 13,                       /* FUN  */
+  YYSYMBOL_OR_OPERATION = 14,              /* OR_OPERATION  */
+  YYSYMBOL_AND_OPERATION = 15,             /* AND_OPERATION  */
+  YYSYMBOL_NOT_OPERATION = 16,             /* NOT_OPERATION  */
+  YYSYMBOL_CMP = 17,                       /* CMP  */
+  YYSYMBOL_18_ = 18,                       /* '='  */
+  YYSYMBOL_19_ = 19,                       /* '+'  */
+  YYSYMBOL_20_ = 20,                       /* '-'  */
+  YYSYMBOL_21_ = 21,                       /* '*'  */
+  YYSYMBOL_22_ = 22,                       /* '/'  */
+  YYSYMBOL_23_ = 23,                       /* '|'  */
+  YYSYMBOL_UMINUS = 24,                    /* UMINUS  */
+  YYSYMBOL_25_ = 25,                       /* '('  */
+  YYSYMBOL_26_ = 26,                       /* ')'  */
+  YYSYMBOL_27_ = 27,                       /* '{'  */
+  YYSYMBOL_28_ = 28,                       /* '}'  */
+  YYSYMBOL_29_ = 29,                       /* ';'  */
+  YYSYMBOL_30_ = 30,                       /* ','  */
+  YYSYMBOL_31_ = 31,                       /* '['  */
+  YYSYMBOL_32_ = 32,                       /* ']'  */
+  YYSYMBOL_YYACCEPT = 33,                  /* $accept  */
+  YYSYMBOL_learnpi = 34,                   /* learnpi  */
+  YYSYMBOL_statement = 35,                 /* statement  */
+  YYSYMBOL_control_flow = 36,              /* control_flow  */
+  YYSYMBOL_loop_flow = 37,                 /* loop_flow  */
+  YYSYMBOL_exp = 38,                       /* exp  */
+  YYSYMBOL_list = 39,                      /* list  */
+  YYSYMBOL_explist = 40,                   /* explist  */
+  YYSYMBOL_sym_list = 41                   /* sym_list  */
 };
-typedef union YYSTYPE YYSTYPE;
-# define YYSTYPE_IS_TRIVIAL 1
-# define YYSTYPE_IS_DECLARED 1
-#endif
-
+typedef enum yysymbol_kind_t yysymbol_kind_t;
 
-extern YYSTYPE yylval;
 
-int yyparse (void);
 
-#endif /* !YY_YY_PARSER_TAB_H_INCLUDED  */
+/* Unqualified %code blocks.  */
+#line 22 "parser.y"
 
+int yylex(YYSTYPE *yylval, yyscan_t scanner);
 
+#line 163 "parser.tab.c"
 
 #ifdef short
 # undef short
@@ -211,6 +198,18 @@ typedef int_least16_t yytype_int16;
 typedef short yytype_int16;
 #endif
 
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
+#endif
+
 #if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
 typedef __UINT_LEAST8_TYPE__ yytype_uint8;
 #elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
@@ -270,6 +269,7 @@ typedef int yytype_uint16;
 
 #define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
 
+
 /* Stored state numbers (used for stacks). */
 typedef yytype_uint8 yy_state_t;
 
@@ -288,6 +288,7 @@ typedef int yy_state_fast_t;
 # endif
 #endif
 
+
 #ifndef YY_ATTRIBUTE_PURE
 # if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
 #  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
@@ -306,17 +307,23 @@ typedef int yy_state_fast_t;
 
 /* Suppress unused-variable warnings by "using" E.  */
 #if ! defined lint || defined __GNUC__
-# define YYUSE(E) ((void) (E))
+# define YY_USE(E) ((void) (E))
 #else
-# define YYUSE(E) /* empty */
+# define YY_USE(E) /* empty */
 #endif
 
-#if defined __GNUC__ && ! defined __ICC && 407 <= __GNUC__ * 100 + __GNUC_MINOR__
 /* Suppress an incorrect diagnostic about yylval being uninitialized.  */
-# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                            \
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
     _Pragma ("GCC diagnostic push")                                     \
     _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
     _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+# endif
 # define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
     _Pragma ("GCC diagnostic pop")
 #else
@@ -345,7 +352,7 @@ typedef int yy_state_fast_t;
 
 #define YY_ASSERT(E) ((void) (0 && (E)))
 
-#if ! defined yyoverflow || YYERROR_VERBOSE
+#if !defined yyoverflow
 
 /* The parser invokes alloca or malloc; define the necessary symbols.  */
 
@@ -410,8 +417,7 @@ void free (void *); /* INFRINGES ON USER NAME SPACE */
 #   endif
 #  endif
 # endif
-#endif /* ! defined yyoverflow || YYERROR_VERBOSE */
-
+#endif /* !defined yyoverflow */
 
 #if (! defined yyoverflow \
      && (! defined __cplusplus \
@@ -476,25 +482,27 @@ union yyalloc
 /* YYFINAL -- State number of the termination state.  */
 #define YYFINAL  2
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   375
+#define YYLAST   402
 
 /* YYNTOKENS -- Number of terminals.  */
-#define YYNTOKENS  31
+#define YYNTOKENS  33
 /* YYNNTS -- Number of nonterminals.  */
 #define YYNNTS  9
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  62
+#define YYNRULES  63
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  232
+#define YYNSTATES  240
 
-#define YYUNDEFTOK  2
+/* YYMAXUTOK -- Last valid token kind.  */
 #define YYMAXUTOK   273
 
 
 /* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
    as returned by yylex, with out-of-bounds checking.  */
-#define YYTRANSLATE(YYX)                                                \
-  (0 <= (YYX) && (YYX) <= YYMAXUTOK ? yytranslate[YYX] : YYUNDEFTOK)
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
 
 /* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
    as returned by yylex.  */
@@ -509,7 +517,7 @@ static const yytype_int8 yytranslate[] =
        2,    18,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,    31,     2,    32,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,    27,    23,    28,     2,     2,     2,     2,
@@ -531,46 +539,47 @@ static const yytype_int8 yytranslate[] =
 };
 
 #if YYDEBUG
-  /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
-static const yytype_int8 yyrline[] =
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+static const yytype_uint8 yyrline[] =
 {
-       0,    42,    42,    43,    49,    50,    51,    54,    55,    56,
-      57,    58,    59,    60,    61,    64,    65,    66,    67,    68,
-      69,    70,    71,    72,    73,    74,    75,    76,    77,    78,
-      79,    80,    81,    82,    85,    86,    87,    88,    89,    90,
-      93,    94,    95,    96,    97,    98,    99,   100,   101,   102,
-     103,   104,   105,   106,   107,   108,   109,   112,   113,   122,
-     123,   126,   127
+       0,    59,    59,    60,    61,    62,    63,    66,    67,    68,
+      69,    70,    71,    72,    73,    76,    77,    78,    79,    80,
+      81,    82,    83,    84,    85,    86,    87,    88,    89,    90,
+      91,    92,    93,    94,    97,    98,    99,   100,   101,   102,
+     105,   106,   107,   108,   109,   110,   111,   112,   113,   114,
+     115,   116,   117,   118,   119,   120,   121,   122,   125,   126,
+     135,   136,   139,   140
 };
 #endif
 
-#if YYDEBUG || YYERROR_VERBOSE || 0
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if YYDEBUG || 0
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
 /* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
    First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
 static const char *const yytname[] =
 {
-  "$end", "error", "$undefined", "TYPE", "COMPLEX_TYPE", "NAME", "VALUE",
-  "BUILT_IN_FUNCTION", "IF", "ELSE", "EOL", "WHILE", "FOR", "FUN",
-  "OR_OPERATION", "AND_OPERATION", "NOT_OPERATION", "CMP", "'='", "'+'",
-  "'-'", "'*'", "'/'", "'|'", "UMINUS", "'('", "')'", "'{'", "'}'", "';'",
-  "','", "$accept", "learnpi", "statement", "control_flow", "loop_flow",
-  "exp", "list", "explist", "sym_list", YY_NULLPTR
+  "\"end of file\"", "error", "\"invalid token\"", "TYPE", "COMPLEX_TYPE",
+  "NAME", "VALUE", "BUILT_IN_FUNCTION", "IF", "ELSE", "EOL", "WHILE",
+  "FOR", "FUN", "OR_OPERATION", "AND_OPERATION", "NOT_OPERATION", "CMP",
+  "'='", "'+'", "'-'", "'*'", "'/'", "'|'", "UMINUS", "'('", "')'", "'{'",
+  "'}'", "';'", "','", "'['", "']'", "$accept", "learnpi", "statement",
+  "control_flow", "loop_flow", "exp", "list", "explist", "sym_list", YY_NULLPTR
 };
-#endif
 
-# ifdef YYPRINT
-/* YYTOKNUM[NUM] -- (External) token number corresponding to the
-   (internal) symbol number NUM (which must be that of a token).  */
-static const yytype_int16 yytoknum[] =
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
 {
-       0,   256,   257,   258,   259,   260,   261,   262,   263,   264,
-     265,   266,   267,   268,   269,   270,   271,   272,    61,    43,
-      45,    42,    47,   124,   273,    40,    41,   123,   125,    59,
-      44
-};
-# endif
+  return yytname[yysymbol];
+}
+#endif
 
-#define YYPACT_NINF (-92)
+#define YYPACT_NINF (-95)
 
 #define yypact_value_is_default(Yyn) \
   ((Yyn) == YYPACT_NINF)
@@ -580,209 +589,215 @@ static const yytype_int16 yytoknum[] =
 #define yytable_value_is_error(Yyn) \
   ((Yyn) == YYTABLE_NINF)
 
-  /* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
-     STATE-NUM.  */
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
 static const yytype_int16 yypact[] =
 {
-     -92,   111,   -92,    -7,     2,     9,   -13,   -92,     6,    16,
-      29,    39,    13,   200,   200,   200,   -92,    74,    81,   279,
-     -92,    65,   110,   200,    46,   178,    72,   189,   200,    69,
-     -92,   -92,   288,   -92,   -92,   -92,   200,   200,   200,   200,
-     200,   200,   200,   -92,   200,   -92,   200,   327,   -92,   243,
-      78,   -92,    82,   200,   207,   200,   298,   255,    -4,   -92,
-     128,   128,   318,    -5,    -5,   -92,   -92,    -6,   100,   200,
-     -92,   -92,   220,    87,   102,   233,   103,   200,   105,   114,
-     107,   -92,   -92,   -92,   -92,   117,   124,   125,   134,   127,
-     129,   157,   266,   150,   131,   148,   149,   171,   176,   167,
-     167,   160,   162,   181,   167,   165,   200,   -92,   187,   173,
-     192,   167,   167,     0,   -92,   -92,   198,   167,     1,   -92,
-     308,   167,   201,   167,     5,    14,   182,    30,   167,   203,
-     188,   -92,   191,   204,   167,    28,   208,   116,   210,   205,
-     209,   217,   222,   235,   221,   -92,   241,   246,   238,   239,
-     252,   258,   244,   269,   -92,   270,   273,   280,   264,   276,
-     -92,   167,   -92,   282,   297,   284,   307,   287,   294,   299,
-     304,   167,   326,   -92,   315,   -92,   317,   335,    -8,   167,
-     340,   341,   342,    45,   167,   -92,   343,   167,   328,   344,
-      58,   167,   167,   167,   329,   -92,    71,   167,    75,   346,
-     167,   330,   -92,    77,    79,   349,   -92,   332,   -92,   351,
-     334,   -92,   167,   353,   -92,   336,   -92,   337,   -92,   338,
-     -92,   339,   -92,   358,   345,   -92,   -92,   -92,   -92,   347,
-     -92,   -92
+     -95,   124,   -95,    -4,     3,    13,    69,   -95,   -23,    26,
+      67,    78,   117,   214,   214,   214,   -95,   113,   123,   305,
+     -95,     9,    94,   214,    57,    90,   193,   204,   214,   109,
+     -95,   -95,   314,   -95,   -95,   -95,   214,   214,   214,   214,
+     214,   214,   214,   -95,   214,   -95,   214,   363,   -95,   257,
+     112,   -95,   269,   115,   214,   221,   214,   324,   281,    -2,
+     -95,    99,    99,   354,   -17,   -17,   -95,   -95,    -9,   129,
+     214,   -95,     6,   -95,   234,   116,   118,   247,   119,   214,
+     120,   125,   122,   -95,   -95,   -95,   -95,   214,   136,   137,
+     138,   149,   140,   141,   172,   292,   146,   143,   145,   135,
+     144,   163,   171,   182,   182,   168,   164,   191,   182,   176,
+     214,   -95,   196,   181,   185,   202,   182,   182,    -3,   -95,
+     -95,   207,   182,     5,   -95,   334,   182,   212,   214,   182,
+      11,    20,   195,    40,   182,   215,   198,   -95,   201,   205,
+     182,   344,    24,   217,    79,   218,   220,   222,   223,   243,
+     248,   231,   -95,   253,   255,   242,   -95,   252,   266,   271,
+     258,   273,   -95,   283,   284,   287,   267,   276,   -95,   182,
+     -95,   295,   299,   289,   308,   313,   291,   303,   310,   182,
+     322,   -95,   319,   -95,   315,   342,    51,   182,   347,   352,
+     357,    31,   182,   -95,   362,   182,   353,   369,    32,   182,
+     182,   182,   358,   -95,    37,   182,    63,   371,   182,   359,
+     -95,    71,    80,   378,   -95,   361,   -95,   380,   364,   -95,
+     182,   381,   -95,   365,   -95,   366,   -95,   367,   -95,   368,
+     -95,   387,   370,   -95,   -95,   -95,   -95,   372,   -95,   -95
 };
 
-  /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
-     Performed when YYTABLE does not specify something else to do.  Zero
-     means the default is an error.  */
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
 static const yytype_int8 yydefact[] =
 {
        2,     0,     1,     0,     0,     0,    51,    50,     0,     0,
        0,     0,     0,     0,     0,     0,     3,     0,     0,     0,
        6,     0,     0,     0,     0,     0,     0,     0,     0,     0,
       49,    45,     0,     7,     8,    14,     0,     0,     0,     0,
-       0,     0,     0,    11,     0,    13,     0,    52,    56,    59,
-       0,    54,     0,     0,     0,     0,     0,     0,     0,    48,
-      47,    46,    40,    41,    42,    43,    44,     0,     0,     0,
-      55,    53,     0,     0,     0,     0,     0,     0,    61,     0,
-       0,    10,     9,    12,    60,     0,     0,     0,    57,     0,
-       0,    57,     0,     0,     0,     0,     0,     0,     0,    57,
-      57,     0,     0,     0,    57,     0,     0,    62,     0,     0,
-       0,    57,    57,     0,    58,    33,     0,    57,     0,    38,
-       0,    57,     0,    57,     0,     0,     0,     0,    57,     0,
-       0,    37,     0,     0,    57,     0,     0,     0,     0,     0,
-       0,     0,     0,     0,     0,    36,     0,     0,     0,     0,
-       0,     0,     0,     0,    26,     0,    28,     0,     0,     0,
-      35,    57,     5,     0,     0,     0,     0,     0,     0,     0,
-       0,    57,     0,    34,     0,     4,     0,     0,     0,    57,
-       0,     0,     0,     0,    57,    39,     0,    57,     0,     0,
-       0,    57,    57,    57,     0,    32,     0,    57,     0,     0,
-      57,     0,    23,     0,     0,     0,    31,     0,    30,     0,
-       0,    17,    57,     0,    22,     0,    21,     0,    25,     0,
-      29,     0,    16,     0,     0,    20,    24,    27,    15,     0,
-      19,    18
+       0,     0,     0,    11,     0,    13,     0,    52,    57,    60,
+       0,    54,    60,     0,     0,     0,     0,     0,     0,     0,
+      48,    47,    46,    40,    41,    42,    43,    44,     0,     0,
+       0,    56,     0,    53,     0,     0,     0,     0,     0,     0,
+      62,     0,     0,    10,     9,    12,    61,     0,     0,     0,
+       0,    58,     0,     0,    58,     0,     0,     0,     0,     0,
+       0,     0,     0,    58,    58,     0,     0,     0,    58,     0,
+       0,    63,     0,     0,     0,     0,    58,    58,     0,    59,
+      33,     0,    58,     0,    38,     0,    58,     0,     0,    58,
+       0,     0,     0,     0,    58,     0,     0,    37,     0,     0,
+      58,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,    36,     0,     0,     0,    55,     0,     0,     0,
+       0,     0,    26,     0,    28,     0,     0,     0,    35,    58,
+       5,     0,     0,     0,     0,     0,     0,     0,     0,    58,
+       0,    34,     0,     4,     0,     0,     0,    58,     0,     0,
+       0,     0,    58,    39,     0,    58,     0,     0,     0,    58,
+      58,    58,     0,    32,     0,    58,     0,     0,    58,     0,
+      23,     0,     0,     0,    31,     0,    30,     0,     0,    17,
+      58,     0,    22,     0,    21,     0,    25,     0,    29,     0,
+      16,     0,     0,    20,    24,    27,    15,     0,    19,    18
 };
 
-  /* YYPGOTO[NTERM-NUM].  */
+/* YYPGOTO[NTERM-NUM].  */
 static const yytype_int16 yypgoto[] =
 {
-     -92,   -92,   368,   -92,   -92,    21,   -91,   -19,   277
+     -95,   -95,   398,   -95,   -95,    30,   -94,    -8,   306
 };
 
-  /* YYDEFGOTO[NTERM-NUM].  */
+/* YYDEFGOTO[NTERM-NUM].  */
 static const yytype_int8 yydefgoto[] =
 {
-      -1,     1,   100,    17,    18,    19,   101,    50,    80
+       0,     1,   104,    17,    18,    19,   105,    86,    82
 };
 
-  /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
-     positive, shift that token.  If negative, reduce the rule whose
-     number is the opposite.  If YYTABLE_NINF, syntax error.  */
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
 static const yytype_int16 yytable[] =
 {
-     105,    78,   188,    20,    81,    23,    52,    21,   113,   114,
-     126,   130,    24,   118,    22,   136,    41,    42,    29,   189,
-     124,   125,    79,    82,   138,    67,   129,    68,   127,   131,
-     133,    25,   135,   137,    30,    31,    32,   143,   149,   141,
-     142,    26,   139,   148,    47,    49,    49,    54,    56,    57,
-      84,     6,     7,     8,    27,   194,   150,    60,    61,    62,
-      63,    64,    65,    66,    28,    49,    13,    49,   201,    14,
-     174,    15,    48,   195,    72,    43,    75,     6,     7,     8,
-     183,   207,    53,    44,    33,   210,   202,   215,   190,   217,
-      49,    34,    13,   196,    58,    14,   198,    15,    92,   208,
-     203,   204,   205,   211,    70,   216,   209,   218,    71,   213,
-      83,     2,     3,    87,     4,     5,     6,     7,     8,     9,
-      45,   223,    10,    11,    12,   152,   153,   120,    46,    88,
-      91,    13,    94,    95,    14,    93,    15,     4,     5,     6,
-       7,     8,     9,    96,    99,    10,    11,    39,    40,    41,
-      42,    97,    98,   102,    13,    78,   103,    14,   108,    15,
-       4,     5,     6,     7,     8,     9,   109,   104,    10,    11,
-       4,     5,     6,     7,     8,     9,   110,    13,    10,    11,
-      14,   111,    15,     6,     7,     8,   112,    13,   115,   116,
-      14,   117,    15,   119,     6,     7,     8,   121,    13,    55,
-     122,    14,   123,    15,    51,     6,     7,     8,   128,    13,
-     140,   134,    14,   144,    15,   155,   145,    73,   146,   156,
-      13,    36,    37,    14,    38,    15,    39,    40,    41,    42,
-      85,   158,   147,    74,    36,    37,   151,    38,   154,    39,
-      40,    41,    42,    89,   157,   159,    86,    36,    37,   160,
-      38,   161,    39,    40,    41,    42,   162,    36,    37,    90,
-      38,   165,    39,    40,    41,    42,   163,   164,   166,    36,
-      37,   167,    38,    69,    39,    40,    41,    42,   168,   169,
-      36,    37,   170,    38,    77,    39,    40,    41,    42,    35,
-     171,   172,   175,    36,    37,   106,    38,   179,    39,    40,
-      41,    42,    36,    37,   173,    38,   176,    39,    40,    41,
-      42,   177,    36,    37,    59,    38,   178,    39,    40,    41,
-      42,   180,    36,    37,    76,    38,   181,    39,    40,    41,
-      42,   182,    36,    37,   132,    -1,   184,    39,    40,    41,
-      42,    36,    37,   185,   186,   187,    39,    40,    41,    42,
-     191,   192,   193,   197,   200,   199,   212,   206,   214,   219,
-     220,   221,   222,   224,   225,   226,   227,   228,   229,    16,
-     107,     0,     0,   230,     0,   231
+     109,    83,    25,    80,    41,    42,    20,   132,    21,   118,
+     119,     6,     7,     8,   123,   136,    50,    53,    22,    43,
+      84,   143,   130,   131,    81,   133,    13,    44,   135,    14,
+     145,    15,   139,   137,   157,   142,    68,    87,    69,   144,
+     150,   202,   209,    30,    31,    32,   155,   215,   146,   148,
+     149,    26,   158,    47,    49,    52,    55,    57,    58,   203,
+     210,   196,     6,     7,     8,   216,    61,    62,    63,    64,
+      65,    66,    67,   218,    49,   182,    49,    13,   197,    99,
+      14,   223,    15,    48,    74,   191,    77,    23,   160,   161,
+     225,   219,    27,   198,    24,     6,     7,     8,   204,   224,
+      49,   206,    49,    28,    45,   211,   212,   213,   226,    95,
+      13,   217,    46,    14,   221,    15,    51,    49,    39,    40,
+      41,    42,    29,    33,     2,     3,   231,     4,     5,     6,
+       7,     8,     9,    34,    59,    10,    11,    12,    71,    85,
+     125,    73,    90,    97,    13,    91,    94,    14,    98,    15,
+      96,    80,     4,     5,     6,     7,     8,     9,   141,   103,
+      10,    11,   100,   113,   101,   102,   106,   114,   107,    13,
+     112,   115,    14,   116,    15,     4,     5,     6,     7,     8,
+       9,   117,   108,    10,    11,     4,     5,     6,     7,     8,
+       9,   121,    13,    10,    11,    14,   120,    15,     6,     7,
+       8,   122,    13,    54,   124,    14,   126,    15,   127,     6,
+       7,     8,   129,    13,    56,   128,    14,   134,    15,     6,
+       7,     8,   140,   147,    13,   151,   152,    14,   153,    15,
+     163,    75,   164,   154,    13,    36,    37,    14,    38,    15,
+      39,    40,    41,    42,    88,   159,   162,    76,    36,    37,
+     165,    38,   166,    39,    40,    41,    42,    92,   167,   168,
+      89,    36,    37,   169,    38,   170,    39,    40,    41,    42,
+     171,    36,    37,    93,    38,   173,    39,    40,    41,    42,
+     172,   174,   176,    36,    37,   175,    38,    70,    39,    40,
+      41,    42,   177,   178,   180,    36,    37,   179,    38,    72,
+      39,    40,    41,    42,   181,   183,    36,    37,   184,    38,
+      79,    39,    40,    41,    42,    35,   185,   186,   188,    36,
+      37,   110,    38,   187,    39,    40,    41,    42,    36,    37,
+     189,    38,   192,    39,    40,    41,    42,   190,    36,    37,
+      60,    38,   194,    39,    40,    41,    42,   193,    36,    37,
+      78,    38,   195,    39,    40,    41,    42,   199,    36,    37,
+     138,    38,   200,    39,    40,    41,    42,   201,    36,    37,
+     156,    -1,   205,    39,    40,    41,    42,    36,    37,   208,
+     207,   220,    39,    40,    41,    42,   214,   222,   227,   228,
+     229,   232,   230,   233,   234,   235,   236,   237,   238,    16,
+     239,     0,   111
 };
 
 static const yytype_int16 yycheck[] =
 {
-      91,     5,    10,    10,    10,    18,    25,     5,    99,   100,
-      10,    10,    25,   104,     5,    10,    21,    22,     5,    27,
-     111,   112,    26,    29,    10,    44,   117,    46,    28,    28,
-     121,    25,   123,    28,    13,    14,    15,   128,    10,     9,
-      10,    25,    28,   134,    23,    24,    25,    26,    27,    28,
-      69,     5,     6,     7,    25,    10,    28,    36,    37,    38,
-      39,    40,    41,    42,    25,    44,    20,    46,    10,    23,
-     161,    25,    26,    28,    53,    10,    55,     5,     6,     7,
-     171,    10,    10,    18,    10,    10,    28,    10,   179,    10,
-      69,    10,    20,   184,    25,    23,   187,    25,    77,    28,
-     191,   192,   193,    28,    26,    28,   197,    28,    26,   200,
-      10,     0,     1,    26,     3,     4,     5,     6,     7,     8,
-      10,   212,    11,    12,    13,     9,    10,   106,    18,    27,
-      27,    20,    18,    26,    23,    30,    25,     3,     4,     5,
-       6,     7,     8,    26,    10,    11,    12,    19,    20,    21,
-      22,    27,    27,    26,    20,     5,    27,    23,    27,    25,
-       3,     4,     5,     6,     7,     8,    18,    10,    11,    12,
-       3,     4,     5,     6,     7,     8,    27,    20,    11,    12,
-      23,    10,    25,     5,     6,     7,    10,    20,    28,    27,
-      23,    10,    25,    28,     5,     6,     7,    10,    20,    10,
-      27,    23,    10,    25,    26,     5,     6,     7,    10,    20,
-      28,    10,    23,    10,    25,    10,    28,    10,    27,    10,
-      20,    14,    15,    23,    17,    25,    19,    20,    21,    22,
-      10,     9,    28,    26,    14,    15,    28,    17,    28,    19,
-      20,    21,    22,    10,    27,    10,    26,    14,    15,    28,
-      17,    10,    19,    20,    21,    22,    10,    14,    15,    26,
-      17,     9,    19,    20,    21,    22,    28,    28,    10,    14,
-      15,    27,    17,    30,    19,    20,    21,    22,     9,     9,
-      14,    15,     9,    17,    29,    19,    20,    21,    22,    10,
-      10,    27,    10,    14,    15,    29,    17,    10,    19,    20,
-      21,    22,    14,    15,    28,    17,     9,    19,    20,    21,
-      22,    27,    14,    15,    26,    17,     9,    19,    20,    21,
-      22,    27,    14,    15,    26,    17,    27,    19,    20,    21,
-      22,    27,    14,    15,    26,    17,    10,    19,    20,    21,
-      22,    14,    15,    28,    27,    10,    19,    20,    21,    22,
-      10,    10,    10,    10,    10,    27,    10,    28,    28,    10,
-      28,    10,    28,    10,    28,    28,    28,    28,    10,     1,
-      93,    -1,    -1,    28,    -1,    28
+      94,    10,    25,     5,    21,    22,    10,    10,     5,   103,
+     104,     5,     6,     7,   108,    10,    24,    25,     5,    10,
+      29,    10,   116,   117,    26,    28,    20,    18,   122,    23,
+      10,    25,   126,    28,    10,   129,    44,    31,    46,    28,
+     134,    10,    10,    13,    14,    15,   140,    10,    28,     9,
+      10,    25,    28,    23,    24,    25,    26,    27,    28,    28,
+      28,    10,     5,     6,     7,    28,    36,    37,    38,    39,
+      40,    41,    42,    10,    44,   169,    46,    20,    27,    87,
+      23,    10,    25,    26,    54,   179,    56,    18,     9,    10,
+      10,    28,    25,   187,    25,     5,     6,     7,   192,    28,
+      70,   195,    72,    25,    10,   199,   200,   201,    28,    79,
+      20,   205,    18,    23,   208,    25,    26,    87,    19,    20,
+      21,    22,     5,    10,     0,     1,   220,     3,     4,     5,
+       6,     7,     8,    10,    25,    11,    12,    13,    26,    10,
+     110,    26,    26,    18,    20,    27,    27,    23,    26,    25,
+      30,     5,     3,     4,     5,     6,     7,     8,   128,    10,
+      11,    12,    26,    18,    27,    27,    26,    32,    27,    20,
+      27,    27,    23,    10,    25,     3,     4,     5,     6,     7,
+       8,    10,    10,    11,    12,     3,     4,     5,     6,     7,
+       8,    27,    20,    11,    12,    23,    28,    25,     5,     6,
+       7,    10,    20,    10,    28,    23,    10,    25,    27,     5,
+       6,     7,    10,    20,    10,    30,    23,    10,    25,     5,
+       6,     7,    10,    28,    20,    10,    28,    23,    27,    25,
+      10,    10,    10,    28,    20,    14,    15,    23,    17,    25,
+      19,    20,    21,    22,    10,    28,    28,    26,    14,    15,
+      27,    17,     9,    19,    20,    21,    22,    10,    10,    28,
+      26,    14,    15,    10,    17,    10,    19,    20,    21,    22,
+      28,    14,    15,    26,    17,     9,    19,    20,    21,    22,
+      28,    10,     9,    14,    15,    27,    17,    30,    19,    20,
+      21,    22,     9,     9,    27,    14,    15,    10,    17,    30,
+      19,    20,    21,    22,    28,    10,    14,    15,     9,    17,
+      29,    19,    20,    21,    22,    10,    27,     9,    27,    14,
+      15,    29,    17,    10,    19,    20,    21,    22,    14,    15,
+      27,    17,    10,    19,    20,    21,    22,    27,    14,    15,
+      26,    17,    27,    19,    20,    21,    22,    28,    14,    15,
+      26,    17,    10,    19,    20,    21,    22,    10,    14,    15,
+      26,    17,    10,    19,    20,    21,    22,    10,    14,    15,
+      26,    17,    10,    19,    20,    21,    22,    14,    15,    10,
+      27,    10,    19,    20,    21,    22,    28,    28,    10,    28,
+      10,    10,    28,    28,    28,    28,    28,    10,    28,     1,
+      28,    -1,    96
 };
 
-  /* YYSTOS[STATE-NUM] -- The (internal number of the) accessing
-     symbol of state STATE-NUM.  */
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
 static const yytype_int8 yystos[] =
 {
-       0,    32,     0,     1,     3,     4,     5,     6,     7,     8,
-      11,    12,    13,    20,    23,    25,    33,    34,    35,    36,
+       0,    34,     0,     1,     3,     4,     5,     6,     7,     8,
+      11,    12,    13,    20,    23,    25,    35,    36,    37,    38,
       10,     5,     5,    18,    25,    25,    25,    25,    25,     5,
-      36,    36,    36,    10,    10,    10,    14,    15,    17,    19,
-      20,    21,    22,    10,    18,    10,    18,    36,    26,    36,
-      38,    26,    38,    10,    36,    10,    36,    36,    25,    26,
-      36,    36,    36,    36,    36,    36,    36,    38,    38,    30,
-      26,    26,    36,    10,    26,    36,    26,    29,     5,    26,
-      39,    10,    29,    10,    38,    10,    26,    26,    27,    10,
-      26,    27,    36,    30,    18,    26,    26,    27,    27,    10,
-      33,    37,    26,    27,    10,    37,    29,    39,    27,    18,
-      27,    10,    10,    37,    37,    28,    27,    10,    37,    28,
-      36,    10,    27,    10,    37,    37,    10,    28,    10,    37,
-      10,    28,    26,    37,    10,    37,    10,    28,    10,    28,
-      28,     9,    10,    37,    10,    28,    27,    28,    37,    10,
-      28,    28,     9,    10,    28,    10,    10,    27,     9,    10,
-      28,    10,    10,    28,    28,     9,    10,    27,     9,     9,
-       9,    10,    27,    28,    37,    10,     9,    27,     9,    10,
-      27,    27,    27,    37,    10,    28,    27,    10,    10,    27,
-      37,    10,    10,    10,    10,    28,    37,    10,    37,    27,
-      10,    10,    28,    37,    37,    37,    28,    10,    28,    37,
-      10,    28,    10,    37,    28,    10,    28,    10,    28,    10,
-      28,    10,    28,    37,    10,    28,    28,    28,    28,    10,
-      28,    28
+      38,    38,    38,    10,    10,    10,    14,    15,    17,    19,
+      20,    21,    22,    10,    18,    10,    18,    38,    26,    38,
+      40,    26,    38,    40,    10,    38,    10,    38,    38,    25,
+      26,    38,    38,    38,    38,    38,    38,    38,    40,    40,
+      30,    26,    30,    26,    38,    10,    26,    38,    26,    29,
+       5,    26,    41,    10,    29,    10,    40,    31,    10,    26,
+      26,    27,    10,    26,    27,    38,    30,    18,    26,    40,
+      26,    27,    27,    10,    35,    39,    26,    27,    10,    39,
+      29,    41,    27,    18,    32,    27,    10,    10,    39,    39,
+      28,    27,    10,    39,    28,    38,    10,    27,    30,    10,
+      39,    39,    10,    28,    10,    39,    10,    28,    26,    39,
+      10,    38,    39,    10,    28,    10,    28,    28,     9,    10,
+      39,    10,    28,    27,    28,    39,    26,    10,    28,    28,
+       9,    10,    28,    10,    10,    27,     9,    10,    28,    10,
+      10,    28,    28,     9,    10,    27,     9,     9,     9,    10,
+      27,    28,    39,    10,     9,    27,     9,    10,    27,    27,
+      27,    39,    10,    28,    27,    10,    10,    27,    39,    10,
+      10,    10,    10,    28,    39,    10,    39,    27,    10,    10,
+      28,    39,    39,    39,    28,    10,    28,    39,    10,    28,
+      10,    39,    28,    10,    28,    10,    28,    10,    28,    10,
+      28,    39,    10,    28,    28,    28,    28,    10,    28,    28
 };
 
-  /* YYR1[YYN] -- Symbol number of symbol that rule YYN derives.  */
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr1[] =
 {
-       0,    31,    32,    32,    32,    32,    32,    33,    33,    33,
-      33,    33,    33,    33,    33,    34,    34,    34,    34,    34,
-      34,    34,    34,    34,    34,    34,    34,    34,    34,    34,
-      34,    34,    34,    34,    35,    35,    35,    35,    35,    35,
+       0,    33,    34,    34,    34,    34,    34,    35,    35,    35,
+      35,    35,    35,    35,    35,    36,    36,    36,    36,    36,
       36,    36,    36,    36,    36,    36,    36,    36,    36,    36,
-      36,    36,    36,    36,    36,    36,    36,    37,    37,    38,
-      38,    39,    39
+      36,    36,    36,    36,    37,    37,    37,    37,    37,    37,
+      38,    38,    38,    38,    38,    38,    38,    38,    38,    38,
+      38,    38,    38,    38,    38,    38,    38,    38,    39,    39,
+      40,    40,    41,    41
 };
 
-  /* YYR2[YYN] -- Number of symbols on the right hand side of rule YYN.  */
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr2[] =
 {
        0,     2,     0,     2,    12,    11,     3,     2,     2,     5,
@@ -790,19 +805,20 @@ static const yytype_int8 yyr2[] =
       16,    15,    15,    14,    16,    15,    10,    16,    10,    15,
       14,    14,    13,     7,    11,    10,     9,     8,     7,    12,
        3,     3,     3,     3,     3,     2,     3,     3,     3,     2,
-       1,     1,     3,     4,     3,     4,     3,     0,     2,     1,
-       3,     1,     3
+       1,     1,     3,     4,     3,    10,     4,     3,     0,     2,
+       1,     3,     1,     3
 };
 
 
+enum { YYENOMEM = -2 };
+
 #define yyerrok         (yyerrstatus = 0)
 #define yyclearin       (yychar = YYEMPTY)
-#define YYEMPTY         (-2)
-#define YYEOF           0
 
 #define YYACCEPT        goto yyacceptlab
 #define YYABORT         goto yyabortlab
 #define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
 
 
 #define YYRECOVERING()  (!!yyerrstatus)
@@ -819,15 +835,14 @@ static const yytype_int8 yyr2[] =
       }                                                           \
     else                                                          \
       {                                                           \
-        yyerror (YY_("syntax error: cannot back up")); \
+        yyerror (scanner, YY_("syntax error: cannot back up")); \
         YYERROR;                                                  \
       }                                                           \
   while (0)
 
-/* Error token number */
-#define YYTERROR        1
-#define YYERRCODE       256
-
+/* Backward compatibility with an undocumented macro.
+   Use YYerror or YYUNDEF. */
+#define YYERRCODE YYUNDEF
 
 
 /* Enable debugging if requested.  */
@@ -844,19 +859,16 @@ do {                                            \
     YYFPRINTF Args;                             \
 } while (0)
 
-/* This macro is provided for backward compatibility. */
-#ifndef YY_LOCATION_PRINT
-# define YY_LOCATION_PRINT(File, Loc) ((void) 0)
-#endif
 
 
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)                    \
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
 do {                                                                      \
   if (yydebug)                                                            \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Type, Value); \
+                  Kind, Value, scanner); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
@@ -867,18 +879,16 @@ do {                                                                      \
 `-----------------------------------*/
 
 static void
-yy_symbol_value_print (FILE *yyo, int yytype, YYSTYPE const * const yyvaluep)
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, yyscan_t scanner)
 {
   FILE *yyoutput = yyo;
-  YYUSE (yyoutput);
+  YY_USE (yyoutput);
+  YY_USE (scanner);
   if (!yyvaluep)
     return;
-# ifdef YYPRINT
-  if (yytype < YYNTOKENS)
-    YYPRINT (yyo, yytoknum[yytype], *yyvaluep);
-# endif
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-  YYUSE (yytype);
+  YY_USE (yykind);
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
@@ -888,12 +898,13 @@ yy_symbol_value_print (FILE *yyo, int yytype, YYSTYPE const * const yyvaluep)
 `---------------------------*/
 
 static void
-yy_symbol_print (FILE *yyo, int yytype, YYSTYPE const * const yyvaluep)
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, yyscan_t scanner)
 {
   YYFPRINTF (yyo, "%s %s (",
-             yytype < YYNTOKENS ? "token" : "nterm", yytname[yytype]);
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  yy_symbol_value_print (yyo, yytype, yyvaluep);
+  yy_symbol_value_print (yyo, yykind, yyvaluep, scanner);
   YYFPRINTF (yyo, ")");
 }
 
@@ -926,7 +937,8 @@ do {                                                            \
 `------------------------------------------------*/
 
 static void
-yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, int yyrule)
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
+                 int yyrule, yyscan_t scanner)
 {
   int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
@@ -938,9 +950,8 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, int yyrule)
     {
       YYFPRINTF (stderr, "   $%d = ", yyi + 1);
       yy_symbol_print (stderr,
-                       yystos[+yyssp[yyi + 1 - yynrhs]],
-                       &yyvsp[(yyi + 1) - (yynrhs)]
-                                              );
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)], scanner);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -948,15 +959,15 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, int yyrule)
 # define YY_REDUCE_PRINT(Rule)          \
 do {                                    \
   if (yydebug)                          \
-    yy_reduce_print (yyssp, yyvsp, Rule); \
+    yy_reduce_print (yyssp, yyvsp, Rule, scanner); \
 } while (0)
 
 /* Nonzero means print parse trace.  It is left uninitialized so that
    multiple parsers can coexist.  */
 int yydebug;
 #else /* !YYDEBUG */
-# define YYDPRINTF(Args)
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
 # define YY_STACK_PRINT(Bottom, Top)
 # define YY_REDUCE_PRINT(Rule)
 #endif /* !YYDEBUG */
@@ -979,265 +990,32 @@ int yydebug;
 #endif
 
 
-#if YYERROR_VERBOSE
-
-# ifndef yystrlen
-#  if defined __GLIBC__ && defined _STRING_H
-#   define yystrlen(S) (YY_CAST (YYPTRDIFF_T, strlen (S)))
-#  else
-/* Return the length of YYSTR.  */
-static YYPTRDIFF_T
-yystrlen (const char *yystr)
-{
-  YYPTRDIFF_T yylen;
-  for (yylen = 0; yystr[yylen]; yylen++)
-    continue;
-  return yylen;
-}
-#  endif
-# endif
-
-# ifndef yystpcpy
-#  if defined __GLIBC__ && defined _STRING_H && defined _GNU_SOURCE
-#   define yystpcpy stpcpy
-#  else
-/* Copy YYSRC to YYDEST, returning the address of the terminating '\0' in
-   YYDEST.  */
-static char *
-yystpcpy (char *yydest, const char *yysrc)
-{
-  char *yyd = yydest;
-  const char *yys = yysrc;
-
-  while ((*yyd++ = *yys++) != '\0')
-    continue;
-
-  return yyd - 1;
-}
-#  endif
-# endif
-
-# ifndef yytnamerr
-/* Copy to YYRES the contents of YYSTR after stripping away unnecessary
-   quotes and backslashes, so that it's suitable for yyerror.  The
-   heuristic is that double-quoting is unnecessary unless the string
-   contains an apostrophe, a comma, or backslash (other than
-   backslash-backslash).  YYSTR is taken from yytname.  If YYRES is
-   null, do not copy; instead, return the length of what the result
-   would have been.  */
-static YYPTRDIFF_T
-yytnamerr (char *yyres, const char *yystr)
-{
-  if (*yystr == '"')
-    {
-      YYPTRDIFF_T yyn = 0;
-      char const *yyp = yystr;
-
-      for (;;)
-        switch (*++yyp)
-          {
-          case '\'':
-          case ',':
-            goto do_not_strip_quotes;
-
-          case '\\':
-            if (*++yyp != '\\')
-              goto do_not_strip_quotes;
-            else
-              goto append;
-
-          append:
-          default:
-            if (yyres)
-              yyres[yyn] = *yyp;
-            yyn++;
-            break;
-
-          case '"':
-            if (yyres)
-              yyres[yyn] = '\0';
-            return yyn;
-          }
-    do_not_strip_quotes: ;
-    }
-
-  if (yyres)
-    return yystpcpy (yyres, yystr) - yyres;
-  else
-    return yystrlen (yystr);
-}
-# endif
-
-/* Copy into *YYMSG, which is of size *YYMSG_ALLOC, an error message
-   about the unexpected token YYTOKEN for the state stack whose top is
-   YYSSP.
-
-   Return 0 if *YYMSG was successfully written.  Return 1 if *YYMSG is
-   not large enough to hold the message.  In that case, also set
-   *YYMSG_ALLOC to the required number of bytes.  Return 2 if the
-   required number of bytes is too large to store.  */
-static int
-yysyntax_error (YYPTRDIFF_T *yymsg_alloc, char **yymsg,
-                yy_state_t *yyssp, int yytoken)
-{
-  enum { YYERROR_VERBOSE_ARGS_MAXIMUM = 5 };
-  /* Internationalized format string. */
-  const char *yyformat = YY_NULLPTR;
-  /* Arguments of yyformat: reported tokens (one for the "unexpected",
-     one per "expected"). */
-  char const *yyarg[YYERROR_VERBOSE_ARGS_MAXIMUM];
-  /* Actual size of YYARG. */
-  int yycount = 0;
-  /* Cumulated lengths of YYARG.  */
-  YYPTRDIFF_T yysize = 0;
-
-  /* There are many possibilities here to consider:
-     - If this state is a consistent state with a default action, then
-       the only way this function was invoked is if the default action
-       is an error action.  In that case, don't check for expected
-       tokens because there are none.
-     - The only way there can be no lookahead present (in yychar) is if
-       this state is a consistent state with a default action.  Thus,
-       detecting the absence of a lookahead is sufficient to determine
-       that there is no unexpected or expected token to report.  In that
-       case, just report a simple "syntax error".
-     - Don't assume there isn't a lookahead just because this state is a
-       consistent state with a default action.  There might have been a
-       previous inconsistent state, consistent state with a non-default
-       action, or user semantic action that manipulated yychar.
-     - Of course, the expected token list depends on states to have
-       correct lookahead information, and it depends on the parser not
-       to perform extra reductions after fetching a lookahead from the
-       scanner and before detecting a syntax error.  Thus, state merging
-       (from LALR or IELR) and default reductions corrupt the expected
-       token list.  However, the list is correct for canonical LR with
-       one exception: it will still contain any token that will not be
-       accepted due to an error action in a later state.
-  */
-  if (yytoken != YYEMPTY)
-    {
-      int yyn = yypact[+*yyssp];
-      YYPTRDIFF_T yysize0 = yytnamerr (YY_NULLPTR, yytname[yytoken]);
-      yysize = yysize0;
-      yyarg[yycount++] = yytname[yytoken];
-      if (!yypact_value_is_default (yyn))
-        {
-          /* Start YYX at -YYN if negative to avoid negative indexes in
-             YYCHECK.  In other words, skip the first -YYN actions for
-             this state because they are default actions.  */
-          int yyxbegin = yyn < 0 ? -yyn : 0;
-          /* Stay within bounds of both yycheck and yytname.  */
-          int yychecklim = YYLAST - yyn + 1;
-          int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
-          int yyx;
-
-          for (yyx = yyxbegin; yyx < yyxend; ++yyx)
-            if (yycheck[yyx + yyn] == yyx && yyx != YYTERROR
-                && !yytable_value_is_error (yytable[yyx + yyn]))
-              {
-                if (yycount == YYERROR_VERBOSE_ARGS_MAXIMUM)
-                  {
-                    yycount = 1;
-                    yysize = yysize0;
-                    break;
-                  }
-                yyarg[yycount++] = yytname[yyx];
-                {
-                  YYPTRDIFF_T yysize1
-                    = yysize + yytnamerr (YY_NULLPTR, yytname[yyx]);
-                  if (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM)
-                    yysize = yysize1;
-                  else
-                    return 2;
-                }
-              }
-        }
-    }
-
-  switch (yycount)
-    {
-# define YYCASE_(N, S)                      \
-      case N:                               \
-        yyformat = S;                       \
-      break
-    default: /* Avoid compiler warnings. */
-      YYCASE_(0, YY_("syntax error"));
-      YYCASE_(1, YY_("syntax error, unexpected %s"));
-      YYCASE_(2, YY_("syntax error, unexpected %s, expecting %s"));
-      YYCASE_(3, YY_("syntax error, unexpected %s, expecting %s or %s"));
-      YYCASE_(4, YY_("syntax error, unexpected %s, expecting %s or %s or %s"));
-      YYCASE_(5, YY_("syntax error, unexpected %s, expecting %s or %s or %s or %s"));
-# undef YYCASE_
-    }
 
-  {
-    /* Don't count the "%s"s in the final size, but reserve room for
-       the terminator.  */
-    YYPTRDIFF_T yysize1 = yysize + (yystrlen (yyformat) - 2 * yycount) + 1;
-    if (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM)
-      yysize = yysize1;
-    else
-      return 2;
-  }
 
-  if (*yymsg_alloc < yysize)
-    {
-      *yymsg_alloc = 2 * yysize;
-      if (! (yysize <= *yymsg_alloc
-             && *yymsg_alloc <= YYSTACK_ALLOC_MAXIMUM))
-        *yymsg_alloc = YYSTACK_ALLOC_MAXIMUM;
-      return 1;
-    }
 
-  /* Avoid sprintf, as that infringes on the user's name space.
-     Don't have undefined behavior even if the translation
-     produced a string with the wrong number of "%s"s.  */
-  {
-    char *yyp = *yymsg;
-    int yyi = 0;
-    while ((*yyp = *yyformat) != '\0')
-      if (*yyp == '%' && yyformat[1] == 's' && yyi < yycount)
-        {
-          yyp += yytnamerr (yyp, yyarg[yyi++]);
-          yyformat += 2;
-        }
-      else
-        {
-          ++yyp;
-          ++yyformat;
-        }
-  }
-  return 0;
-}
-#endif /* YYERROR_VERBOSE */
 
 /*-----------------------------------------------.
 | Release the memory associated to this symbol.  |
 `-----------------------------------------------*/
 
 static void
-yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep)
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, yyscan_t scanner)
 {
-  YYUSE (yyvaluep);
+  YY_USE (yyvaluep);
+  YY_USE (scanner);
   if (!yymsg)
     yymsg = "Deleting";
-  YY_SYMBOL_PRINT (yymsg, yytype, yyvaluep, yylocationp);
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
 
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-  YYUSE (yytype);
+  YY_USE (yykind);
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
 
 
 
-/* The lookahead symbol.  */
-int yychar;
-
-/* The semantic value of the lookahead symbol.  */
-YYSTYPE yylval;
-/* Number of syntax errors so far.  */
-int yynerrs;
 
 
 /*----------.
@@ -1245,45 +1023,51 @@ int yynerrs;
 `----------*/
 
 int
-yyparse (void)
+yyparse (yyscan_t scanner)
 {
-    yy_state_fast_t yystate;
-    /* Number of tokens to shift before error messages enabled.  */
-    int yyerrstatus;
+/* Lookahead token kind.  */
+int yychar;
+
+
+/* The semantic value of the lookahead symbol.  */
+/* Default value used for initialization, for pacifying older GCCs
+   or non-GCC compilers.  */
+YY_INITIAL_VALUE (static YYSTYPE yyval_default;)
+YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
 
-    /* The stacks and their tools:
-       'yyss': related to states.
-       'yyvs': related to semantic values.
+    /* Number of syntax errors so far.  */
+    int yynerrs = 0;
 
-       Refer to the stacks through separate pointers, to allow yyoverflow
+    yy_state_fast_t yystate = 0;
+    /* Number of tokens to shift before error messages enabled.  */
+    int yyerrstatus = 0;
+
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
        to reallocate them elsewhere.  */
 
-    /* The state stack.  */
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
+
+    /* The state stack: array, bottom, top.  */
     yy_state_t yyssa[YYINITDEPTH];
-    yy_state_t *yyss;
-    yy_state_t *yyssp;
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
 
-    /* The semantic value stack.  */
+    /* The semantic value stack: array, bottom, top.  */
     YYSTYPE yyvsa[YYINITDEPTH];
-    YYSTYPE *yyvs;
-    YYSTYPE *yyvsp;
-
-    YYPTRDIFF_T yystacksize;
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
 
   int yyn;
+  /* The return value of yyparse.  */
   int yyresult;
-  /* Lookahead token as an internal (translated) token number.  */
-  int yytoken = 0;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
   /* The variables used to return semantic value and location from the
      action routines.  */
   YYSTYPE yyval;
 
-#if YYERROR_VERBOSE
-  /* Buffer for error messages, and its allocated size.  */
-  char yymsgbuf[128];
-  char *yymsg = yymsgbuf;
-  YYPTRDIFF_T yymsg_alloc = sizeof yymsgbuf;
-#endif
+
 
 #define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N))
 
@@ -1291,16 +1075,10 @@ yyparse (void)
      Keep to zero when no symbol should be popped.  */
   int yylen = 0;
 
-  yyssp = yyss = yyssa;
-  yyvsp = yyvs = yyvsa;
-  yystacksize = YYINITDEPTH;
-
   YYDPRINTF ((stderr, "Starting parse\n"));
 
-  yystate = 0;
-  yyerrstatus = 0;
-  yynerrs = 0;
   yychar = YYEMPTY; /* Cause a token to be read.  */
+
   goto yysetstate;
 
 
@@ -1322,10 +1100,11 @@ yysetstate:
   YY_IGNORE_USELESS_CAST_BEGIN
   *yyssp = YY_CAST (yy_state_t, yystate);
   YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
 
   if (yyss + yystacksize - 1 <= yyssp)
 #if !defined yyoverflow && !defined YYSTACK_RELOCATE
-    goto yyexhaustedlab;
+    YYNOMEM;
 #else
     {
       /* Get the current used size of the three stacks, in elements.  */
@@ -1353,7 +1132,7 @@ yysetstate:
 # else /* defined YYSTACK_RELOCATE */
       /* Extend the stack our own way.  */
       if (YYMAXDEPTH <= yystacksize)
-        goto yyexhaustedlab;
+        YYNOMEM;
       yystacksize *= 2;
       if (YYMAXDEPTH < yystacksize)
         yystacksize = YYMAXDEPTH;
@@ -1364,10 +1143,10 @@ yysetstate:
           YY_CAST (union yyalloc *,
                    YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
         if (! yyptr)
-          goto yyexhaustedlab;
+          YYNOMEM;
         YYSTACK_RELOCATE (yyss_alloc, yyss);
         YYSTACK_RELOCATE (yyvs_alloc, yyvs);
-# undef YYSTACK_RELOCATE
+#  undef YYSTACK_RELOCATE
         if (yyss1 != yyssa)
           YYSTACK_FREE (yyss1);
       }
@@ -1386,6 +1165,7 @@ yysetstate:
     }
 #endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
 
+
   if (yystate == YYFINAL)
     YYACCEPT;
 
@@ -1406,18 +1186,29 @@ yybackup:
 
   /* Not known => get a lookahead token if don't already have one.  */
 
-  /* YYCHAR is either YYEMPTY or YYEOF or a valid lookahead symbol.  */
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
   if (yychar == YYEMPTY)
     {
-      YYDPRINTF ((stderr, "Reading a token: "));
-      yychar = yylex ();
+      YYDPRINTF ((stderr, "Reading a token\n"));
+      yychar = yylex (&yylval, scanner);
     }
 
   if (yychar <= YYEOF)
     {
-      yychar = yytoken = YYEOF;
+      yychar = YYEOF;
+      yytoken = YYSYMBOL_YYEOF;
       YYDPRINTF ((stderr, "Now at end of input.\n"));
     }
+  else if (yychar == YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      goto yyerrlab1;
+    }
   else
     {
       yytoken = YYTRANSLATE (yychar);
@@ -1486,325 +1277,326 @@ yyreduce:
   YY_REDUCE_PRINT (yyn);
   switch (yyn)
     {
-  case 3:
-#line 43 "parser.y"
-                       {
-      struct val *value = eval((yyvsp[0].ast));
-      if(value) {
-         treefree((yyvsp[0].ast));
-      }
-    }
-#line 1498 "parser.tab.c"
+  case 3: /* learnpi: learnpi statement  */
+#line 60 "parser.y"
+                       { add_statement((yyvsp[0].ast)); }
+#line 1284 "parser.tab.c"
     break;
 
-  case 4:
-#line 49 "parser.y"
-                                                                { dodef((yyvsp[-9].str), (yyvsp[-7].symbol_list), (yyvsp[-2].ast)); }
-#line 1504 "parser.tab.c"
+  case 4: /* learnpi: learnpi FUN NAME '(' sym_list ')' '=' '{' EOL list '}' EOL  */
+#line 61 "parser.y"
+                                                                { add_function((yyvsp[-9].str), (yyvsp[-7].symbol_list), (yyvsp[-2].ast)); }
+#line 1290 "parser.tab.c"
     break;
 
-  case 5:
-#line 50 "parser.y"
-                                                       { dodef((yyvsp[-8].str), NULL, (yyvsp[-2].ast)); }
-#line 1510 "parser.tab.c"
+  case 5: /* learnpi: learnpi FUN NAME '(' ')' '=' '{' EOL list '}' EOL  */
+#line 62 "parser.y"
+                                                       { add_function((yyvsp[-8].str), NULL, (yyvsp[-2].ast)); }
+#line 1296 "parser.tab.c"
     break;
 
-  case 6:
-#line 51 "parser.y"
-                       { yyerrok; yyparse(); }
-#line 1516 "parser.tab.c"
+  case 6: /* learnpi: learnpi error EOL  */
+#line 63 "parser.y"
+                       { current_context->syntax_errors++; yyerrok; yyparse(scanner); }
+#line 1302 "parser.tab.c"
     break;
 
-  case 9:
-#line 56 "parser.y"
-                                         { (yyval.ast) = new_assignment((yyvsp[-3].str), (yyvsp[-1].ast) ); }
-#line 1522 "parser.tab.c"
+  case 9: /* statement: TYPE NAME '=' explist ';'  */
+#line 68 "parser.y"
+                                         { (yyval.ast) = new_declared_assignment((yyvsp[-3].str), (yyvsp[-1].ast) ); }
+#line 1308 "parser.tab.c"
     break;
 
-  case 10:
-#line 57 "parser.y"
-                                         { (yyval.ast) = new_assignment((yyvsp[-3].str), (yyvsp[-1].ast) ); }
-#line 1528 "parser.tab.c"
+  case 10: /* statement: TYPE NAME '=' explist EOL  */
+#line 69 "parser.y"
+                                         { (yyval.ast) = new_declared_assignment((yyvsp[-3].str), (yyvsp[-1].ast) ); }
+#line 1314 "parser.tab.c"
     break;
 
-  case 11:
-#line 58 "parser.y"
+  case 11: /* statement: TYPE NAME EOL  */
+#line 70 "parser.y"
                                          { (yyval.ast) = new_declaration((yyvsp[-1].str), (yyvsp[-2].type)); }
-#line 1534 "parser.tab.c"
+#line 1320 "parser.tab.c"
     break;
 
-  case 12:
-#line 59 "parser.y"
+  case 12: /* statement: COMPLEX_TYPE NAME '=' explist EOL  */
+#line 71 "parser.y"
                                          { (yyval.ast) = new_complex_assignment((yyvsp[-3].str), (yyvsp[-4].type), (yyvsp[-1].ast));}
-#line 1540 "parser.tab.c"
+#line 1326 "parser.tab.c"
     break;
 
-  case 13:
-#line 60 "parser.y"
+  case 13: /* statement: COMPLEX_TYPE NAME EOL  */
+#line 72 "parser.y"
                                          { (yyval.ast) = new_declaration((yyvsp[-1].str), (yyvsp[-2].type)); }
-#line 1546 "parser.tab.c"
+#line 1332 "parser.tab.c"
     break;
 
-  case 15:
-#line 64 "parser.y"
+  case 15: /* control_flow: IF '(' EOL exp EOL ')' '{' EOL list EOL '}' ELSE '{' EOL list EOL '}'  */
+#line 76 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-13].ast), (yyvsp[-8].ast), (yyvsp[-2].ast)); }
-#line 1552 "parser.tab.c"
+#line 1338 "parser.tab.c"
     break;
 
-  case 16:
-#line 65 "parser.y"
+  case 16: /* control_flow: IF '(' EOL exp EOL ')' '{' EOL list '}' ELSE '{' EOL list EOL '}'  */
+#line 77 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-12].ast), (yyvsp[-7].ast), (yyvsp[-2].ast)); }
-#line 1558 "parser.tab.c"
+#line 1344 "parser.tab.c"
     break;
 
-  case 17:
-#line 66 "parser.y"
+  case 17: /* control_flow: IF '(' EOL exp EOL ')' '{' EOL list '}' ELSE '{' EOL list '}'  */
+#line 78 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-11].ast), (yyvsp[-6].ast), (yyvsp[-1].ast)); }
-#line 1564 "parser.tab.c"
+#line 1350 "parser.tab.c"
     break;
 
-  case 18:
-#line 67 "parser.y"
+  case 18: /* control_flow: IF '(' EOL exp ')' '{' EOL list EOL '}' EOL ELSE EOL '{' EOL list EOL '}'  */
+#line 79 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-14].ast), (yyvsp[-10].ast), (yyvsp[-2].ast)); }
-#line 1570 "parser.tab.c"
+#line 1356 "parser.tab.c"
     break;
 
-  case 19:
-#line 68 "parser.y"
+  case 19: /* control_flow: IF '(' EOL exp ')' '{' EOL list EOL '}' EOL ELSE '{' EOL list EOL '}'  */
+#line 80 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-13].ast), (yyvsp[-9].ast), (yyvsp[-2].ast)); }
-#line 1576 "parser.tab.c"
+#line 1362 "parser.tab.c"
     break;
 
-  case 20:
-#line 69 "parser.y"
+  case 20: /* control_flow: IF '(' EOL exp ')' '{' EOL list '}' EOL ELSE '{' EOL list EOL '}'  */
+#line 81 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-12].ast), (yyvsp[-8].ast), (yyvsp[-2].ast)); }
-#line 1582 "parser.tab.c"
+#line 1368 "parser.tab.c"
     break;
 
-  case 21:
-#line 70 "parser.y"
+  case 21: /* control_flow: IF '(' EOL exp ')' '{' EOL list '}' EOL ELSE '{' EOL list '}'  */
+#line 82 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-11].ast), (yyvsp[-7].ast), (yyvsp[-1].ast)); }
-#line 1588 "parser.tab.c"
+#line 1374 "parser.tab.c"
     break;
 
-  case 22:
-#line 71 "parser.y"
+  case 22: /* control_flow: IF '(' EOL exp ')' '{' EOL list '}' ELSE '{' EOL list EOL '}'  */
+#line 83 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-11].ast), (yyvsp[-7].ast), (yyvsp[-2].ast)); }
-#line 1594 "parser.tab.c"
+#line 1380 "parser.tab.c"
     break;
 
-  case 23:
-#line 72 "parser.y"
+  case 23: /* control_flow: IF '(' EOL exp ')' '{' EOL list '}' ELSE '{' EOL list '}'  */
+#line 84 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-10].ast), (yyvsp[-6].ast), (yyvsp[-1].ast)); }
-#line 1600 "parser.tab.c"
+#line 1386 "parser.tab.c"
     break;
 
-  case 24:
-#line 73 "parser.y"
+  case 24: /* control_flow: IF '(' exp EOL ')' '{' EOL list '}' EOL ELSE '{' EOL list EOL '}'  */
+#line 85 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-13].ast), (yyvsp[-8].ast), (yyvsp[-2].ast)); }
-#line 1606 "parser.tab.c"
+#line 1392 "parser.tab.c"
     break;
 
-  case 25:
-#line 74 "parser.y"
+  case 25: /* control_flow: IF '(' exp EOL ')' '{' EOL list '}' EOL ELSE '{' EOL list '}'  */
+#line 86 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-12].ast), (yyvsp[-7].ast), (yyvsp[-1].ast)); }
-#line 1612 "parser.tab.c"
+#line 1398 "parser.tab.c"
     break;
 
-  case 26:
-#line 75 "parser.y"
+  case 26: /* control_flow: IF '(' exp EOL ')' '{' EOL list EOL '}'  */
+#line 87 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-7].ast), (yyvsp[-2].ast), NULL); }
-#line 1618 "parser.tab.c"
+#line 1404 "parser.tab.c"
     break;
 
-  case 27:
-#line 76 "parser.y"
+  case 27: /* control_flow: IF '(' exp ')' '{' EOL list EOL '}' EOL ELSE '{' EOL list EOL '}'  */
+#line 88 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-13].ast), (yyvsp[-9].ast), (yyvsp[-2].ast)); }
-#line 1624 "parser.tab.c"
+#line 1410 "parser.tab.c"
     break;
 
-  case 28:
-#line 77 "parser.y"
+  case 28: /* control_flow: IF '(' exp ')' '{' EOL list EOL '}' EOL  */
+#line 89 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-7].ast), (yyvsp[-3].ast), NULL); }
-#line 1630 "parser.tab.c"
+#line 1416 "parser.tab.c"
     break;
 
-  case 29:
-#line 78 "parser.y"
+  case 29: /* control_flow: IF '(' exp ')' '{' EOL list '}' EOL ELSE '{' EOL list EOL '}'  */
+#line 90 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-12].ast), (yyvsp[-8].ast), (yyvsp[-2].ast)); }
-#line 1636 "parser.tab.c"
+#line 1422 "parser.tab.c"
     break;
 
-  case 30:
-#line 79 "parser.y"
+  case 30: /* control_flow: IF '(' exp ')' '{' EOL list '}' EOL ELSE '{' EOL list '}'  */
+#line 91 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-11].ast), (yyvsp[-7].ast), (yyvsp[-1].ast)); }
-#line 1642 "parser.tab.c"
+#line 1428 "parser.tab.c"
     break;
 
-  case 31:
-#line 80 "parser.y"
+  case 31: /* control_flow: IF '(' exp ')' '{' EOL list '}' ELSE '{' EOL list EOL '}'  */
+#line 92 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-11].ast), (yyvsp[-7].ast), (yyvsp[-2].ast)); }
-#line 1648 "parser.tab.c"
+#line 1434 "parser.tab.c"
     break;
 
-  case 32:
-#line 81 "parser.y"
+  case 32: /* control_flow: IF '(' exp ')' '{' EOL list '}' ELSE '{' EOL list '}'  */
+#line 93 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-10].ast), (yyvsp[-6].ast), (yyvsp[-1].ast)); }
-#line 1654 "parser.tab.c"
+#line 1440 "parser.tab.c"
     break;
 
-  case 33:
-#line 82 "parser.y"
+  case 33: /* control_flow: IF '(' exp ')' '{' list '}'  */
+#line 94 "parser.y"
                                                                                       { (yyval.ast) = newflow(IF_STATEMENT, (yyvsp[-4].ast), (yyvsp[-1].ast), NULL); }
-#line 1660 "parser.tab.c"
+#line 1446 "parser.tab.c"
     break;
 
-  case 34:
-#line 85 "parser.y"
+  case 34: /* loop_flow: WHILE '(' EOL exp EOL ')' '{' EOL list EOL '}'  */
+#line 97 "parser.y"
                                                              { (yyval.ast) = newflow(LOOP_STATEMENT, (yyvsp[-7].ast), (yyvsp[-2].ast), NULL); }
-#line 1666 "parser.tab.c"
+#line 1452 "parser.tab.c"
     break;
 
-  case 35:
-#line 86 "parser.y"
+  case 35: /* loop_flow: WHILE '(' EOL exp ')' '{' EOL list EOL '}'  */
+#line 98 "parser.y"
                                                              { (yyval.ast) = newflow(LOOP_STATEMENT, (yyvsp[-6].ast), (yyvsp[-2].ast), NULL); }
-#line 1672 "parser.tab.c"
+#line 1458 "parser.tab.c"
     break;
 
-  case 36:
-#line 87 "parser.y"
+  case 36: /* loop_flow: WHILE '(' exp ')' '{' EOL list EOL '}'  */
+#line 99 "parser.y"
                                                              { (yyval.ast) = newflow(LOOP_STATEMENT, (yyvsp[-6].ast), (yyvsp[-2].ast), NULL); }
-#line 1678 "parser.tab.c"
+#line 1464 "parser.tab.c"
     break;
 
-  case 37:
-#line 88 "parser.y"
+  case 37: /* loop_flow: WHILE '(' exp ')' '{' EOL list '}'  */
+#line 100 "parser.y"
                                                              { (yyval.ast) = newflow(LOOP_STATEMENT, (yyvsp[-5].ast), (yyvsp[-1].ast), NULL); }
-#line 1684 "parser.tab.c"
+#line 1470 "parser.tab.c"
     break;
 
-  case 38:
-#line 89 "parser.y"
+  case 38: /* loop_flow: WHILE '(' exp ')' '{' list '}'  */
+#line 101 "parser.y"
                                                              { (yyval.ast) = newflow(LOOP_STATEMENT, (yyvsp[-4].ast), (yyvsp[-1].ast), NULL); }
-#line 1690 "parser.tab.c"
+#line 1476 "parser.tab.c"
     break;
 
-  case 39:
-#line 90 "parser.y"
+  case 39: /* loop_flow: FOR '(' exp ';' exp ';' exp ')' '{' EOL list '}'  */
+#line 102 "parser.y"
                                                              { (yyval.ast) = new_for_flow(FOR_STATEMENT, (yyvsp[-9].ast), (yyvsp[-7].ast), (yyvsp[-5].ast), (yyvsp[-1].ast)); }
-#line 1696 "parser.tab.c"
+#line 1482 "parser.tab.c"
     break;
 
-  case 40:
-#line 93 "parser.y"
+  case 40: /* exp: exp CMP exp  */
+#line 105 "parser.y"
                                              { (yyval.ast) = new_comparison((yyvsp[-1].function_id), (yyvsp[-2].ast), (yyvsp[0].ast)); }
-#line 1702 "parser.tab.c"
+#line 1488 "parser.tab.c"
     break;
 
-  case 41:
-#line 94 "parser.y"
+  case 41: /* exp: exp '+' exp  */
+#line 106 "parser.y"
                                              { (yyval.ast) = new_ast_with_children('+', (yyvsp[-2].ast), (yyvsp[0].ast)); }
-#line 1708 "parser.tab.c"
+#line 1494 "parser.tab.c"
     break;
 
-  case 42:
-#line 95 "parser.y"
+  case 42: /* exp: exp '-' exp  */
+#line 107 "parser.y"
                                              { (yyval.ast) = new_ast_with_children('-', (yyvsp[-2].ast), (yyvsp[0].ast)); }
-#line 1714 "parser.tab.c"
+#line 1500 "parser.tab.c"
     break;
 
-  case 43:
-#line 96 "parser.y"
+  case 43: /* exp: exp '*' exp  */
+#line 108 "parser.y"
                                              { (yyval.ast) = new_ast_with_children('*', (yyvsp[-2].ast), (yyvsp[0].ast)); }
-#line 1720 "parser.tab.c"
+#line 1506 "parser.tab.c"
     break;
 
-  case 44:
-#line 97 "parser.y"
+  case 44: /* exp: exp '/' exp  */
+#line 109 "parser.y"
                                              { (yyval.ast) = new_ast_with_children('/', (yyvsp[-2].ast), (yyvsp[0].ast)); }
-#line 1726 "parser.tab.c"
+#line 1512 "parser.tab.c"
     break;
 
-  case 45:
-#line 98 "parser.y"
+  case 45: /* exp: '|' exp  */
+#line 110 "parser.y"
                                              { (yyval.ast) = new_ast_with_child('|', (yyvsp[0].ast)); }
-#line 1732 "parser.tab.c"
+#line 1518 "parser.tab.c"
     break;
 
-  case 46:
-#line 99 "parser.y"
+  case 46: /* exp: exp AND_OPERATION exp  */
+#line 111 "parser.y"
                                              { (yyval.ast) = new_ast_with_children(LOGICAL_AND, (yyvsp[-2].ast), (yyvsp[0].ast)); }
-#line 1738 "parser.tab.c"
+#line 1524 "parser.tab.c"
     break;
 
-  case 47:
-#line 100 "parser.y"
+  case 47: /* exp: exp OR_OPERATION exp  */
+#line 112 "parser.y"
                                              { (yyval.ast) = new_ast_with_children(LOGICAL_OR, (yyvsp[-2].ast), (yyvsp[0].ast)); }
-#line 1744 "parser.tab.c"
+#line 1530 "parser.tab.c"
     break;
 
-  case 48:
-#line 101 "parser.y"
+  case 48: /* exp: '(' exp ')'  */
+#line 113 "parser.y"
                                              { (yyval.ast) = (yyvsp[-1].ast); }
-#line 1750 "parser.tab.c"
+#line 1536 "parser.tab.c"
     break;
 
-  case 49:
-#line 102 "parser.y"
+  case 49: /* exp: '-' exp  */
+#line 114 "parser.y"
                                              { (yyval.ast) = new_ast_with_child(UNARY_MINUS, (yyvsp[0].ast)); }
-#line 1756 "parser.tab.c"
+#line 1542 "parser.tab.c"
     break;
 
-  case 50:
-#line 103 "parser.y"
+  case 50: /* exp: VALUE  */
+#line 115 "parser.y"
                                              { (yyval.ast) = new_value((yyvsp[0].value)); }
-#line 1762 "parser.tab.c"
+#line 1548 "parser.tab.c"
     break;
 
-  case 51:
-#line 104 "parser.y"
+  case 51: /* exp: NAME  */
+#line 116 "parser.y"
                                              { (yyval.ast) = new_reference((yyvsp[0].str)); }
-#line 1768 "parser.tab.c"
+#line 1554 "parser.tab.c"
     break;
 
-  case 52:
-#line 105 "parser.y"
+  case 52: /* exp: NAME '=' exp  */
+#line 117 "parser.y"
                                              { (yyval.ast) = new_assignment((yyvsp[-2].str), (yyvsp[0].ast)); }
-#line 1774 "parser.tab.c"
+#line 1560 "parser.tab.c"
     break;
 
-  case 53:
-#line 106 "parser.y"
+  case 53: /* exp: BUILT_IN_FUNCTION '(' explist ')'  */
+#line 118 "parser.y"
                                              { (yyval.ast) = new_builtin_function((yyvsp[-3].function_id), NULL, (yyvsp[-1].ast)); }
-#line 1780 "parser.tab.c"
+#line 1566 "parser.tab.c"
     break;
 
-  case 54:
-#line 107 "parser.y"
+  case 54: /* exp: BUILT_IN_FUNCTION '(' ')'  */
+#line 119 "parser.y"
                                              { (yyval.ast) = new_builtin_function((yyvsp[-2].function_id), NULL, NULL); }
-#line 1786 "parser.tab.c"
+#line 1572 "parser.tab.c"
     break;
 
-  case 55:
-#line 108 "parser.y"
+  case 55: /* exp: BUILT_IN_FUNCTION '(' exp ',' '[' explist ']' ',' exp ')'  */
+#line 120 "parser.y"
+                                                               { (yyval.ast) = new_pattern_function((yyvsp[-9].function_id), (yyvsp[-7].ast), (yyvsp[-4].ast), (yyvsp[-1].ast)); }
+#line 1578 "parser.tab.c"
+    break;
+
+  case 56: /* exp: NAME '(' explist ')'  */
+#line 121 "parser.y"
                                              { (yyval.ast) = new_user_function((yyvsp[-3].str), (yyvsp[-1].ast)); }
-#line 1792 "parser.tab.c"
+#line 1584 "parser.tab.c"
     break;
 
-  case 56:
-#line 109 "parser.y"
+  case 57: /* exp: NAME '(' ')'  */
+#line 122 "parser.y"
                                              { (yyval.ast) = new_user_function((yyvsp[-2].str), NULL); }
-#line 1798 "parser.tab.c"
+#line 1590 "parser.tab.c"
     break;
 
-  case 57:
-#line 112 "parser.y"
+  case 58: /* list: %empty  */
+#line 125 "parser.y"
                     { (yyval.ast) = NULL; }
-#line 1804 "parser.tab.c"
+#line 1596 "parser.tab.c"
     break;
 
-  case 58:
-#line 113 "parser.y"
+  case 59: /* list: statement list  */
+#line 126 "parser.y"
                     {
             if ((yyvsp[0].ast) == NULL) {
                   (yyval.ast) = (yyvsp[-1].ast);
@@ -1812,29 +1604,29 @@ yyreduce:
                   (yyval.ast) = new_ast_with_children(STATEMENT_LIST, (yyvsp[-1].ast), (yyvsp[0].ast));
             }
          }
-#line 1816 "parser.tab.c"
+#line 1608 "parser.tab.c"
     break;
 
-  case 60:
-#line 123 "parser.y"
+  case 61: /* explist: exp ',' explist  */
+#line 136 "parser.y"
                        { (yyval.ast) = new_ast_with_children(STATEMENT_LIST, (yyvsp[-2].ast), (yyvsp[0].ast)); }
-#line 1822 "parser.tab.c"
+#line 1614 "parser.tab.c"
     break;
 
-  case 61:
-#line 126 "parser.y"
+  case 62: /* sym_list: NAME  */
+#line 139 "parser.y"
                        { (yyval.symbol_list) = create_symbol_list((yyvsp[0].str), NULL); }
-#line 1828 "parser.tab.c"
+#line 1620 "parser.tab.c"
     break;
 
-  case 62:
-#line 127 "parser.y"
+  case 63: /* sym_list: NAME ',' sym_list  */
+#line 140 "parser.y"
                        { (yyval.symbol_list) = create_symbol_list((yyvsp[-2].str), (yyvsp[0].symbol_list)); }
-#line 1834 "parser.tab.c"
+#line 1626 "parser.tab.c"
     break;
 
 
-#line 1838 "parser.tab.c"
+#line 1630 "parser.tab.c"
 
       default: break;
     }
@@ -1849,11 +1641,10 @@ yyreduce:
      case of YYERROR or YYBACKUP, subsequent parser actions might lead
      to an incorrect destructor call or verbose syntax error message
      before the lookahead is translated.  */
-  YY_SYMBOL_PRINT ("-> $$ =", yyr1[yyn], &yyval, &yyloc);
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
 
   YYPOPSTACK (yylen);
   yylen = 0;
-  YY_STACK_PRINT (yyss, yyssp);
 
   *++yyvsp = yyval;
 
@@ -1877,50 +1668,14 @@ yyreduce:
 yyerrlab:
   /* Make sure we have latest lookahead translation.  See comments at
      user semantic actions for why this is necessary.  */
-  yytoken = yychar == YYEMPTY ? YYEMPTY : YYTRANSLATE (yychar);
-
+  yytoken = yychar == YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
   /* If not already recovering from an error, report this error.  */
   if (!yyerrstatus)
     {
       ++yynerrs;
-#if ! YYERROR_VERBOSE
-      yyerror (YY_("syntax error"));
-#else
-# define YYSYNTAX_ERROR yysyntax_error (&yymsg_alloc, &yymsg, \
-                                        yyssp, yytoken)
-      {
-        char const *yymsgp = YY_("syntax error");
-        int yysyntax_error_status;
-        yysyntax_error_status = YYSYNTAX_ERROR;
-        if (yysyntax_error_status == 0)
-          yymsgp = yymsg;
-        else if (yysyntax_error_status == 1)
-          {
-            if (yymsg != yymsgbuf)
-              YYSTACK_FREE (yymsg);
-            yymsg = YY_CAST (char *, YYSTACK_ALLOC (YY_CAST (YYSIZE_T, yymsg_alloc)));
-            if (!yymsg)
-              {
-                yymsg = yymsgbuf;
-                yymsg_alloc = sizeof yymsgbuf;
-                yysyntax_error_status = 2;
-              }
-            else
-              {
-                yysyntax_error_status = YYSYNTAX_ERROR;
-                yymsgp = yymsg;
-              }
-          }
-        yyerror (yymsgp);
-        if (yysyntax_error_status == 2)
-          goto yyexhaustedlab;
-      }
-# undef YYSYNTAX_ERROR
-#endif
+      yyerror (scanner, YY_("syntax error"));
     }
 
-
-
   if (yyerrstatus == 3)
     {
       /* If just tried and failed to reuse lookahead token after an
@@ -1935,7 +1690,7 @@ yyerrlab:
       else
         {
           yydestruct ("Error: discarding",
-                      yytoken, &yylval);
+                      yytoken, &yylval, scanner);
           yychar = YYEMPTY;
         }
     }
@@ -1953,6 +1708,7 @@ yyerrorlab:
      label yyerrorlab therefore never appears in user code.  */
   if (0)
     YYERROR;
+  ++yynerrs;
 
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYERROR.  */
@@ -1969,13 +1725,14 @@ yyerrorlab:
 yyerrlab1:
   yyerrstatus = 3;      /* Each real token shifted decrements this.  */
 
+  /* Pop stack until we find a state that shifts the error token.  */
   for (;;)
     {
       yyn = yypact[yystate];
       if (!yypact_value_is_default (yyn))
         {
-          yyn += YYTERROR;
-          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYTERROR)
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
             {
               yyn = yytable[yyn];
               if (0 < yyn)
@@ -1989,7 +1746,7 @@ yyerrlab1:
 
 
       yydestruct ("Error: popping",
-                  yystos[yystate], yyvsp);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, scanner);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -2001,7 +1758,7 @@ yyerrlab1:
 
 
   /* Shift the error token.  */
-  YY_SYMBOL_PRINT ("Shifting", yystos[yyn], yyvsp, yylsp);
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
 
   yystate = yyn;
   goto yynewstate;
@@ -2012,7 +1769,7 @@ yyerrlab1:
 `-------------------------------------*/
 yyacceptlab:
   yyresult = 0;
-  goto yyreturn;
+  goto yyreturnlab;
 
 
 /*-----------------------------------.
@@ -2020,31 +1777,29 @@ yyacceptlab:
 `-----------------------------------*/
 yyabortlab:
   yyresult = 1;
-  goto yyreturn;
+  goto yyreturnlab;
 
 
-#if !defined yyoverflow || YYERROR_VERBOSE
-/*-------------------------------------------------.
-| yyexhaustedlab -- memory exhaustion comes here.  |
-`-------------------------------------------------*/
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
 yyexhaustedlab:
-  yyerror (YY_("memory exhausted"));
+  yyerror (scanner, YY_("memory exhausted"));
   yyresult = 2;
-  /* Fall through.  */
-#endif
+  goto yyreturnlab;
 
 
-/*-----------------------------------------------------.
-| yyreturn -- parsing is finished, return the result.  |
-`-----------------------------------------------------*/
-yyreturn:
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
   if (yychar != YYEMPTY)
     {
       /* Make sure we have latest lookahead translation.  See comments at
          user semantic actions for why this is necessary.  */
       yytoken = YYTRANSLATE (yychar);
       yydestruct ("Cleanup: discarding lookahead",
-                  yytoken, &yylval);
+                  yytoken, &yylval, scanner);
     }
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYABORT or YYACCEPT.  */
@@ -2053,17 +1808,15 @@ yyreturn:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  yystos[+*yyssp], yyvsp);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, scanner);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
   if (yyss != yyssa)
     YYSTACK_FREE (yyss);
 #endif
-#if YYERROR_VERBOSE
-  if (yymsg != yymsgbuf)
-    YYSTACK_FREE (yymsg);
-#endif
+
   return yyresult;
 }
-#line 130 "parser.y"
+
+#line 143 "parser.y"
@@ -1,8 +1,8 @@
-/* A Bison parser, made by GNU Bison 3.5.1.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison interface for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2020 Free Software Foundation,
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
    Inc.
 
    This program is free software: you can redistribute it and/or modify
@@ -16,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -31,8 +31,9 @@
    This special exception was added by the Free Software Foundation in
    version 2.2 of Bison.  */
 
-/* Undocumented macros, especially those whose name start with YY_,
-   are private implementation details.  Do not rely on them.  */
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
 
 #ifndef YY_YY_PARSER_TAB_H_INCLUDED
 # define YY_YY_PARSER_TAB_H_INCLUDED
@@ -43,45 +44,61 @@
 #if YYDEBUG
 extern int yydebug;
 #endif
+/* "%code requires" blocks.  */
+#line 13 "parser.y"
 
-/* Token type.  */
+#include "learnpi.h"
+
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+
+#line 58 "parser.tab.h"
+
+/* Token kinds.  */
 #ifndef YYTOKENTYPE
 # define YYTOKENTYPE
   enum yytokentype
   {
-    TYPE = 258,
-    COMPLEX_TYPE = 259,
-    NAME = 260,
-    VALUE = 261,
-    BUILT_IN_FUNCTION = 262,
-    IF = 263,
-    ELSE = 264,
-    EOL = 265,
-    WHILE = 266,
-    FOR = 267,
-    FUN = 268,
-    OR_OPERATION = 269,
-    AND_OPERATION = 270,
-    NOT_OPERATION = 271,
-    CMP = 272,
-    UMINUS = 273
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    TYPE = 258,                    /* TYPE  */
+    COMPLEX_TYPE = 259,            /* COMPLEX_TYPE  */
+    NAME = 260,                    /* NAME  */
+    VALUE = 261,                   /* VALUE  */
+    BUILT_IN_FUNCTION = 262,       /* BUILT_IN_FUNCTION  */
+    IF = 263,                      /* IF  */
+    ELSE = 264,                    /* ELSE  */
+    EOL = 265,                     /* EOL  */
+    WHILE = 266,                   /* WHILE  */
+    FOR = 267,                     /* FOR  */
+    FUN = 268,                     /* FUN  */
+    OR_OPERATION = 269,            /* OR_OPERATION  */
+    AND_OPERATION = 270,           /* AND_OPERATION  */
+    NOT_OPERATION = 271,           /* NOT_OPERATION  */
+    CMP = 272,                     /* CMP  */
+    UMINUS = 273                   /* UMINUS  */
   };
+  typedef enum yytokentype yytoken_kind_t;
 #endif
 
 /* Value type.  */
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
 union YYSTYPE
 {
-#line 12 "parser.y"
+#line 29 "parser.y"
 
   struct ast *ast;
   struct symbol_list *symbol_list;
-  struct val *value;
+  struct val value;
   int function_id;
   char *str;
   int type;
 
-#line 85 "parser.tab.h"
+#line 102 "parser.tab.h"
 
 };
 typedef union YYSTYPE YYSTYPE;
@@ -90,8 +107,9 @@ typedef union YYSTYPE YYSTYPE;
 #endif
 
 
-extern YYSTYPE yylval;
 
-int yyparse (void);
+
+int yyparse (yyscan_t scanner);
+
 
 #endif /* !YY_YY_PARSER_TAB_H_INCLUDED  */
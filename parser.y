@@ -6,13 +6,30 @@
 
 #define YYDEBUG 1
 
-int yylex();   
+// The pure parser hands its scanner to yyerror, report through the interpreter's yyerror
+#define yyerror(scanner, message) yyerror("%s", message)
 %}
 
+%code requires {
+#include "learnpi.h"
+
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+}
+
+%code {
+int yylex(YYSTYPE *yylval, yyscan_t scanner);
+}
+
+%define api.pure full
+%param {yyscan_t scanner}
+
 %union {
   struct ast *ast;
   struct symbol_list *symbol_list;
-  struct val *value;
+  struct val value;
   int function_id;
   char *str;
   int type;
@@ -40,21 +57,16 @@ int yylex();
 
 %%
 learnpi: /* nothing */
-   | learnpi statement {
-      struct val *value = eval($2);
-      if(value) {
-         treefree($2);
-      }
-    }
-   | learnpi FUN NAME '(' sym_list ')' '=' '{' EOL list '}' EOL { dodef($3, $5, $10); }
-   | learnpi FUN NAME '(' ')' '=' '{' EOL list '}' EOL { dodef($3, NULL, $9); }
-   | learnpi error EOL { yyerrok; yyparse(); }
+   | learnpi statement { add_statement($2); }
+   | learnpi FUN NAME '(' sym_list ')' '=' '{' EOL list '}' EOL { add_function($3, $5, $10); }
+   | learnpi FUN NAME '(' ')' '=' '{' EOL list '}' EOL { add_function($3, NULL, $9); }
+   | learnpi error EOL { current_context->syntax_errors++; yyerrok; yyparse(scanner); }
 ;
 
 statement: control_flow EOL
    | loop_flow EOL
-   | TYPE NAME '=' explist ';'           { $$ = new_assignment($2, $4 ); }
-   | TYPE NAME '=' explist EOL           { $$ = new_assignment($2, $4 ); }
+   | TYPE NAME '=' explist ';'           { $$ = new_declared_assignment($2, $4 ); }
+   | TYPE NAME '=' explist EOL           { $$ = new_declared_assignment($2, $4 ); }
    | TYPE NAME EOL                       { $$ = new_declaration($2, $1); }
    | COMPLEX_TYPE NAME '=' explist EOL   { $$ = new_complex_assignment($2, $1, $4);}
    | COMPLEX_TYPE NAME EOL               { $$ = new_declaration($2, $1); }
@@ -105,6 +117,7 @@ exp: exp CMP exp                             { $$ = new_comparison($2, $1, $3);
    | NAME '=' exp                            { $$ = new_assignment($1, $3); }
    | BUILT_IN_FUNCTION '(' explist ')'       { $$ = new_builtin_function($1, NULL, $3); } /* Node for builtin function without name */
    | BUILT_IN_FUNCTION '(' ')'               { $$ = new_builtin_function($1, NULL, NULL); } /* Node for builtin function without name and parameters */
+   | BUILT_IN_FUNCTION '(' exp ',' '[' explist ']' ',' exp ')' { $$ = new_pattern_function($1, $3, $6, $9); } /* Node for builtin function with a list of times */
    | NAME '(' explist ')'                    { $$ = new_user_function($1, $3); } /* Node for user function call with parameters */
    | NAME '(' ')'                            { $$ = new_user_function($1, NULL); } /* Node for user function call without parameters */
 ;
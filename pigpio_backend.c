@@ -0,0 +1,175 @@
+// Built only with -DLEARNPI_PIGPIO, make PIGPIO=1 links it with pigpio
+#ifdef LEARNPI_PIGPIO
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include <errno.h>
+#include <time.h>
+
+#include <pigpio.h>
+
+#include "learnpi.h"
+#include "backend.h"
+
+// Function to start pigpio, which maps the gpio registers and starts its threads
+static int pigpio_init() {
+  return gpioInitialise() < 0 ? -1 : 0;
+}
+
+static void pigpio_terminate() {
+  gpioTerminate();
+}
+
+static int pigpio_set_mode(unsigned gpio, unsigned mode) {
+  return gpioSetMode(gpio, mode);
+}
+
+static int pigpio_set_pull(unsigned gpio, unsigned pull) {
+  return gpioSetPullUpDown(gpio, pull);
+}
+
+static int pigpio_write(unsigned gpio, unsigned level) {
+  return gpioWrite(gpio, level);
+}
+
+// Function to write both banks with one set and one clear register write each
+static int pigpio_write_banks(const uint32_t *set, const uint32_t *clear) {
+  if(set[0]) gpioWrite_Bits_0_31_Set(set[0]);
+  if(clear[0]) gpioWrite_Bits_0_31_Clear(clear[0]);
+  if(set[1]) gpioWrite_Bits_32_53_Set(set[1]);
+  if(clear[1]) gpioWrite_Bits_32_53_Clear(clear[1]);
+
+  return 0;
+}
+
+static int pigpio_read(unsigned gpio) {
+  return gpioRead(gpio);
+}
+
+static int pigpio_servo(unsigned gpio, unsigned width_us) {
+  return gpioServo(gpio, width_us);
+}
+
+static int pigpio_watch(unsigned gpio, gpio_alert_function alert) {
+  return gpioSetAlertFunc(gpio, alert);
+}
+
+// Function to read the time since the current script started in microseconds
+static uint64_t pigpio_now_us() {
+  struct timespec *started = &current_context->timing.started;
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((now.tv_sec - started->tv_sec) * 1000000000LL + (now.tv_nsec - started->tv_nsec)) / 1000;
+}
+
+// Function to sleep until a time of the script clock, returns at once if it has passed
+static void pigpio_sleep_until(uint64_t deadline_us) {
+  struct timespec *started = &current_context->timing.started;
+  struct timespec deadline;
+  uint64_t nanoseconds = started->tv_nsec + (deadline_us % 1000000) * 1000;
+
+  deadline.tv_sec = started->tv_sec + deadline_us / 1000000 + nanoseconds / 1000000000;
+  deadline.tv_nsec = nanoseconds % 1000000000;
+
+  // An absolute deadline does not move when the sleep starts late or is interrupted
+  while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR);
+}
+
+static void pigpio_delay(unsigned us) {
+  gpioDelay(us);
+}
+
+static uint32_t pigpio_tick() {
+  return gpioTick();
+}
+
+// Function to turn the times of a pattern into a waveform and start sending it, returns the wave id or a pigpio error.
+// The DMA engine of pigpio times the edges, the interpreter is not involved until the pattern stops.
+static int pigpio_wave_send(struct pattern_playback *pattern) {
+  gpioPulse_t pulses[MAX_PATTERN_STEPS];
+  uint32_t bit = (uint32_t)1 << pattern->gpio;
+  char chain[7];
+  int wave_id = 0;
+  int status = 0;
+
+  // Even steps turn the gpio on and odd steps turn it off, each lasts its time
+  for(int i = 0; i < pattern->step_count; i++) {
+    pulses[i].gpioOn = i % 2 ? 0 : bit;
+    pulses[i].gpioOff = i % 2 ? bit : 0;
+    pulses[i].usDelay = pattern->steps[i];
+  }
+
+  gpioWaveAddNew();
+  status = gpioWaveAddGeneric(pattern->step_count, pulses);
+
+  if(status < 0) {
+    return status;
+  }
+
+  wave_id = gpioWaveCreate();
+
+  if(wave_id < 0) {
+    return wave_id;
+  }
+
+  if(pattern->repeats == 0) {
+    status = gpioWaveTxSend(wave_id, PI_WAVE_MODE_REPEAT);
+  } else if(pattern->repeats == 1) {
+    status = gpioWaveTxSend(wave_id, PI_WAVE_MODE_ONE_SHOT);
+  } else {
+    // A chain loops the waveform in DMA, the count follows the loop end in little endian
+    chain[0] = 255;
+    chain[1] = 0;
+    chain[2] = wave_id;
+    chain[3] = 255;
+    chain[4] = 1;
+    chain[5] = pattern->repeats & 255;
+    chain[6] = pattern->repeats >> 8;
+    status = gpioWaveChain(chain, sizeof(chain));
+  }
+
+  if(status < 0) {
+    gpioWaveDelete(wave_id);
+    return status;
+  }
+
+  return wave_id;
+}
+
+static int pigpio_wave_busy() {
+  return gpioWaveTxBusy();
+}
+
+static void pigpio_wave_stop() {
+  gpioWaveTxStop();
+}
+
+static void pigpio_wave_delete(int wave_id) {
+  gpioWaveDelete(wave_id);
+}
+
+struct gpio_backend pigpio_backend = {
+  .name = "pigpio",
+  .simulated = 0,
+  .init = pigpio_init,
+  .terminate = pigpio_terminate,
+  .set_mode = pigpio_set_mode,
+  .set_pull = pigpio_set_pull,
+  .write = pigpio_write,
+  .write_banks = pigpio_write_banks,
+  .read = pigpio_read,
+  .servo = pigpio_servo,
+  .watch = pigpio_watch,
+  .now_us = pigpio_now_us,
+  .sleep_until = pigpio_sleep_until,
+  .delay = pigpio_delay,
+  .tick = pigpio_tick,
+  .wave_send = pigpio_wave_send,
+  .wave_busy = pigpio_wave_busy,
+  .wave_stop = pigpio_wave_stop,
+  .wave_delete = pigpio_wave_delete,
+};
+
+#endif
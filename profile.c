@@ -0,0 +1,322 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "learnpi.h"
+#include "functions.h"
+#include "bytecode.h"
+#include "profile.h"
+
+// Lines and built in functions the summary lists
+#define PROFILE_TOP 10
+
+int profile_enabled = 0;
+
+// Names of the built in functions, as scripts call them
+static const char *builtin_names[] = {
+  [BUILT_IN_PRINT] = "print",
+  [BUILT_IN_SQUARE_ROOT] = "square_root",
+  [BUILT_IN_LED_ON] = "led_on",
+  [BUILT_IN_LED_OFF] = "led_off",
+  [BUILT_IN_IS_BUTTON_PRESSED] = "is_button_pressed",
+  [BUILT_IN_GET_PRESSED_KEY] = "get_pressed_key",
+  [BUILT_IN_BUZZ_START] = "buzz_start",
+  [BUILT_IN_BUZZ_STOP] = "buzz_stop",
+  [BUILT_IN_MOVE_SERVO_TO_ANGLE] = "move_servo_to_angle",
+  [BUILT_IN_MOVE_SERVO_INFINITELY] = "move_servo_infinitely",
+  [BUILT_IN_SERVO_STOP] = "servo_stop",
+  [BUILT_IN_DELAY] = "delay",
+  [BUILT_IN_WAIT_FOR_PRESS] = "wait_for_press",
+  [BUILT_IN_WRITE_GROUP] = "write_group",
+  [BUILT_IN_DELAY_UNTIL] = "delay_until",
+  [BUILT_IN_PLAY_PATTERN] = "play_pattern",
+  [BUILT_IN_STOP_PATTERN] = "stop_pattern",
+  [BUILT_IN_WAIT_FOR_KEY] = "wait_for_key",
+};
+
+// Function to read a monotonic clock in nanoseconds
+static long long profile_now() {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Function to hash the key of a node
+static unsigned node_hash(int parent, const char *name, int line) {
+  uintptr_t address = (uintptr_t)name;
+
+  return (unsigned)(address ^ (address >> 17)) * 2654435761u ^ (unsigned)parent * 40503u ^ (unsigned)line * 9973u;
+}
+
+// Function to double the slots of the node set of a profile
+static void grow_profile_slots(struct profile *profile) {
+  int capacity = profile->slot_capacity ? profile->slot_capacity * 2 : 256;
+  int *slots = calloc(capacity, sizeof(int));
+  struct profile_node *node = NULL;
+  unsigned slot = 0;
+
+  if(!slots) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  for(int i = 0; i < profile->node_count; i++) {
+    node = &profile->nodes[i];
+    slot = node_hash(node->parent, node->name, node->line) & (capacity - 1);
+    while(slots[slot]) slot = (slot + 1) & (capacity - 1);
+    slots[slot] = i + 1;
+  }
+
+  free(profile->slots);
+  profile->slots = slots;
+  profile->slot_capacity = capacity;
+}
+
+// Function to find the node of a line or built in function called from a parent node, adding it the first time
+static int find_node(struct profile *profile, int parent, const char *name, int line) {
+  struct profile_node *node = NULL;
+  unsigned slot = 0;
+
+  if((profile->node_count + 1) * 2 > profile->slot_capacity) {
+    grow_profile_slots(profile);
+  }
+
+  for(slot = node_hash(parent, name, line) & (profile->slot_capacity - 1); profile->slots[slot]; slot = (slot + 1) & (profile->slot_capacity - 1)) {
+    node = &profile->nodes[profile->slots[slot] - 1];
+
+    if(node->parent == parent && node->name == name && node->line == line) {
+      return profile->slots[slot] - 1;
+    }
+  }
+
+  if(profile->node_count == profile->node_capacity) {
+    profile->node_capacity = profile->node_capacity ? profile->node_capacity * 2 : 64;
+    profile->nodes = realloc(profile->nodes, profile->node_capacity * sizeof(struct profile_node));
+
+    if(!profile->nodes) {
+      yyerror("out of space");
+      exit(0);
+    }
+  }
+
+  node = &profile->nodes[profile->node_count];
+  node->parent = parent;
+  node->name = name;
+  node->line = line;
+  node->self_ns = 0;
+  node->count = 0;
+
+  profile->slots[slot] = ++profile->node_count;
+  return profile->node_count - 1;
+}
+
+// Function to give the time since the last event to the node that was running
+static void charge(struct profile *profile) {
+  long long now = profile_now();
+
+  if(profile->current >= 0) {
+    profile->nodes[profile->current].self_ns += now - profile->last_ns;
+  }
+
+  profile->last_ns = now;
+}
+
+// Function to start profiling the current interpreter
+void start_profile(const char *script) {
+  struct profile *profile = calloc(1, sizeof(struct profile));
+
+  if(!profile) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  profile->frames = malloc((CALL_STACK_SIZE + 1) * sizeof(int));
+
+  if(!profile->frames) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  for(int i = 0; i <= CALL_STACK_SIZE; i++) {
+    profile->frames[i] = -1;
+  }
+
+  profile->script = script;
+  profile->current = -1;
+  profile->start_ns = profile->last_ns = profile_now();
+  current_context->profile = profile;
+}
+
+// Function to charge the time so far and start a line of the program running at a call depth
+void profile_line(struct program *program, int depth, int line) {
+  struct profile *profile = current_context->profile;
+  int parent = depth ? profile->frames[depth - 1] : -1;
+  int node = 0;
+
+  charge(profile);
+
+  node = find_node(profile, parent, program->name ? program->name : profile->script, line);
+  profile->nodes[node].count++;
+  profile->frames[depth] = node;
+  profile->current = node;
+}
+
+// Function to charge the time so far and start a built in function called at a call depth
+void profile_builtin(int function_type, int depth) {
+  struct profile *profile = current_context->profile;
+  int node = 0;
+
+  charge(profile);
+
+  node = find_node(profile, profile->frames[depth], builtin_names[function_type], 0);
+  profile->nodes[node].count++;
+  profile->current = node;
+}
+
+// Function to charge the time so far and continue the line a call depth was running, nothing for depth -1
+void profile_resume(int depth) {
+  struct profile *profile = current_context->profile;
+
+  charge(profile);
+  profile->current = depth >= 0 ? profile->frames[depth] : -1;
+}
+
+// Function to write the chain of calls that leads to a node, outermost first
+static void write_stack(FILE *output, struct profile *profile, int index) {
+  struct profile_node *node = &profile->nodes[index];
+
+  if(node->parent >= 0) {
+    write_stack(output, profile, node->parent);
+    fputc(';', output);
+  }
+
+  if(node->line) {
+    fprintf(output, "%s:%d", node->name, node->line);
+  } else {
+    fprintf(output, "%s", node->name);
+  }
+}
+
+// Function to order nodes by name and line, so the nodes of one line are next to each other
+static int compare_by_line(const void *first, const void *second) {
+  const struct profile_node *a = first;
+  const struct profile_node *b = second;
+  int names = strcmp(a->name, b->name);
+
+  if(names) {
+    return names;
+  }
+
+  return a->line - b->line;
+}
+
+// Function to order nodes by the time spent in them, longest first
+static int compare_by_time(const void *first, const void *second) {
+  const struct profile_node *a = first;
+  const struct profile_node *b = second;
+
+  return (a->self_ns < b->self_ns) - (a->self_ns > b->self_ns);
+}
+
+// Function to print the lines or the built in functions that took longest
+static void print_top(struct profile_node *totals, int count, int builtins) {
+  int printed = 0;
+  char label[96];
+
+  fprintf(stderr, "  %-40s %10s %12s\n", builtins ? "built in function" : "line", "calls", "self ms");
+
+  for(int i = 0; i < count && printed < PROFILE_TOP; i++) {
+    if((totals[i].line == 0) != builtins) {
+      continue;
+    }
+
+    if(builtins) {
+      snprintf(label, sizeof(label), "%s", totals[i].name);
+    } else {
+      snprintf(label, sizeof(label), "%s:%d", totals[i].name, totals[i].line);
+    }
+
+    fprintf(stderr, "  %-40s %10ld %12.3f\n", label, totals[i].count, totals[i].self_ns / 1e6);
+    printed++;
+  }
+}
+
+// Function to write the folded stacks to the script name with .folded appended, print the lines that took longest and stop profiling
+void finish_profile() {
+  struct profile *profile = current_context->profile;
+  struct profile_node *totals = NULL;
+  FILE *output = NULL;
+  char *output_path = NULL;
+  int count = 0;
+
+  if(!profile) {
+    return;
+  }
+
+  charge(profile);
+
+  output_path = malloc(strlen(profile->script) + sizeof(".folded"));
+
+  if(!output_path) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  sprintf(output_path, "%s.folded", profile->script);
+
+  // One line per chain of calls, weighted by nanoseconds, as flamegraph.pl and speedscope read them
+  output = fopen(output_path, "w");
+
+  if(!output) {
+    perror(output_path);
+  } else {
+    for(int i = 0; i < profile->node_count; i++) {
+      if(profile->nodes[i].self_ns > 0) {
+        write_stack(output, profile, i);
+        fprintf(output, " %lld\n", profile->nodes[i].self_ns);
+      }
+    }
+
+    fclose(output);
+  }
+
+  // The summary adds up every chain of calls that reaches the same line or built in function
+  totals = malloc((profile->node_count + 1) * sizeof(struct profile_node));
+
+  if(!totals) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  for(int i = 0; i < profile->node_count; i++) {
+    totals[i] = profile->nodes[i];
+  }
+
+  qsort(totals, profile->node_count, sizeof(struct profile_node), compare_by_line);
+
+  for(int i = 0; i < profile->node_count; i++) {
+    if(count && !compare_by_line(&totals[count - 1], &totals[i])) {
+      totals[count - 1].self_ns += totals[i].self_ns;
+      totals[count - 1].count += totals[i].count;
+    } else {
+      totals[count++] = totals[i];
+    }
+  }
+
+  qsort(totals, count, sizeof(struct profile_node), compare_by_time);
+
+  fprintf(stderr, "Profile of %s: %.3f ms, folded stacks in %s\n", profile->script, (profile->last_ns - profile->start_ns) / 1e6, output_path);
+  print_top(totals, count, 0);
+  print_top(totals, count, 1);
+
+  free(totals);
+  free(output_path);
+  free(profile->nodes);
+  free(profile->slots);
+  free(profile->frames);
+  free(profile);
+  current_context->profile = NULL;
+}
@@ -0,0 +1,49 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+
+// Structure for one line or built in function in a chain of calls, the parent is the line that called it
+struct profile_node {
+  int parent;                      // node of the calling line, -1 for lines of the script itself
+  const char *name;                // function or script of a line, or the name of a built in function
+  int line;                        // 0 for built in functions
+  long long self_ns;               // wall time spent here and not in a call or built in function
+  long count;                      // times the line started or the built in function was called
+};
+
+// Structure for the profile of one interpreter
+struct profile {
+  const char *script;              // name of the lines outside of any function
+  struct profile_node *nodes;
+  int node_count;
+  int node_capacity;
+  int *slots;                      // open addressing set of node indices plus one, keyed by parent, name and line
+  int slot_capacity;
+  int *frames;                     // node of the line each call depth is running
+  int current;                     // node the time since last_ns belongs to, -1 if none
+  long long last_ns;
+  long long start_ns;
+};
+
+struct program;
+
+// Function to start profiling the current interpreter, the lines outside of functions are named after the script
+void start_profile(const char *script);
+
+// Function to charge the time so far and start a line of the program running at a call depth
+void profile_line(struct program *program, int depth, int line);
+
+// Function to charge the time so far and start a built in function called at a call depth
+void profile_builtin(int function_type, int depth);
+
+// Function to charge the time so far and continue the line a call depth was running, nothing for depth -1
+void profile_resume(int depth);
+
+// Function to write the folded stacks to the script name with .folded appended, print the lines that took longest and stop profiling
+void finish_profile();
+
+// Set with --profile to profile every script
+extern int profile_enabled;
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "learnpi.h"
+#include "functions.h"
+#include "bytecode.h"
+#include "arena.h"
+#include "realtime.h"
+
+// Heap faulted in up front, later mallocs of the parser, the compiler and the heap of values reuse it
+#define REALTIME_HEAP_RESERVE (8 * 1024 * 1024)
+// Stack of script threads, the interpreter does not recurse to run a script so far less than the default is enough
+#define REALTIME_THREAD_STACK (1024 * 1024)
+// Part of each stack touched up front, the parser is the deepest user
+#define REALTIME_STACK_PREFAULT (256 * 1024)
+// Parse arena of each interpreter, room for the nodes of a large script
+#define REALTIME_ARENA_RESERVE (256 * 1024)
+
+int realtime_enabled = 0;
+int realtime_priority = REALTIME_DEFAULT_PRIORITY;
+int realtime_cpu = -1;
+
+// Function to write to every page of a block of memory so it is mapped before it is used
+static void touch_pages(volatile char *memory, size_t size) {
+  long page_size = sysconf(_SC_PAGESIZE);
+
+  for(size_t offset = 0; offset < size; offset += page_size) {
+    memory[offset] = 0;
+  }
+}
+
+// Function to fault in a block of heap and keep it in the process once it is freed, returns 0 if it cannot be allocated
+static int reserve_heap() {
+  char *reserve = NULL;
+
+  // Freed memory stays in the heap instead of going back to the kernel, and every thread allocates from the same heap
+  mallopt(M_TRIM_THRESHOLD, -1);
+  mallopt(M_MMAP_MAX, 0);
+  mallopt(M_ARENA_MAX, 1);
+
+  reserve = malloc(REALTIME_HEAP_RESERVE);
+
+  if(!reserve) {
+    return 0;
+  }
+
+  touch_pages(reserve, REALTIME_HEAP_RESERVE);
+  free(reserve);
+  return 1;
+}
+
+// Function to touch the stack of the calling thread, so the interpreter does not fault it in while a script runs
+void prefault_stack() {
+  volatile char stack[REALTIME_STACK_PREFAULT];
+
+  touch_pages(stack, sizeof(stack));
+}
+
+// Function to lock the memory of the process, pin it to the real-time cpu and schedule it at the real-time priority.
+// Every step that is not allowed prints a warning and the interpreter carries on without it.
+void enter_realtime(int scripts) {
+  struct sched_param parameters;
+  cpu_set_t cpus;
+  long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+  int cpu = realtime_cpu >= 0 ? realtime_cpu : cpu_count - 1;
+  // Scripts that share a cpu at one priority take turns, a busy loop would keep the others out under SCHED_FIFO
+  int policy = scripts > 1 ? SCHED_RR : SCHED_FIFO;
+
+  // Locking first makes the heap and stacks touched below stay in memory
+  if(mlockall(MCL_CURRENT | MCL_FUTURE)) {
+    fprintf(stderr, "Realtime: cannot lock memory (%s), continuing without.\n", strerror(errno));
+  }
+
+  // Without privileges the lock limit is small, locking every later allocation would make the interpreter run out of memory
+  if(!reserve_heap()) {
+    munlockall();
+    fprintf(stderr, "Realtime: cannot lock %d bytes of heap, continuing without locked memory.\n", REALTIME_HEAP_RESERVE);
+
+    if(!reserve_heap()) {
+      fprintf(stderr, "Realtime: cannot reserve %d bytes of heap, continuing without.\n", REALTIME_HEAP_RESERVE);
+    }
+  }
+
+  prefault_stack();
+
+  // Threads started later inherit the cpu and the scheduling of the main thread
+  if(cpu < 0 || cpu >= cpu_count) {
+    fprintf(stderr, "Realtime: there is no cpu %d, continuing on every cpu.\n", cpu);
+  } else {
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+
+    if(sched_setaffinity(0, sizeof(cpus), &cpus)) {
+      fprintf(stderr, "Realtime: cannot pin to cpu %d (%s), continuing on every cpu.\n", cpu, strerror(errno));
+    }
+  }
+
+  if(realtime_priority < sched_get_priority_min(policy) || realtime_priority > sched_get_priority_max(policy)) {
+    fprintf(stderr, "Realtime: priority %d is not between %d and %d, continuing with normal scheduling.\n",
+      realtime_priority, sched_get_priority_min(policy), sched_get_priority_max(policy));
+    return;
+  }
+
+  memset(&parameters, 0, sizeof(parameters));
+  parameters.sched_priority = realtime_priority;
+
+  if(sched_setscheduler(0, policy, &parameters)) {
+    fprintf(stderr, "Realtime: cannot switch to %s priority %d (%s), continuing with normal scheduling.\n",
+      policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR", realtime_priority, strerror(errno));
+  }
+}
+
+// Function to set the attributes of script threads, so their stacks are small enough to lock
+void realtime_thread_attributes(pthread_attr_t *attributes) {
+  pthread_attr_setstacksize(attributes, REALTIME_THREAD_STACK);
+  // Keep the scheduling of the main thread, not the default of the attributes
+  pthread_attr_setinheritsched(attributes, PTHREAD_INHERIT_SCHED);
+}
+
+// Function to allocate the stacks and the first parse arena of an interpreter before its script starts
+void preallocate_interpreter(struct interpreter_context *context) {
+  allocate_stacks(context);
+  touch_pages((char *)context->value_stack, VALUE_STACK_SIZE * sizeof(struct val));
+  touch_pages((char *)context->call_stack, CALL_STACK_SIZE * sizeof(struct call_frame));
+
+  context->parse_arena = arena_create();
+
+  if(!context->parse_arena || !arena_reserve(context->parse_arena, REALTIME_ARENA_RESERVE)) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  touch_pages((char *)context->parse_arena->head->data, REALTIME_ARENA_RESERVE);
+}
@@ -0,0 +1,34 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+// Priority of the interpreter threads when --realtime gives none, above the pigpio threads and below the kernel ones
+#define REALTIME_DEFAULT_PRIORITY 50
+
+struct interpreter_context;
+
+// Function to lock the memory of the process, pin it to the real-time cpu and schedule it at the real-time priority.
+// Every step that is not allowed prints a warning and the interpreter carries on without it.
+void enter_realtime(int scripts);
+
+// Function to set the attributes of script threads, so their stacks are small enough to lock
+void realtime_thread_attributes(pthread_attr_t *attributes);
+
+// Function to touch the stack of the calling thread, so the interpreter does not fault it in while a script runs
+void prefault_stack();
+
+// Function to allocate the stacks and the first parse arena of an interpreter before its script starts
+void preallocate_interpreter(struct interpreter_context *context);
+
+// Set with --realtime to run the scripts with a real-time priority
+extern int realtime_enabled;
+
+// Priority given with --realtime=, REALTIME_DEFAULT_PRIORITY if none
+extern int realtime_priority;
+
+// Cpu given with --cpu=, -1 for the last one
+extern int realtime_cpu;
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+// First bytes of a record file, the last digit is the version of the layout
+#define RECORD_MAGIC "LPIREC1"
+// Entries of the ring, a power of two, the newest ones overwrite the oldest
+#define RECORD_CAPACITY (1 << 20)
+
+// Calls the record backend records
+enum record_operation {
+  RECORD_MODE = 1,
+  RECORD_PULL,
+  RECORD_WRITE,
+  RECORD_READ,
+  RECORD_SERVO,                    // pulse width in microseconds, 0 stops the pulses
+  RECORD_WATCH,
+  RECORD_DELAY,                    // microseconds slept for, gpio 0
+  RECORD_WAVE_SEND,                // times of the pattern
+  RECORD_WAVE_STOP
+};
+
+// Structure for the start of a record file, the ring of entries follows it
+struct record_header {
+  char magic[8];
+  uint32_t entry_size;
+  uint32_t capacity;
+  _Atomic uint64_t head;           // entries ever written, the next one goes to head % capacity
+  uint8_t reserved[40];
+};
+
+// Structure for one recorded call, 16 bytes so four share a cache line
+struct record_entry {
+  uint64_t time_ns;                // CLOCK_MONOTONIC, or the virtual time of the script on a simulated backend
+  uint32_t value;
+  uint8_t gpio;
+  uint8_t operation;
+  _Atomic uint16_t lap;            // index / capacity of the entry, written last so a torn entry can be told apart
+};
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "learnpi.h"
+#include "backend.h"
+#include "record.h"
+
+const char *record_path = "learnpi.record";
+
+// Mapped record file, written by every thread that drives a gpio without a lock
+static struct record_header *record_header = NULL;
+static struct record_entry *record_entries = NULL;
+static size_t record_size = 0;
+
+// Function to write one call to the ring, a clock read, an atomic add and a few stores.
+// A simulated backend only moves the virtual clock of the script, so its calls take that time.
+static inline void record(int operation, unsigned gpio, uint32_t value) {
+  struct record_entry *entry = NULL;
+  struct timespec now;
+  uint64_t time_ns = 0;
+  uint64_t index = 0;
+
+  if(recorded_backend->simulated) {
+    time_ns = recorded_backend->now_us() * 1000;
+  } else {
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    time_ns = now.tv_sec * 1000000000ULL + now.tv_nsec;
+  }
+
+  index = atomic_fetch_add_explicit(&record_header->head, 1, memory_order_relaxed);
+  entry = &record_entries[index & (RECORD_CAPACITY - 1)];
+
+  entry->time_ns = time_ns;
+  entry->value = value;
+  entry->gpio = gpio;
+  entry->operation = operation;
+  atomic_store_explicit(&entry->lap, (uint16_t)(index / RECORD_CAPACITY), memory_order_release);
+}
+
+// Function to map the record file before the recorded backend starts.
+// Every page is written once now, so recording a call does not take a page fault.
+static int record_init() {
+  int file = open(record_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  void *mapped = NULL;
+
+  if(file < 0) {
+    perror(record_path);
+    return -1;
+  }
+
+  record_size = sizeof(struct record_header) + RECORD_CAPACITY * sizeof(struct record_entry);
+
+  if(ftruncate(file, record_size) != 0) {
+    perror(record_path);
+    close(file);
+    return -1;
+  }
+
+  mapped = mmap(NULL, record_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, file, 0);
+  close(file);
+
+  if(mapped == MAP_FAILED) {
+    perror(record_path);
+    return -1;
+  }
+
+  // Populating a shared mapping only maps the pages for reading, the first write of each would still fault
+  for(size_t offset = 0; offset < record_size; offset += 4096) {
+    ((volatile char *)mapped)[offset] = 0;
+  }
+
+  // The mapping starts zeroed, so every entry is at lap 0 with operation 0 until it is written
+  record_header = mapped;
+  record_entries = (struct record_entry *)(record_header + 1);
+  memcpy(record_header->magic, RECORD_MAGIC, sizeof(RECORD_MAGIC));
+  record_header->entry_size = sizeof(struct record_entry);
+  record_header->capacity = RECORD_CAPACITY;
+  atomic_init(&record_header->head, 0);
+
+  return recorded_backend->init();
+}
+
+// Function to stop the recorded backend and unmap the record, the kernel writes it out even if the process crashes
+static void record_terminate() {
+  recorded_backend->terminate();
+  munmap(record_header, record_size);
+  record_header = NULL;
+  record_entries = NULL;
+}
+
+static int record_set_mode(unsigned gpio, unsigned mode) {
+  record(RECORD_MODE, gpio, mode);
+  return recorded_backend->set_mode(gpio, mode);
+}
+
+static int record_set_pull(unsigned gpio, unsigned pull) {
+  record(RECORD_PULL, gpio, pull);
+  return recorded_backend->set_pull(gpio, pull);
+}
+
+static int record_write(unsigned gpio, unsigned level) {
+  record(RECORD_WRITE, gpio, level);
+  return recorded_backend->write(gpio, level);
+}
+
+// Function to record the writes of both banks one gpio at a time, only the bits that are set are visited
+static int record_write_banks(const uint32_t *set, const uint32_t *clear) {
+  uint32_t bits = 0;
+  int bit = 0;
+
+  for(unsigned bank = 0; bank < 2; bank++) {
+    for(bits = set[bank]; bits; bits &= bits - 1) {
+      bit = __builtin_ctz(bits);
+      record(RECORD_WRITE, bank * 32 + bit, 1);
+    }
+
+    for(bits = clear[bank] & ~set[bank]; bits; bits &= bits - 1) {
+      bit = __builtin_ctz(bits);
+      record(RECORD_WRITE, bank * 32 + bit, 0);
+    }
+  }
+
+  return recorded_backend->write_banks(set, clear);
+}
+
+static int record_read(unsigned gpio) {
+  int level = recorded_backend->read(gpio);
+
+  record(RECORD_READ, gpio, level);
+  return level;
+}
+
+static int record_servo(unsigned gpio, unsigned width_us) {
+  record(RECORD_SERVO, gpio, width_us);
+  return recorded_backend->servo(gpio, width_us);
+}
+
+static int record_watch(unsigned gpio, gpio_alert_function alert) {
+  record(RECORD_WATCH, gpio, 0);
+  return recorded_backend->watch(gpio, alert);
+}
+
+static uint64_t record_now_us() {
+  return recorded_backend->now_us();
+}
+
+// Delays are recorded with the time they sleep for, the next call shows when they ended
+static void record_sleep_until(uint64_t deadline_us) {
+  uint64_t now_us = recorded_backend->now_us();
+
+  record(RECORD_DELAY, 0, deadline_us > now_us ? deadline_us - now_us : 0);
+  recorded_backend->sleep_until(deadline_us);
+}
+
+static void record_delay(unsigned us) {
+  record(RECORD_DELAY, 0, us);
+  recorded_backend->delay(us);
+}
+
+static uint32_t record_tick() {
+  return recorded_backend->tick();
+}
+
+static int record_wave_send(struct pattern_playback *pattern) {
+  record(RECORD_WAVE_SEND, pattern->gpio, pattern->step_count);
+  return recorded_backend->wave_send(pattern);
+}
+
+static int record_wave_busy() {
+  return recorded_backend->wave_busy();
+}
+
+static void record_wave_stop() {
+  record(RECORD_WAVE_STOP, 0, 0);
+  recorded_backend->wave_stop();
+}
+
+static void record_wave_delete(int wave_id) {
+  recorded_backend->wave_delete(wave_id);
+}
+
+// The simulated flag follows the recorded backend, select_backend sets it
+struct gpio_backend record_backend = {
+  .name = "record",
+  .simulated = 1,
+  .init = record_init,
+  .terminate = record_terminate,
+  .set_mode = record_set_mode,
+  .set_pull = record_set_pull,
+  .write = record_write,
+  .write_banks = record_write_banks,
+  .read = record_read,
+  .servo = record_servo,
+  .watch = record_watch,
+  .now_us = record_now_us,
+  .sleep_until = record_sleep_until,
+  .delay = record_delay,
+  .tick = record_tick,
+  .wave_send = record_wave_send,
+  .wave_busy = record_wave_busy,
+  .wave_stop = record_wave_stop,
+  .wave_delete = record_wave_delete,
+};
@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "learnpi.h"
+#include "functions.h"
+
+// Structure for the frame slots of the function being resolved
+struct frame_layout {
+  char **names;    // the parameters first, then the locals in the order they are declared
+  int count;
+  int capacity;
+};
+
+// Function to find the frame slot of a name, -1 if the name is not a parameter or a local declared so far
+static int frame_slot(struct frame_layout *layout, char *name) {
+  if(!layout) {
+    return -1;
+  }
+
+  // A later declaration of the same name shadows the earlier one
+  for(int slot = layout->count - 1; slot >= 0; slot--) {
+    if(!strcmp(layout->names[slot], name)) {
+      return slot;
+    }
+  }
+
+  return -1;
+}
+
+// Function to add a frame slot for a name, returns the slot
+static int add_frame_slot(struct frame_layout *layout, char *name) {
+  if(layout->count == layout->capacity) {
+    layout->capacity = layout->capacity ? layout->capacity * 2 : 8;
+    layout->names = realloc(layout->names, layout->capacity * sizeof(char *));
+
+    if(!layout->names) {
+      yyerror("out of space");
+      exit(0);
+    }
+  }
+
+  layout->names[layout->count] = name;
+  return layout->count++;
+}
+
+// Function to bind a name to its frame slot inside a function, else to its symbol table slot
+static void resolve_name(char *name, struct frame_layout *layout, int *scope, int *slot) {
+  int local_slot = frame_slot(layout, name);
+
+  if(local_slot >= 0) {
+    *scope = LOCAL_SLOT;
+    *slot = local_slot;
+  } else {
+    *scope = GLOBAL_SLOT;
+    *slot = lookup(name) - current_context->symtab;
+  }
+}
+
+// Function to bind a declared name, declarations inside a function get a frame slot of their own
+static void resolve_declaration(char *name, struct frame_layout *layout, int *scope, int *slot) {
+  if(layout) {
+    *scope = LOCAL_SLOT;
+    *slot = add_frame_slot(layout, name);
+  } else {
+    *scope = GLOBAL_SLOT;
+    *slot = lookup(name) - current_context->symtab;
+  }
+}
+
+static void resolve_node(struct ast *abstract_syntax_tree, struct frame_layout *layout);
+
+// Function to resolve every argument of an argument list
+static void resolve_arguments(struct ast *args, struct frame_layout *layout) {
+  while(args) {
+    if(args->nodetype == STATEMENT_LIST) {
+      resolve_node(args->l, layout);
+      args = args->r;
+    } else {
+      resolve_node(args, layout);
+      args = NULL;
+    }
+  }
+}
+
+// Function to bind the variables of an AST to global or frame slots, in the order they run
+static void resolve_node(struct ast *abstract_syntax_tree, struct frame_layout *layout) {
+  struct symbol_reference *symbol_reference = NULL;
+  struct assign_symbol *assign_symbol = NULL;
+  struct declare_symbol *declare_symbol = NULL;
+  struct assign_and_declare_symbol *assign_and_declare_symbol = NULL;
+  struct assign_and_declare_complex_symbol *assign_and_declare_complex_symbol = NULL;
+  struct user_function_call *user_function_call = NULL;
+
+  if(!abstract_syntax_tree) {
+    return;
+  }
+
+  switch(abstract_syntax_tree->nodetype) {
+    case CONSTANT:
+      break;
+
+    case NEW_REFERENCE:
+      symbol_reference = (struct symbol_reference *)abstract_syntax_tree;
+      resolve_name(symbol_reference->s, layout, &symbol_reference->scope, &symbol_reference->slot);
+      break;
+
+    case ASSIGNMENT:
+      assign_symbol = (struct assign_symbol *)abstract_syntax_tree;
+      resolve_node(assign_symbol->v, layout);
+
+      // TYPE NAME = value declares the name, like TYPE NAME does
+      if(assign_symbol->declared) {
+        resolve_declaration(assign_symbol->s, layout, &assign_symbol->scope, &assign_symbol->slot);
+      } else {
+        resolve_name(assign_symbol->s, layout, &assign_symbol->scope, &assign_symbol->slot);
+      }
+      break;
+
+    case '+':
+    case '-':
+    case '*':
+    case '/':
+    case LOGICAL_AND:
+    case LOGICAL_OR:
+    case '1':  case '2':  case '3':  case '4':  case '5':  case '6':
+    case STATEMENT_LIST:
+      resolve_node(abstract_syntax_tree->l, layout);
+      resolve_node(abstract_syntax_tree->r, layout);
+      break;
+
+    case '|':
+    case UNARY_MINUS:
+      resolve_node(abstract_syntax_tree->l, layout);
+      break;
+
+    case IF_STATEMENT:
+    case LOOP_STATEMENT:
+      resolve_node(((struct flow *)abstract_syntax_tree)->condition, layout);
+      resolve_node(((struct flow *)abstract_syntax_tree)->then_list, layout);
+      resolve_node(((struct flow *)abstract_syntax_tree)->else_list, layout);
+      break;
+
+    case FOR_STATEMENT:
+      resolve_node(((struct for_flow *)abstract_syntax_tree)->initialization, layout);
+      resolve_node(((struct for_flow *)abstract_syntax_tree)->condition, layout);
+      resolve_node(((struct for_flow *)abstract_syntax_tree)->then_list, layout);
+      resolve_node(((struct for_flow *)abstract_syntax_tree)->else_list, layout);
+      break;
+
+    case BUILTIN_TYPE:
+      resolve_arguments(((struct builtin_function_call *)abstract_syntax_tree)->argument_list, layout);
+      break;
+
+    case USER_CALL:
+      user_function_call = (struct user_function_call *)abstract_syntax_tree;
+      resolve_arguments(user_function_call->argument_list, layout);
+
+      // Functions always live in the symbol table
+      user_function_call->scope = GLOBAL_SLOT;
+      user_function_call->slot = lookup(user_function_call->s) - current_context->symtab;
+      break;
+
+    case DECLARATION:
+      declare_symbol = (struct declare_symbol *)abstract_syntax_tree;
+      resolve_declaration(declare_symbol->s, layout, &declare_symbol->scope, &declare_symbol->slot);
+      break;
+
+    case DECLARATION_WITH_ASSIGNMENT:
+      assign_and_declare_symbol = (struct assign_and_declare_symbol *)abstract_syntax_tree;
+      resolve_node(assign_and_declare_symbol->value, layout);
+      resolve_declaration(assign_and_declare_symbol->s, layout, &assign_and_declare_symbol->scope, &assign_and_declare_symbol->slot);
+      break;
+
+    case COMPLEX_ASSIGNMENT:
+      assign_and_declare_complex_symbol = (struct assign_and_declare_complex_symbol *)abstract_syntax_tree;
+      resolve_arguments(assign_and_declare_complex_symbol->value, layout);
+      resolve_declaration(assign_and_declare_complex_symbol->s, layout, &assign_and_declare_complex_symbol->scope, &assign_and_declare_complex_symbol->slot);
+      break;
+
+    default:
+      yyerror("internal error: resolve bad node %d\n", abstract_syntax_tree->nodetype);
+      break;
+  }
+}
+
+// Function to bind the variables of a top-level statement to symbol table slots
+void resolve(struct ast *abstract_syntax_tree) {
+  resolve_node(abstract_syntax_tree, NULL);
+}
+
+// Function to bind the parameters and declared locals of a function body to frame slots, returns the frame size
+int resolve_function(struct ast *body, struct symbol_list *parameters) {
+  struct frame_layout layout = { NULL, 0, 0 };
+
+  for(; parameters; parameters = parameters->next) {
+    add_frame_slot(&layout, parameters->sym);
+  }
+
+  resolve_node(body, &layout);
+  free(layout.names);
+
+  return layout.count;
+}
@@ -0,0 +1,374 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "learnpi.h"
+#include "backend.h"
+#include "servo.h"
+
+// Share of a move spent speeding up, and again slowing down, the rest runs at the top speed
+#define SERVO_RAMP 0.25
+#define SERVO_UPDATE_NS (1000000000ULL / SERVO_UPDATE_HZ)
+
+static struct servo_motion servos[MAX_GPIO];
+
+// Set once the servo thread runs, without it moves jump to their end.
+// The simulation backend has no servo thread, it steps moves on the virtual clock of the script.
+static int smooth_moves = 0;
+static pthread_mutex_t servo_lock = PTHREAD_MUTEX_INITIALIZER;
+// Signalled when a move starts, the servo thread sleeps on it while nothing moves
+static pthread_cond_t servo_started = PTHREAD_COND_INITIALIZER;
+// Signalled when a move ends, scripts that end wait on it for their moves
+static pthread_cond_t servo_finished = PTHREAD_COND_INITIALIZER;
+
+// Function to read the clock moves are timed on, the virtual clock of the script with the simulation backend
+static uint64_t servo_now_ns() {
+  struct timespec now;
+
+  if(gpio_backend->simulated) {
+    return virtual_time_us() * 1000;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+// Function to find the width a move has reached at a time, the velocity rises, holds and falls like a trapezoid
+static int move_width(struct servo_motion *servo, uint64_t now_ns) {
+  // Top speed that covers the distance once the ramps take their share
+  double top_speed = 1.0 / (1.0 - SERVO_RAMP);
+  double acceleration = top_speed / SERVO_RAMP;
+  double t = 0;
+  double part = 0;
+
+  if(!servo->moving || now_ns >= servo->start_ns + servo->duration_ns) {
+    return servo->to_us;
+  }
+
+  t = (double)(now_ns - servo->start_ns) / servo->duration_ns;
+
+  if(t < SERVO_RAMP) {
+    part = acceleration * t * t / 2;
+  } else if(t <= 1.0 - SERVO_RAMP) {
+    part = acceleration * SERVO_RAMP * SERVO_RAMP / 2 + top_speed * (t - SERVO_RAMP);
+  } else {
+    part = 1.0 - acceleration * (1.0 - t) * (1.0 - t) / 2;
+  }
+
+  return servo->from_us + (int)((servo->to_us - servo->from_us) * part + 0.5);
+}
+
+// Function to send a pulse width to a servo, the caller holds the servo lock
+static int send_width(unsigned gpio, int width_us) {
+  servos[gpio].pulse_us = width_us;
+
+  return gpio_backend->servo(gpio, width_us);
+}
+
+// Function to step the moving servos at a steady rate, the start routine of the servo thread
+static void *servo_thread(void *argument) {
+  struct timespec next;
+  uint64_t now_ns = 0;
+  int width_us = 0;
+  int moving = 0;
+
+  (void)argument;
+
+  // A move can start before the thread first sleeps, so the updates are timed from now
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  pthread_mutex_lock(&servo_lock);
+
+  for(;;) {
+    moving = 0;
+    now_ns = servo_now_ns();
+
+    for(unsigned gpio = 0; gpio < MAX_GPIO; gpio++) {
+      if(!servos[gpio].moving) {
+        continue;
+      }
+
+      width_us = move_width(&servos[gpio], now_ns);
+
+      if(width_us != servos[gpio].pulse_us) {
+        send_width(gpio, width_us);
+      }
+
+      if(now_ns >= servos[gpio].start_ns + servos[gpio].duration_ns) {
+        servos[gpio].moving = 0;
+        pthread_cond_broadcast(&servo_finished);
+      } else {
+        moving = 1;
+      }
+    }
+
+    if(!moving) {
+      pthread_cond_wait(&servo_started, &servo_lock);
+      clock_gettime(CLOCK_MONOTONIC, &next);
+      continue;
+    }
+
+    pthread_mutex_unlock(&servo_lock);
+
+    // Updates keep their rate however long sending the widths took
+    next.tv_nsec += SERVO_UPDATE_NS;
+
+    if(next.tv_nsec >= 1000000000) {
+      next.tv_sec++;
+      next.tv_nsec -= 1000000000;
+    }
+
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR);
+
+    pthread_mutex_lock(&servo_lock);
+  }
+
+  return NULL;
+}
+
+// Function to start the servo thread, run once when the first servo is declared
+static void start_servo_thread() {
+  pthread_t thread;
+
+  if(pthread_create(&thread, NULL, servo_thread, NULL) != 0) {
+    fprintf(stderr, "Cannot start the servo thread, servos move at once.\n");
+    return;
+  }
+
+  pthread_detach(thread);
+  smooth_moves = 1;
+}
+
+static pthread_once_t servo_thread_started = PTHREAD_ONCE_INIT;
+
+// Function to send the widths the moves of the current interpreter reach up to a virtual time, the caller holds the servo lock
+static void step_servos(uint64_t until_ns) {
+  struct servo_motion *servo = NULL;
+  uint64_t end_ns = 0;
+  int width_us = 0;
+
+  for(unsigned gpio = 0; gpio < MAX_GPIO; gpio++) {
+    servo = &servos[gpio];
+
+    if(servo->owner != current_context || !servo->moving) {
+      continue;
+    }
+
+    end_ns = servo->start_ns + servo->duration_ns;
+
+    // One update per period like the servo thread, the last one lands on the end of the move
+    while(servo->moving && servo->next_update_ns <= until_ns) {
+      if(servo->next_update_ns >= end_ns) {
+        servo->next_update_ns = end_ns;
+        servo->moving = 0;
+      }
+
+      width_us = move_width(servo, servo->next_update_ns);
+
+      if(width_us != servo->pulse_us) {
+        send_width(gpio, width_us);
+      }
+
+      servo->next_update_ns += SERVO_UPDATE_NS;
+    }
+  }
+}
+
+// Function to calibrate a servo on a gpio and hold it at 0 degrees, returns 0 if OK or a pigpio error
+int attach_servo(unsigned gpio, int min_us, int max_us) {
+  int status = 0;
+
+  if(gpio >= MAX_GPIO) {
+    return PI_BAD_USER_GPIO;
+  }
+
+  if(gpio_backend->simulated) {
+    smooth_moves = 1;
+  } else {
+    pthread_once(&servo_thread_started, start_servo_thread);
+  }
+
+  pthread_mutex_lock(&servo_lock);
+  servos[gpio].owner = current_context;
+  servos[gpio].min_us = min_us;
+  servos[gpio].max_us = max_us;
+  servos[gpio].moving = 0;
+  status = send_width(gpio, min_us);
+  pthread_mutex_unlock(&servo_lock);
+
+  return status;
+}
+
+// Function to start moving a servo to an angle in a number of milliseconds, 0 moves at once.
+// The move runs on the servo thread and the script goes on. Returns 0 if OK or a pigpio error.
+int move_servo(unsigned gpio, int angle, int duration_ms) {
+  struct servo_motion *servo = NULL;
+  uint64_t now_ns = servo_now_ns();
+  int status = 0;
+
+  if(gpio >= MAX_GPIO) {
+    return PI_BAD_USER_GPIO;
+  }
+
+  servo = &servos[gpio];
+  pthread_mutex_lock(&servo_lock);
+
+  if(gpio_backend->simulated) {
+    step_servos(now_ns);
+  }
+
+  // A move that starts during another one starts from where the servo is
+  servo->from_us = servo->moving ? move_width(servo, now_ns) : servo->pulse_us;
+  servo->to_us = servo->min_us + (servo->max_us - servo->min_us) * angle / SERVO_MAX_ANGLE;
+  servo->start_ns = now_ns;
+  servo->duration_ns = duration_ms * 1000000ULL;
+  servo->next_update_ns = now_ns;
+  servo->moving = 0;
+
+  // The pulses were off, there is no position to move from
+  if(duration_ms == 0 || servo->from_us == 0 || !smooth_moves) {
+    status = send_width(gpio, servo->to_us);
+  } else {
+    servo->moving = 1;
+    pthread_cond_signal(&servo_started);
+  }
+
+  pthread_mutex_unlock(&servo_lock);
+  return status;
+}
+
+// Function to drive a continuous rotation servo at full speed, returns 0 if OK or a pigpio error
+int spin_servo(unsigned gpio) {
+  int status = 0;
+
+  if(gpio >= MAX_GPIO) {
+    return PI_BAD_USER_GPIO;
+  }
+
+  pthread_mutex_lock(&servo_lock);
+  servos[gpio].moving = 0;
+  status = send_width(gpio, servos[gpio].max_us);
+  pthread_mutex_unlock(&servo_lock);
+
+  return status;
+}
+
+// Function to stop the move and the pulses of a servo, returns 0 if OK or a pigpio error
+int stop_servo(unsigned gpio) {
+  int status = 0;
+
+  if(gpio >= MAX_GPIO) {
+    return PI_BAD_USER_GPIO;
+  }
+
+  pthread_mutex_lock(&servo_lock);
+
+  if(gpio_backend->simulated) {
+    step_servos(servo_now_ns());
+  }
+
+  servos[gpio].moving = 0;
+  status = send_width(gpio, 0);
+  pthread_cond_broadcast(&servo_finished);
+  pthread_mutex_unlock(&servo_lock);
+
+  return status;
+}
+
+// Function to wait until the servos of the current interpreter reach the end of their moves and release them
+void finish_servo_moves() {
+  pthread_mutex_lock(&servo_lock);
+
+  if(gpio_backend->simulated) {
+    uint64_t end_ns = 0;
+
+    for(unsigned gpio = 0; gpio < MAX_GPIO; gpio++) {
+      if(servos[gpio].owner == current_context && servos[gpio].moving && servos[gpio].start_ns + servos[gpio].duration_ns > end_ns) {
+        end_ns = servos[gpio].start_ns + servos[gpio].duration_ns;
+      }
+    }
+
+    // The virtual clock runs to the end of the last move, the updates are written on the way
+    pthread_mutex_unlock(&servo_lock);
+
+    if(end_ns / 1000 > virtual_time_us()) {
+      advance_virtual_time(end_ns / 1000 - virtual_time_us());
+    }
+
+    pthread_mutex_lock(&servo_lock);
+    step_servos(end_ns);
+  } else {
+    int moving = 1;
+
+    while(moving) {
+      moving = 0;
+
+      for(unsigned gpio = 0; gpio < MAX_GPIO; gpio++) {
+        if(servos[gpio].owner == current_context && servos[gpio].moving) {
+          moving = 1;
+        }
+      }
+
+      if(moving) {
+        pthread_cond_wait(&servo_finished, &servo_lock);
+      }
+    }
+  }
+
+  // The pins go back to the other scripts
+  for(unsigned gpio = 0; gpio < MAX_GPIO; gpio++) {
+    if(servos[gpio].owner == current_context) {
+      servos[gpio].owner = NULL;
+    }
+  }
+
+  pthread_mutex_unlock(&servo_lock);
+}
+
+// Function to find the virtual time of the next update of a moving servo of the current interpreter, UINT64_MAX if there is none
+uint64_t next_servo_update_us() {
+  uint64_t next_ns = UINT64_MAX;
+  uint64_t update_ns = 0;
+
+  if(!gpio_backend->simulated) {
+    return UINT64_MAX;
+  }
+
+  pthread_mutex_lock(&servo_lock);
+
+  for(unsigned gpio = 0; gpio < MAX_GPIO; gpio++) {
+    if(servos[gpio].owner != current_context || !servos[gpio].moving) {
+      continue;
+    }
+
+    // The last update lands on the end of the move
+    update_ns = servos[gpio].next_update_ns;
+
+    if(update_ns > servos[gpio].start_ns + servos[gpio].duration_ns) {
+      update_ns = servos[gpio].start_ns + servos[gpio].duration_ns;
+    }
+
+    if(update_ns < next_ns) {
+      next_ns = update_ns;
+    }
+  }
+
+  pthread_mutex_unlock(&servo_lock);
+
+  return next_ns == UINT64_MAX ? UINT64_MAX : (next_ns + 999) / 1000;
+}
+
+// Function to send the updates of the moving servos up to a virtual time through the simulated backend
+void render_servos(uint64_t until_us) {
+  if(!gpio_backend->simulated) {
+    return;
+  }
+
+  pthread_mutex_lock(&servo_lock);
+  step_servos(until_us * 1000);
+  pthread_mutex_unlock(&servo_lock);
+}
@@ -0,0 +1,50 @@
+#ifndef SERVO_H
+#define SERVO_H
+
+#include <stdint.h>
+
+// Pulse widths gpioServo accepts, a SERVO_MOTOR is calibrated inside them
+#define SERVO_MIN_PULSE_US 500
+#define SERVO_MAX_PULSE_US 2500
+// Angles are degrees, the calibrated widths are the two ends
+#define SERVO_MAX_ANGLE 180
+// Updates of moving servos per second, the rate of the pulses of hobby servos
+#define SERVO_UPDATE_HZ 50
+
+// Structure for the calibration and the motion of a servo on one gpio
+struct servo_motion {
+  void *owner;                     // interpreter that declared the servo, NULL if none
+  int min_us;                      // pulse width at 0 degrees
+  int max_us;                      // pulse width at SERVO_MAX_ANGLE degrees
+  int pulse_us;                    // width sent last, 0 when the pulses are off
+  int moving;
+  int from_us;                     // a move goes from one width to another with a trapezoidal velocity
+  int to_us;
+  uint64_t start_ns;
+  uint64_t duration_ns;
+  uint64_t next_update_ns;         // virtual time of the next update of a move with the simulation backend
+};
+
+// Function to calibrate a servo on a gpio and hold it at 0 degrees, returns 0 if OK or a pigpio error
+int attach_servo(unsigned gpio, int min_us, int max_us);
+
+// Function to start moving a servo to an angle in a number of milliseconds, 0 moves at once.
+// The move runs on the servo thread and the script goes on. Returns 0 if OK or a pigpio error.
+int move_servo(unsigned gpio, int angle, int duration_ms);
+
+// Function to drive a continuous rotation servo at full speed, returns 0 if OK or a pigpio error
+int spin_servo(unsigned gpio);
+
+// Function to stop the move and the pulses of a servo, returns 0 if OK or a pigpio error
+int stop_servo(unsigned gpio);
+
+// Function to wait until the servos of the current interpreter reach the end of their moves and release them
+void finish_servo_moves();
+
+// Function to find the virtual time of the next update of a moving servo of the current interpreter, UINT64_MAX if there is none
+uint64_t next_servo_update_us();
+
+// Function to send the updates of the moving servos up to a virtual time through the simulated backend
+void render_servos(uint64_t until_us);
+
+#endif
@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "learnpi.h"
+#include "backend.h"
+#include "trace.h"
+
+// Milliseconds between simulated presses, set with LEARNPI_SIM_PRESS_MS
+#define SIMULATED_PRESS_PERIOD_MS 1000
+#define SIMULATED_PRESS_LENGTH_MS 50
+
+// Period of the simulated presses in microseconds of virtual time
+static uint64_t press_period_us = SIMULATED_PRESS_PERIOD_MS * 1000ULL;
+
+// Function to read the period of the simulated presses
+static int sim_init() {
+  char *setting = getenv("LEARNPI_SIM_PRESS_MS");
+
+  if(setting && atoi(setting) > SIMULATED_PRESS_LENGTH_MS) {
+    press_period_us = atoi(setting) * 1000ULL;
+  }
+
+  return 0;
+}
+
+static void sim_terminate() {
+}
+
+// Function to find the first simulated edge to level after a virtual time.
+// Every watched button is pressed for the last SIMULATED_PRESS_LENGTH_MS of each period.
+uint64_t next_simulated_edge(int level, uint64_t after_us) {
+  uint64_t first_us = level ? press_period_us : press_period_us - SIMULATED_PRESS_LENGTH_MS * 1000ULL;
+
+  if(after_us < first_us) {
+    return first_us;
+  }
+
+  return first_us + ((after_us - first_us) / press_period_us + 1) * press_period_us;
+}
+
+// Function to find the first simulated button press after a virtual time, keypads of the simulation are pressed then too
+uint64_t next_simulated_press(uint64_t after_us) {
+  // The buttons are pulled up, a press is an edge to level 0
+  return next_simulated_edge(0, after_us);
+}
+
+// Function to tell if a button is pressed at a virtual time of the simulation
+int simulated_level(uint64_t now_us) {
+  return now_us % press_period_us < press_period_us - SIMULATED_PRESS_LENGTH_MS * 1000ULL;
+}
+
+// Pins keep whatever mode and pull they are given, the simulated inputs do not depend on them
+static int sim_set_mode(unsigned gpio, unsigned mode) {
+  (void)gpio;
+  (void)mode;
+  return 0;
+}
+
+static int sim_set_pull(unsigned gpio, unsigned pull) {
+  (void)gpio;
+  (void)pull;
+  return 0;
+}
+
+static int sim_write(unsigned gpio, unsigned level) {
+  trace(TRACE_INFO, "Simulated gpioWrite on gpio %u to %u at %llu us.\n", gpio, level, (unsigned long long)virtual_time_us());
+  return 0;
+}
+
+static int sim_write_banks(const uint32_t *set, const uint32_t *clear) {
+  trace(TRACE_INFO, "Simulated gpioWrite_Bits set 0x%08x%08x clear 0x%08x%08x at %llu us.\n",
+    set[1], set[0], clear[1], clear[0], (unsigned long long)virtual_time_us());
+  return 0;
+}
+
+// Every input reads like a button that is pressed at the simulated press times
+static int sim_read(unsigned gpio) {
+  (void)gpio;
+  return simulated_level(virtual_time_us());
+}
+
+static int sim_servo(unsigned gpio, unsigned width_us) {
+  trace(TRACE_INFO, "Simulated gpioServo on gpio %u to %u us at %llu us.\n", gpio, width_us, (unsigned long long)virtual_time_us());
+  return 0;
+}
+
+// The simulated edges follow the virtual clock of each script, nothing calls the alert function
+static int sim_watch(unsigned gpio, gpio_alert_function alert) {
+  (void)alert;
+  trace(TRACE_INFO, "Simulated gpioSetAlertFunc on gpio %u.\n", gpio);
+  return 0;
+}
+
+static uint64_t sim_now_us() {
+  return virtual_time_us();
+}
+
+// Function to move the virtual clock to a deadline instead of sleeping
+static void sim_sleep_until(uint64_t deadline_us) {
+  uint64_t now_us = virtual_time_us();
+
+  if(deadline_us > now_us) {
+    advance_virtual_time(deadline_us - now_us);
+  }
+}
+
+static void sim_delay(unsigned us) {
+  advance_virtual_time(us);
+}
+
+static uint32_t sim_tick() {
+  return (uint32_t)virtual_time_us();
+}
+
+// Pattern the simulated transmitter was last given, NULL once it is stopped
+static struct pattern_playback *sent_pattern = NULL;
+
+// The edges of the pattern are drawn on the virtual timeline as the clock moves, see render_pattern
+static int sim_wave_send(struct pattern_playback *pattern) {
+  trace(TRACE_INFO, "Simulated gpioWaveTxSend of %d times on gpio %u, %d repeats, at %llu us.\n",
+    pattern->step_count, pattern->gpio, pattern->repeats, (unsigned long long)pattern->started_us);
+  sent_pattern = pattern;
+  return 0;
+}
+
+// Scripts start together on clocks of their own, so the pattern of another script has ended
+// once the clock of the caller passes the end of its last repeat. The caller holds the pattern lock.
+static int sim_wave_busy() {
+  if(!sent_pattern) {
+    return 0;
+  }
+
+  if(!sent_pattern->repeats) {
+    return 1;
+  }
+
+  return virtual_time_us() < sent_pattern->started_us + sent_pattern->period_us * sent_pattern->repeats;
+}
+
+static void sim_wave_stop() {
+  trace(TRACE_INFO, "Simulated gpioWaveTxStop at %llu us.\n", (unsigned long long)virtual_time_us());
+  sent_pattern = NULL;
+}
+
+static void sim_wave_delete(int wave_id) {
+  (void)wave_id;
+}
+
+struct gpio_backend sim_backend = {
+  .name = "sim",
+  .simulated = 1,
+  .init = sim_init,
+  .terminate = sim_terminate,
+  .set_mode = sim_set_mode,
+  .set_pull = sim_set_pull,
+  .write = sim_write,
+  .write_banks = sim_write_banks,
+  .read = sim_read,
+  .servo = sim_servo,
+  .watch = sim_watch,
+  .now_us = sim_now_us,
+  .sleep_until = sim_sleep_until,
+  .delay = sim_delay,
+  .tick = sim_tick,
+  .wave_send = sim_wave_send,
+  .wave_busy = sim_wave_busy,
+  .wave_stop = sim_wave_stop,
+  .wave_delete = sim_wave_delete,
+};
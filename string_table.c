@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "learnpi.h"
+#include "functions.h"
+#include "string_table.h"
+
+// Function to get the header in front of the characters of a string
+struct string_header *string_header_of(char *characters) {
+  return (struct string_header *)(characters - offsetof(struct string_header, characters));
+}
+
+// Function to hash the characters of a string
+static uint32_t hash_characters(const char *characters, size_t length) {
+  uint32_t hash = 2166136261u;
+
+  for(size_t i = 0; i < length; i++) {
+    hash = (hash ^ (unsigned char)characters[i]) * 16777619u;
+  }
+
+  return hash;
+}
+
+// Function to allocate a string with room for capacity characters and the terminator
+static struct string_header *allocate_string(size_t capacity) {
+  return heap_alloc(sizeof(struct string_header) + capacity + 1);
+}
+
+// Function to double the slots of the interned strings
+static void grow_string_table(struct string_table *table) {
+  size_t capacity = table->capacity ? table->capacity * 2 : 64;
+  char **slots = calloc(capacity, sizeof(char *));
+  char *characters = NULL;
+  size_t slot = 0;
+
+  if(!slots) {
+    yyerror("out of space");
+    exit(0);
+  }
+
+  for(size_t i = 0; i < table->capacity; i++) {
+    characters = table->slots[i];
+
+    if(!characters) {
+      continue;
+    }
+
+    slot = string_header_of(characters)->hash & (capacity - 1);
+    while(slots[slot]) slot = (slot + 1) & (capacity - 1);
+    slots[slot] = characters;
+  }
+
+  free(table->slots);
+  table->slots = slots;
+  table->capacity = capacity;
+}
+
+// Function to get the single copy of a string constant, equal strings get the same pointer
+char *intern_string(const char *characters, size_t length) {
+  struct string_table *table = &current_context->strings;
+  struct string_header *header = NULL;
+  uint32_t hash = hash_characters(characters, length);
+  size_t slot = 0;
+
+  if((table->count + 1) * 4 > table->capacity * 3) {
+    grow_string_table(table);
+  }
+
+  for(slot = hash & (table->capacity - 1); table->slots[slot]; slot = (slot + 1) & (table->capacity - 1)) {
+    header = string_header_of(table->slots[slot]);
+
+    if(header->hash == hash && header->length == length && !memcmp(header->characters, characters, length)) {
+      return header->characters;
+    }
+  }
+
+  header = allocate_string(length);
+  header->length = length;
+  header->capacity = 0;
+  header->hash = hash;
+  memcpy(header->characters, characters, length);
+  header->characters[length] = '\0';
+
+  table->slots[slot] = header->characters;
+  table->count++;
+  return header->characters;
+}
+
+// Function to append a string to another, reusing the buffer of the first one when it can grow
+struct val concatenate_strings(struct val first, struct val second) {
+  struct string_header *header = string_header_of(first.datavalue.string);
+  struct val result = first;
+  size_t length = (size_t)first.length + second.length;
+
+  result.length = length;
+
+  // Appending to the longest string of a buffer leaves every shorter string of it unchanged
+  if(header->capacity && header->length == first.length && length <= header->capacity) {
+    memcpy(header->characters + first.length, second.datavalue.string, second.length);
+    header->characters[length] = '\0';
+    header->length = length;
+    return result;
+  }
+
+  // A new buffer leaves room to double, so building a string one piece at a time stays linear
+  header = allocate_string(length * 2 + 16);
+  header->length = length;
+  header->capacity = length * 2 + 16;
+  header->hash = 0;
+  memcpy(header->characters, first.datavalue.string, first.length);
+  memcpy(header->characters + first.length, second.datavalue.string, second.length);
+  header->characters[length] = '\0';
+
+  result.datavalue.string = header->characters;
+  return result;
+}
+
+// Function to check if two strings have the same characters
+int strings_equal(struct val first, struct val second) {
+  if(first.length != second.length) {
+    return 0;
+  }
+
+  if(first.datavalue.string == second.datavalue.string) {
+    return 1;
+  }
+
+  // Equal interned strings are always the same copy
+  if(!string_header_of(first.datavalue.string)->capacity && !string_header_of(second.datavalue.string)->capacity) {
+    return 0;
+  }
+
+  return !memcmp(first.datavalue.string, second.datavalue.string, first.length);
+}
+
+// Function to compare two strings, with the result strcmp() gives
+int compare_strings(struct val first, struct val second) {
+  size_t length = first.length < second.length ? first.length : second.length;
+  unsigned char *a = (unsigned char *)first.datavalue.string;
+  unsigned char *b = (unsigned char *)second.datavalue.string;
+
+  for(size_t i = 0; i < length; i++) {
+    if(a[i] != b[i]) {
+      return a[i] - b[i];
+    }
+  }
+
+  if(first.length == second.length) {
+    return 0;
+  }
+
+  return first.length > second.length ? a[length] : -b[length];
+}
+
+// Function to free the set of interned strings, the strings themselves belong to the heap
+void free_string_table(struct string_table *table) {
+  free(table->slots);
+  table->slots = NULL;
+  table->capacity = 0;
+  table->count = 0;
+}
@@ -0,0 +1,44 @@
+#ifndef STRING_TABLE_H
+#define STRING_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Structure in front of the characters of every string value, allocated on the heap of the interpreter.
+// Interned strings never change. Other strings are buffers that grow in place when the
+// longest string using them is appended to, shorter strings keep their own length.
+struct string_header {
+  uint32_t length;              // characters in use, the length of the longest string of the buffer
+  uint32_t capacity;            // characters the buffer has room for, 0 for interned strings
+  uint32_t hash;                // hash of an interned string
+  char characters[];
+};
+
+// Structure for the strings of one interpreter
+struct string_table {
+  char **slots;                 // open addressing set of the interned strings
+  size_t capacity;
+  size_t count;
+};
+
+struct val;
+
+// Function to get the header in front of the characters of a string
+struct string_header *string_header_of(char *characters);
+
+// Function to get the single copy of a string constant, equal strings get the same pointer
+char *intern_string(const char *characters, size_t length);
+
+// Function to append a string to another, reusing the buffer of the first one when it can grow
+struct val concatenate_strings(struct val first, struct val second);
+
+// Function to check if two strings have the same characters
+int strings_equal(struct val first, struct val second);
+
+// Function to compare two strings, with the result strcmp() gives
+int compare_strings(struct val first, struct val second);
+
+// Function to free the set of interned strings, the strings themselves belong to the heap
+void free_string_table(struct string_table *table);
+
+#endif
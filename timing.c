@@ -0,0 +1,164 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include <stdio.h>
+#include <limits.h>
+#include <time.h>
+
+#include "learnpi.h"
+#include "gpio_batch.h"
+#include "timing.h"
+#include "backend.h"
+
+int timing_stats = 0;
+
+// Function to read the time since the current script started in microseconds
+uint64_t script_time_us() {
+  return gpio_backend->now_us();
+}
+
+// Function to count a sleep in the bucket of the latency histogram its wake up falls in
+static void record_latency(uint64_t latency_us) {
+  struct script_timing *timing = &current_context->timing;
+  int bucket = 0;
+
+  while(latency_us && bucket < LATENCY_BUCKETS - 1) {
+    latency_us >>= 1;
+    bucket++;
+  }
+
+  timing->latency[bucket]++;
+  timing->sleeps++;
+}
+
+// Function to sleep until a time of the script clock, returns at once if it has passed
+static void sleep_until_us(uint64_t deadline_us) {
+  uint64_t wake_us = 0;
+
+  // The simulation backend moves the virtual clock to the deadline instead
+  gpio_backend->sleep_until(deadline_us);
+
+  wake_us = script_time_us();
+  record_latency(wake_us > deadline_us ? wake_us - deadline_us : 0);
+}
+
+// Function to wait a number of microseconds after writing the queued levels
+void delay_us(uint64_t us) {
+  flush_gpio_writes();
+  sleep_until_us(script_time_us() + us);
+}
+
+// Function to wait until a deadline of the script clock after writing the queued levels, returns how late it woke up.
+// Deadlines are compared the way pigpio compares ticks, so they may wrap around 32 bits.
+int delay_until_us(uint32_t deadline_us) {
+  struct script_timing *timing = &current_context->timing;
+  uint64_t now_us = 0;
+  uint64_t wake_us = 0;
+  uint64_t lateness_us = 0;
+  uint64_t period_error_us = 0;
+  int64_t period_us = 0;
+  int64_t target_us = 0;
+  int32_t remaining_us = 0;
+
+  flush_gpio_writes();
+
+  now_us = script_time_us();
+  remaining_us = (int32_t)(deadline_us - (uint32_t)now_us);
+  target_us = (int64_t)now_us + remaining_us;
+
+  if(remaining_us > 0) {
+    sleep_until_us(target_us);
+  } else {
+    timing->missed++;
+  }
+
+  wake_us = script_time_us();
+  lateness_us = target_us > 0 ? wake_us - target_us : wake_us;
+
+  // The period is the time since the last deadline woke up, compared with the distance between the two deadlines
+  if(timing->deadlines) {
+    period_us = (int64_t)(wake_us - timing->last_wake_us) - (int32_t)(deadline_us - timing->last_deadline_us);
+    period_error_us = period_us < 0 ? -period_us : period_us;
+
+    timing->period_error_sum_us += period_error_us;
+    if(period_error_us > timing->period_error_max_us) {
+      timing->period_error_max_us = period_error_us;
+    }
+  }
+
+  timing->lateness_sum_us += lateness_us;
+  if(lateness_us > timing->lateness_max_us) {
+    timing->lateness_max_us = lateness_us;
+  }
+
+  timing->deadlines++;
+  timing->last_deadline_us = deadline_us;
+  timing->last_wake_us = wake_us;
+
+  return lateness_us > INT_MAX ? INT_MAX : (int)lateness_us;
+}
+
+// Function to give the latency under which a share of the sleeps in the histogram woke up, in microseconds
+static uint64_t latency_percentile(struct script_timing *timing, double share) {
+  uint64_t wanted = timing->sleeps * share;
+  uint64_t seen = 0;
+
+  for(int i = 0; i < LATENCY_BUCKETS - 1; i++) {
+    seen += timing->latency[i];
+
+    if(seen > wanted) {
+      return 1ULL << i;
+    }
+  }
+
+  return 1ULL << (LATENCY_BUCKETS - 2);
+}
+
+// Function to print how well the current script kept its deadlines and how late its sleeps woke up
+void print_timing_stats() {
+  struct script_timing *timing = &current_context->timing;
+  char label[32];
+
+  if(!timing->deadlines) {
+    fprintf(stderr, "Timing: no deadlines.\n");
+  } else {
+    fprintf(stderr, "Timing: %llu deadlines, %llu missed, %.1f us late on average, %llu us at most",
+      (unsigned long long)timing->deadlines, (unsigned long long)timing->missed,
+      (double)timing->lateness_sum_us / timing->deadlines, (unsigned long long)timing->lateness_max_us);
+
+    if(timing->deadlines > 1) {
+      fprintf(stderr, ", period jitter %.1f us on average, %llu us at most",
+        (double)timing->period_error_sum_us / (timing->deadlines - 1), (unsigned long long)timing->period_error_max_us);
+    }
+
+    fprintf(stderr, "\n");
+  }
+
+  if(!timing->sleeps) {
+    return;
+  }
+
+  // A bucket is printed as the range of latencies it holds, the last one has no end
+  fprintf(stderr, "Wake up latency of %llu sleeps, 50%% under %llu us, 99%% under %llu us:\n",
+    (unsigned long long)timing->sleeps, (unsigned long long)latency_percentile(timing, 0.5),
+    (unsigned long long)latency_percentile(timing, 0.99));
+
+  for(int i = 0; i < LATENCY_BUCKETS; i++) {
+    if(!timing->latency[i]) {
+      continue;
+    }
+
+    if(i == 0) {
+      snprintf(label, sizeof(label), "< 1 us");
+    } else if(i == LATENCY_BUCKETS - 1) {
+      snprintf(label, sizeof(label), ">= %llu us", 1ULL << (i - 1));
+    } else if(i == 1) {
+      snprintf(label, sizeof(label), "1 us");
+    } else {
+      snprintf(label, sizeof(label), "%llu - %llu us", 1ULL << (i - 1), (1ULL << i) - 1);
+    }
+
+    fprintf(stderr, "  %-20s %10llu\n", label, (unsigned long long)timing->latency[i]);
+  }
+}
@@ -0,0 +1,41 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Buckets of the wake up latency histogram, the first holds latencies under 1 us and each next one doubles the range
+#define LATENCY_BUCKETS 20
+
+// Structure for the clock of one script and the deadlines it waited for with delay_until
+struct script_timing {
+  struct timespec started;         // start of the script clock, the simulation backend uses its virtual clock
+  uint64_t deadlines;
+  uint64_t missed;                 // deadlines that had passed when delay_until was called
+  uint32_t last_deadline_us;
+  uint64_t last_wake_us;
+  uint64_t lateness_sum_us;        // time between each deadline and the wake up that followed it
+  uint64_t lateness_max_us;
+  uint64_t period_error_sum_us;    // difference between the periods asked for and the ones achieved
+  uint64_t period_error_max_us;
+  uint64_t sleeps;                 // delays and deadlines that slept, late or not
+  uint64_t latency[LATENCY_BUCKETS];   // sleeps by how long after their end they woke up, see LATENCY_BUCKETS
+};
+
+// Function to read the time since the current script started in microseconds
+uint64_t script_time_us();
+
+// Function to wait a number of microseconds after writing the queued levels
+void delay_us(uint64_t us);
+
+// Function to wait until a deadline of the script clock after writing the queued levels, returns how late it woke up.
+// Deadlines are compared the way pigpio compares ticks, so they may wrap around 32 bits.
+int delay_until_us(uint32_t deadline_us);
+
+// Function to print how well the current script kept its deadlines and how late its sleeps woke up
+void print_timing_stats();
+
+// Set with --timing to report the deadlines of every script
+extern int timing_stats;
+
+#endif
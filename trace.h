@@ -0,0 +1,27 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Trace levels, a higher level is more verbose
+#define TRACE_NONE  0
+#define TRACE_INFO  1 // device creation and other rare events
+#define TRACE_DEBUG 2 // interpreter internals, printed on every call
+
+// Highest level compiled into the binary, calls above it are removed entirely
+#ifndef LEARNPI_TRACE_LEVEL
+#define LEARNPI_TRACE_LEVEL TRACE_INFO
+#endif
+
+// Level selected at run time with --trace, no tracing by default
+extern int trace_level;
+
+// Function to print a trace message to stderr
+void trace_print(char *s, ...);
+
+#define trace(level, ...) \
+  do { \
+    if((level) <= LEARNPI_TRACE_LEVEL && (level) <= trace_level) { \
+      trace_print(__VA_ARGS__); \
+    } \
+  } while(0)
+
+#endif
@@ -13,11 +13,18 @@ enum built_in_function_types {
   BUILT_IN_MOVE_SERVO_TO_ANGLE,
   BUILT_IN_MOVE_SERVO_INFINITELY,
   BUILT_IN_SERVO_STOP,
-  BUILT_IN_DELAY
+  BUILT_IN_DELAY,
+  BUILT_IN_WAIT_FOR_PRESS,
+  BUILT_IN_WRITE_GROUP,
+  BUILT_IN_DELAY_UNTIL,
+  BUILT_IN_PLAY_PATTERN,
+  BUILT_IN_STOP_PATTERN,
+  BUILT_IN_WAIT_FOR_KEY
 };
 
-// Primitive and composed types
+// Primitive and composed types, NO_TYPE marks an empty value
 enum type {
+    NO_TYPE = -1,
     BIT_TYPE,
     INTEGER_TYPE,
     DECIMAL_TYPE,
@@ -0,0 +1,261 @@
+// Decoder of record files, built on its own by make vcd with -DLEARNPI_VCD
+#ifdef LEARNPI_VCD
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "record.h"
+
+// Gpios a record can hold, the same as the interpreter drives
+#define VCD_GPIOS 54
+
+// Structure for a recorded call and its place in the ring, so calls made at the same time keep their order
+struct timed_entry {
+  uint64_t time_ns;
+  uint64_t index;
+  uint32_t value;
+  uint8_t gpio;
+  uint8_t operation;
+};
+
+// Identifier of every signal, -1 until a call uses it
+static int level_signals[VCD_GPIOS];
+static int servo_signals[VCD_GPIOS];
+static int delay_signal = -1;
+static int signal_count = 0;
+
+// Function to order the calls by time, then by the order they were written in
+static int compare_entries(const void *first, const void *second) {
+  const struct timed_entry *a = first;
+  const struct timed_entry *b = second;
+
+  if(a->time_ns != b->time_ns) {
+    return a->time_ns < b->time_ns ? -1 : 1;
+  }
+
+  return a->index < b->index ? -1 : a->index > b->index;
+}
+
+// Function to write the identifier code of a signal, printable characters from ! to ~
+static void write_code(FILE *output, int signal) {
+  do {
+    fputc('!' + signal % 94, output);
+    signal /= 94;
+  } while(signal);
+}
+
+// Function to give a signal an identifier the first time a call uses it
+static void use_signal(int *signal) {
+  if(*signal < 0) {
+    *signal = signal_count++;
+  }
+}
+
+// Function to write a 32 bit value of a signal in binary, without leading zeros
+static void write_vector(FILE *output, uint32_t value, int signal) {
+  int bit = 31;
+
+  fputc('b', output);
+
+  while(bit > 0 && !(value >> bit & 1)) {
+    bit--;
+  }
+
+  for(; bit >= 0; bit--) {
+    fputc('0' + (value >> bit & 1), output);
+  }
+
+  fputc(' ', output);
+  write_code(output, signal);
+  fputc('\n', output);
+}
+
+// Function to write the declarations of the signals the calls use
+static void write_header(FILE *output, const char *path) {
+  fprintf(output, "$comment learnpi record %s $end\n", path);
+  fprintf(output, "$timescale 1ns $end\n");
+  fprintf(output, "$scope module learnpi $end\n");
+
+  for(int gpio = 0; gpio < VCD_GPIOS; gpio++) {
+    if(level_signals[gpio] >= 0) {
+      fprintf(output, "$var wire 1 ");
+      write_code(output, level_signals[gpio]);
+      fprintf(output, " gpio%d $end\n", gpio);
+    }
+  }
+
+  for(int gpio = 0; gpio < VCD_GPIOS; gpio++) {
+    if(servo_signals[gpio] >= 0) {
+      fprintf(output, "$var integer 32 ");
+      write_code(output, servo_signals[gpio]);
+      fprintf(output, " servo%d_us $end\n", gpio);
+    }
+  }
+
+  if(delay_signal >= 0) {
+    fprintf(output, "$var integer 32 ");
+    write_code(output, delay_signal);
+    fprintf(output, " delay_us $end\n");
+  }
+
+  fprintf(output, "$upscope $end\n$enddefinitions $end\n");
+}
+
+// Function to write a call as a value change, calls that change no signal are left out
+static void write_change(FILE *output, struct timed_entry *entry) {
+  switch(entry->operation) {
+    case RECORD_WRITE:
+    case RECORD_READ:
+      fprintf(output, "%c", entry->value ? '1' : '0');
+      write_code(output, level_signals[entry->gpio]);
+      fputc('\n', output);
+      break;
+
+    case RECORD_SERVO:
+      write_vector(output, entry->value, servo_signals[entry->gpio]);
+      break;
+
+    case RECORD_DELAY:
+      write_vector(output, entry->value, delay_signal);
+      break;
+  }
+}
+
+// Function to take the calls still in the ring of a record, oldest first, returns how many there are
+static size_t read_entries(struct record_header *header, struct timed_entry **entries) {
+  struct record_entry *ring = (struct record_entry *)(header + 1);
+  struct record_entry *entry = NULL;
+  uint64_t head = atomic_load(&header->head);
+  uint64_t first = head > header->capacity ? head - header->capacity : 0;
+  size_t count = 0;
+
+  *entries = malloc((head - first + 1) * sizeof(struct timed_entry));
+
+  if(!*entries) {
+    fprintf(stderr, "out of space\n");
+    exit(1);
+  }
+
+  for(uint64_t i = first; i < head; i++) {
+    entry = &ring[i & (header->capacity - 1)];
+
+    // An entry of another lap, or one never finished, was being written when the record ended
+    if(atomic_load(&entry->lap) != (uint16_t)(i / header->capacity) || !entry->operation || entry->gpio >= VCD_GPIOS) {
+      continue;
+    }
+
+    (*entries)[count].time_ns = entry->time_ns;
+    (*entries)[count].index = i;
+    (*entries)[count].value = entry->value;
+    (*entries)[count].gpio = entry->gpio;
+    (*entries)[count].operation = entry->operation;
+    count++;
+  }
+
+  fprintf(stderr, "%zu calls, %llu overwritten, %llu torn.\n", count,
+    (unsigned long long)first, (unsigned long long)(head - first - count));
+
+  return count;
+}
+
+int main(int argc, char **argv) {
+  struct record_header *header = NULL;
+  struct timed_entry *entries = NULL;
+  struct stat status;
+  FILE *output = stdout;
+  uint64_t last_ns = 0;
+  size_t count = 0;
+  int written = 0;
+  int file = -1;
+
+  if(argc < 2 || argc > 3) {
+    fprintf(stderr, "Usage: %s learnpi.record [output.vcd]\n", argv[0]);
+    return 1;
+  }
+
+  file = open(argv[1], O_RDONLY);
+
+  if(file < 0 || fstat(file, &status) != 0) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  header = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+  close(file);
+
+  if(header == MAP_FAILED) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  if((size_t)status.st_size < sizeof(struct record_header) || memcmp(header->magic, RECORD_MAGIC, sizeof(RECORD_MAGIC)) ||
+      header->entry_size != sizeof(struct record_entry) || !header->capacity || header->capacity & (header->capacity - 1) ||
+      (size_t)status.st_size < sizeof(struct record_header) + (size_t)header->capacity * sizeof(struct record_entry)) {
+    fprintf(stderr, "%s is not a learnpi record.\n", argv[1]);
+    return 1;
+  }
+
+  count = read_entries(header, &entries);
+  qsort(entries, count, sizeof(struct timed_entry), compare_entries);
+
+  for(int gpio = 0; gpio < VCD_GPIOS; gpio++) {
+    level_signals[gpio] = -1;
+    servo_signals[gpio] = -1;
+  }
+
+  for(size_t i = 0; i < count; i++) {
+    if(entries[i].operation == RECORD_WRITE || entries[i].operation == RECORD_READ) {
+      use_signal(&level_signals[entries[i].gpio]);
+    } else if(entries[i].operation == RECORD_SERVO) {
+      use_signal(&servo_signals[entries[i].gpio]);
+    } else if(entries[i].operation == RECORD_DELAY) {
+      use_signal(&delay_signal);
+    }
+  }
+
+  if(argc == 3) {
+    output = fopen(argv[2], "w");
+
+    if(!output) {
+      perror(argv[2]);
+      return 1;
+    }
+  }
+
+  write_header(output, argv[1]);
+
+  // Times start at the first call, every time is written once before the changes at it
+  for(size_t i = 0; i < count; i++) {
+    if(entries[i].operation != RECORD_WRITE && entries[i].operation != RECORD_READ &&
+        entries[i].operation != RECORD_SERVO && entries[i].operation != RECORD_DELAY) {
+      continue;
+    }
+
+    if(!written || entries[i].time_ns != last_ns) {
+      fprintf(output, "#%llu\n", (unsigned long long)(entries[i].time_ns - entries[0].time_ns));
+      last_ns = entries[i].time_ns;
+      written = 1;
+    }
+
+    write_change(output, &entries[i]);
+  }
+
+  if(output != stdout) {
+    fclose(output);
+  }
+
+  free(entries);
+  munmap(header, status.st_size);
+  return 0;
+}
+
+#endif
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "learnpi.h"
+#include "gpio_batch.h"
+#include "backend.h"
+#include "wave.h"
+
+// Interpreter whose pattern the waveform transmitter was last given, NULL if none
+static struct interpreter_context *pattern_owner = NULL;
+static pthread_mutex_t pattern_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Function to stop sending the pattern of the current interpreter and forget it, the caller holds the pattern lock
+static void end_pattern(struct pattern_playback *pattern) {
+  if(pattern_owner == current_context) {
+    gpio_backend->wave_stop();
+  }
+
+  if(pattern->wave_id >= 0) {
+    gpio_backend->wave_delete(pattern->wave_id);
+  }
+
+  if(pattern_owner == current_context) {
+    pattern_owner = NULL;
+  }
+
+  pattern->active = 0;
+  pattern->wave_id = -1;
+}
+
+// Function to play on and off times on a gpio, repeats times or forever if repeats is 0, the script continues while it plays.
+// The caller checks there are pairs of times, at most MAX_PATTERN_STEPS, and at most MAX_PATTERN_REPEATS repeats.
+// Returns 0 if OK, PATTERN_BUSY or a pigpio error.
+int play_pattern(unsigned gpio, const uint32_t *steps, int step_count, int repeats) {
+  struct pattern_playback *pattern = &current_context->pattern;
+  int busy = 0;
+  int status = 0;
+
+  // Waveforms switch gpios of bank 1 only
+  if(gpio > 31) {
+    return PI_BAD_USER_GPIO;
+  }
+
+  // Levels written before the pattern reach the pin first
+  flush_gpio_writes();
+
+  pthread_mutex_lock(&pattern_lock);
+
+  // A pattern of another script that is still playing keeps the transmitter
+  if(pattern_owner && pattern_owner != current_context) {
+    busy = gpio_backend->wave_busy();
+  }
+
+  if(busy) {
+    pthread_mutex_unlock(&pattern_lock);
+    return PATTERN_BUSY;
+  }
+
+  if(pattern->active) {
+    render_pattern(virtual_time_us());
+    end_pattern(pattern);
+  }
+
+  pattern->gpio = gpio;
+  memcpy(pattern->steps, steps, step_count * sizeof(uint32_t));
+  pattern->step_count = step_count;
+  pattern->repeats = repeats;
+  pattern->wave_id = -1;
+  pattern->started_us = virtual_time_us();
+  pattern->period_us = 0;
+  pattern->rendered = 0;
+  pattern->next_edge_us = pattern->started_us;
+
+  for(int i = 0; i < step_count; i++) {
+    pattern->period_us += steps[i];
+  }
+
+  // pigpio sends the pattern as a waveform, the simulation backend draws it as the virtual clock moves
+  status = gpio_backend->wave_send(pattern);
+
+  if(status < 0) {
+    pthread_mutex_unlock(&pattern_lock);
+    return status;
+  }
+
+  pattern->wave_id = status;
+  status = 0;
+
+  pattern->active = 1;
+  pattern_owner = current_context;
+  pthread_mutex_unlock(&pattern_lock);
+
+  return status;
+}
+
+// Function to stop the pattern of the current interpreter and turn its gpio off
+void stop_pattern() {
+  struct pattern_playback *pattern = &current_context->pattern;
+
+  if(!pattern->active) {
+    return;
+  }
+
+  // The simulated timeline gets the edges up to now before the pattern is cut
+  render_pattern(virtual_time_us());
+
+  pthread_mutex_lock(&pattern_lock);
+
+  if(pattern->active) {
+    end_pattern(pattern);
+    queue_gpio_write(pattern->gpio, 0);
+  }
+
+  pthread_mutex_unlock(&pattern_lock);
+  flush_gpio_writes();
+}
+
+// Function to let a pattern that repeats a number of times play out at the end of a script, one that plays forever is stopped
+void finish_pattern() {
+  struct pattern_playback *pattern = &current_context->pattern;
+
+  if(!pattern->active || pattern->repeats == 0) {
+    stop_pattern();
+    return;
+  }
+
+  if(gpio_backend->simulated) {
+    // The virtual clock runs to the end of the last repeat, drawing the edges on the way
+    uint64_t end_us = pattern->started_us + pattern->period_us * pattern->repeats;
+
+    if(end_us > virtual_time_us()) {
+      advance_virtual_time(end_us - virtual_time_us());
+    }
+  } else {
+    while(pattern_owner == current_context && gpio_backend->wave_busy()) {
+      gpio_backend->delay(1000);
+    }
+  }
+
+  pthread_mutex_lock(&pattern_lock);
+
+  if(pattern->active) {
+    end_pattern(pattern);
+  }
+
+  pthread_mutex_unlock(&pattern_lock);
+}
+
+// Function to find the virtual time of the next edge of the pattern of the current interpreter, UINT64_MAX if there is none
+uint64_t next_pattern_edge_us() {
+  struct pattern_playback *pattern = &current_context->pattern;
+
+  // A pattern that repeats a number of times ends low after the off time of its last repeat
+  if(!pattern->active || !gpio_backend->simulated || (pattern->repeats && pattern->rendered >= (uint64_t)pattern->repeats * pattern->step_count)) {
+    return UINT64_MAX;
+  }
+
+  return pattern->next_edge_us;
+}
+
+// Function to write the edges of the pattern up to a virtual time through the simulated backend, so traces and records show them
+void render_pattern(uint64_t until_us) {
+  struct pattern_playback *pattern = &current_context->pattern;
+  int step = 0;
+
+  while(next_pattern_edge_us() <= until_us) {
+    step = pattern->rendered % pattern->step_count;
+
+    gpio_backend->write(pattern->gpio, step % 2 ? 0 : 1);
+    pattern->next_edge_us += pattern->steps[step];
+    pattern->rendered++;
+  }
+}
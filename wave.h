@@ -0,0 +1,44 @@
+#ifndef WAVE_H
+#define WAVE_H
+
+#include <stdint.h>
+
+// Most times a pattern can have, a pigpio waveform holds one pulse per time
+#define MAX_PATTERN_STEPS 1024
+// Most repeats of a pattern, pigpio chains count loops in 16 bits
+#define MAX_PATTERN_REPEATS 65535
+// Returned by play_pattern when a pattern of another script is playing, pigpio has one waveform transmitter
+#define PATTERN_BUSY -1000
+
+// Structure for the pattern an interpreter is playing on one gpio, times alternate between on and off
+struct pattern_playback {
+  int active;
+  unsigned gpio;
+  uint32_t steps[MAX_PATTERN_STEPS];
+  int step_count;
+  int repeats;                     // 0 plays the pattern until it is stopped
+  int wave_id;                     // pigpio waveform on the Pi, -1 if none
+  uint64_t started_us;             // virtual time the pattern started at with the simulation backend
+  uint64_t period_us;              // sum of the times
+  uint64_t rendered;               // edges of the pattern already written to the virtual timeline
+  uint64_t next_edge_us;           // virtual time of the first edge not written yet
+};
+
+// Function to play on and off times on a gpio, repeats times or forever if repeats is 0, the script continues while it plays.
+// The caller checks there are pairs of times, at most MAX_PATTERN_STEPS, and at most MAX_PATTERN_REPEATS repeats.
+// Returns 0 if OK, PATTERN_BUSY or a pigpio error.
+int play_pattern(unsigned gpio, const uint32_t *steps, int step_count, int repeats);
+
+// Function to stop the pattern of the current interpreter and turn its gpio off
+void stop_pattern();
+
+// Function to let a pattern that repeats a number of times play out at the end of a script, one that plays forever is stopped
+void finish_pattern();
+
+// Function to find the virtual time of the next edge of the pattern of the current interpreter, UINT64_MAX if there is none
+uint64_t next_pattern_edge_us();
+
+// Function to write the edges of the pattern up to a virtual time through the simulated backend, so traces and records show them
+void render_pattern(uint64_t until_us);
+
+#endif